@@ -1,6 +1,8 @@
 #ifndef _H_TIRAMISU_AUTO_SCHEDULER_AST_
 #define _H_TIRAMISU_AUTO_SCHEDULER_AST_
 
+#include <memory>
+
 #include <tiramisu/core.h>
 #include "utils.h"
 #include "optimization_info.h"
@@ -101,10 +103,22 @@ public:
      */
     bool unrolled = false;
 
+    /**
+     * True if this loop level has been parallelized.
+     */
+    bool parallelized = false;
+
+    /**
+     * True if this loop level has been vectorized.
+     */
+    bool vectorized = false;
+
     /**
      * List of the computations computed at this level.
+     * The information about a computation doesn't change when the AST is transformed,
+     * so it is shared by all the copies of the AST.
      */
-    std::vector<computation_info> computations;
+    std::vector<std::shared_ptr<const computation_info>> computations;
 
 	/**
 	 * Next loop levels.
@@ -200,6 +214,12 @@ public:
      * and only one child.
      */
     int get_loop_levels_chain_depth() const;
+    
+    /**
+     * Append to str a representation of the loop structure of the subtree
+     * rooted at this node (names, bounds, tags and computations).
+     */
+    void get_structure_str(std::string& str) const;
 
     /**
      * Print the subtree rooted at this node.
@@ -215,6 +235,18 @@ private:
      * with the command "after".
      */
     void order_computations();
+    
+    /**
+     * The last fingerprint computed by get_fingerprint(), and the number of optimizations
+     * of the AST at that time (-1 if the fingerprint must be recomputed).
+     */
+    mutable uint64_t fingerprint = 0;
+    mutable int fingerprint_nb_optims = -1;
+    
+    /**
+     * Return a hash of the program represented by the function fct.
+     */
+    static uint64_t get_program_fingerprint(tiramisu::function *fct);
 
 protected:
 
@@ -224,6 +256,11 @@ public:
      */
     tiramisu::function *fct;
     
+    /**
+     * The values given to the parameters of the function to get the loop bounds of the AST.
+     */
+    parameters_values params;
+    
     /**
       * AST root nodes.
       */
@@ -255,6 +292,12 @@ public:
      */
     float evaluation;
     
+    /**
+     * The half-width of the confidence interval of the evaluation
+     * (0 if the evaluation function is not noisy).
+     */
+    float evaluation_ci = 0;
+    
     /**
      * The depth of this AST in a search method.
      * Used to keep track of the depth reached by a search method.
@@ -280,14 +323,23 @@ public:
     /**
      * The iterators in JSON format.
      * Use by the class evaluate_by_learning_model.
+     * The iterators don't change when the AST is transformed, so the JSON is shared by all the copies of the AST.
      */
-    std::string iterators_json;
+    std::shared_ptr<const std::string> iterators_json;
     
     /**
      * The structure represented by this AST in JSON format.
      * Use by the class evaluate_by_learning_model.
      */
     std::string tree_structure_json;
+    
+    /**
+     * A hash of the program represented by this AST : the expressions of its computations,
+     * their domains and accesses, and the types and sizes of its buffers.
+     * It is part of the fingerprint, so that schedules of a modified program
+     * are not mistaken for schedules of the original one.
+     */
+    uint64_t program_fingerprint = 0;
         
     /**
      * Create an empty AST.
@@ -296,8 +348,10 @@ public:
     
     /**
      * Create an AST from the given function.
+     * If the loop bounds of the function are symbolic, params gives a value
+     * to the parameters that are not fixed by the context of the function.
      */
-    syntax_tree(tiramisu::function *fct);
+    syntax_tree(tiramisu::function *fct, parameters_values const& params = parameters_values());
     
     ~syntax_tree()
     {
@@ -325,6 +379,16 @@ public:
     void transform_ast_by_tiling(optimization_info const& opt);
     void transform_ast_by_interchange(optimization_info const& opt);
     void transform_ast_by_unrolling(optimization_info const& opt);
+    void transform_ast_by_parallelism(optimization_info const& opt);
+    void transform_ast_by_vectorization(optimization_info const& opt);
+    void transform_ast_by_compute_at(optimization_info const& opt);
+    
+    /**
+     * Apply the given optimizations to this AST, and add them to previous_optims.
+     * The node of each optimization is found in this AST from its computations and its loop levels,
+     * so the optimizations can come from an AST of the same function built with other parameters values.
+     */
+    void replay_optimizations(std::vector<optimization_info> const& optims);
     
     /**
      * Copy this AST, and return the copy.
@@ -352,6 +416,21 @@ public:
      */
     std::vector<optimization_info> get_schedule() const;
     
+    /**
+     * Return a canonical representation of the schedule of this AST :
+     * its loop structure, followed by its list of optimizations.
+     * Two ASTs reached by different paths of a search method have the same
+     * representation if they have the same schedule.
+     */
+    std::string get_schedule_str() const;
+    
+    /**
+     * Return a hash of program_fingerprint and of get_schedule_str().
+     * The fingerprint is computed once, and again after the AST is transformed
+     * or its list of optimizations changes.
+     */
+    uint64_t get_fingerprint() const;
+    
     /**
      * Add the content of new_optims to previous_optims and
      * clear new_optims.
@@ -11,6 +11,8 @@ namespace tiramisu::auto_scheduler
 
 class evaluation_function;
 class search_method;
+class search_checkpoint;
+class search_telemetry;
 
 /**
   * The core class for the autoscheduler.
@@ -54,14 +56,31 @@ protected:
      * It is measured using "exec_evaluator".
      */
     float initial_exec_time;
+    
+    /**
+     * If not null, the search is checkpointed to this object, and resumed from it.
+     */
+    search_checkpoint *checkpoint = nullptr;
+    
+    /**
+     * If not null, the schedules evaluated by the search are recorded to this object.
+     */
+    search_telemetry *telemetry = nullptr;
         
 public:
     /**
      * Create an autoscheduler with the given search method and the given evaluation function
      * for the given program.
+     *
+     * If the loop bounds of the program are symbolic, params gives the size for which the
+     * program is optimized (parameters fixed by the context of the program don't need a value).
+     * To optimize for a distribution of sizes, use evaluate_over_sizes as the evaluation function.
+     * To get a variant of the schedule for each size class, create an autoscheduler for each
+     * class, and save the best schedule of each to the same file with save_best_schedule().
      */
     auto_scheduler(search_method *searcher, evaluation_function *eval_func,
-                   tiramisu::function *fct = tiramisu::global::get_implicit_function());
+                   tiramisu::function *fct = tiramisu::global::get_implicit_function(),
+                   parameters_values const& params = parameters_values());
               
     /**
      * If you want the autoscheduler to measure the speedup of the final optimizations,
@@ -70,6 +89,24 @@ public:
      */     
     void set_exec_evaluator(evaluate_by_execution *exec_evaluator) { this->exec_evaluator = exec_evaluator; }
     
+    ~auto_scheduler();
+    
+    /**
+     * Save the state of the search to the directory checkpoint_dir every save_interval seconds.
+     * If the directory contains the checkpoint of an interrupted search, find_schedule() resumes it :
+     * the schedules evaluated or executed before the interruption are not evaluated again.
+     * See search_checkpoint for the content of the directory.
+     */
+    void set_checkpoint(std::string const& checkpoint_dir, double save_interval = 60);
+    
+    /**
+     * Record every schedule evaluated by the search to the file trace_path, one JSON object per line
+     * (see search_telemetry), and print a summary of the phases and of the best value at the end
+     * of find_schedule(). If set_checkpoint() was called before and resumed a search,
+     * the new schedules are appended to the file.
+     */
+    void set_telemetry(std::string const& trace_path);
+    
     /**
      * Use the search method to find a set of optimizations.
      */
@@ -80,6 +117,18 @@ public:
      * find_schedule().
      */
     void apply_best_schedule();
+    
+    /**
+     * Apply the schedule found by find_schedule() to the program, and append it
+     * to the given schedules file (see tiramisu::function::save_schedule()).
+     * The schedule can then be used with codegen_select_schedule_number(),
+     * without running the search again.
+     *
+     * Return the number of the schedule in the file, or -1 if it can't be saved.
+     * If the schedule uses compute_at, the computations it adds stay in the program,
+     * so the best schedule of another autoscheduler can't be saved afterwards.
+     */
+    int save_best_schedule(std::string const& path_name);
 };
 
 }
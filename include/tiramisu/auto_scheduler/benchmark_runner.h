@@ -0,0 +1,191 @@
+#ifndef _TIRAMISU_AUTO_SCHEDULER_BENCHMARK_RUNNER_
+#define _TIRAMISU_AUTO_SCHEDULER_BENCHMARK_RUNNER_
+
+#include <sys/types.h>
+#include <cfloat>
+#include <tiramisu/core.h>
+
+namespace tiramisu::auto_scheduler
+{
+
+const int DEFAULT_NB_EXEC = 10;
+const int DEFAULT_NB_WARMUP = 2;
+const int DEFAULT_MAX_NB_EXEC = 100;
+const double DEFAULT_TARGET_PRECISION = 0.02;
+const int DEFAULT_CACHE_FLUSH_SIZE = 64 * 1024 * 1024;
+
+/**
+ * Time in seconds given to a runner, in addition to its time limit,
+ * to load a schedule and to answer.
+ */
+const double TIMEOUT_SLACK = 1;
+
+/**
+ * Statistics about the execution times of a schedule, in milliseconds.
+ * [ci_low, ci_high] is a 95% confidence interval of the mean execution time.
+ */
+struct timing_stats
+{
+    float mean = FLT_MAX;
+    float median = FLT_MAX;
+    float ci_low = FLT_MAX;
+    float ci_high = FLT_MAX;
+    
+    /**
+     * The number of timed executions.
+     */
+    int nb_runs = 0;
+    
+    /**
+     * True if the execution was stopped because it exceeded its time limit.
+     * In this case, median is a lower bound of the execution time.
+     */
+    bool timed_out = false;
+    
+    /**
+     * Return the half-width of the confidence interval.
+     */
+    float get_ci_half_width() const
+    {
+        if (nb_runs == 0)
+            return 0;
+            
+        return (ci_high - ci_low) / 2;
+    }
+};
+
+/**
+ * A long-lived process used to measure the execution time of schedules.
+ *
+ * The runner allocates and initializes the buffers of the program once.
+ * Then, for each schedule to measure, it loads the shared library containing
+ * the compiled schedule (with dlopen), executes it, and unloads it.
+ *
+ * The runner is a child process of the autoscheduler : if a schedule crashes,
+ * only the runner is killed, and it is restarted for the next schedule.
+ *
+ * Timing is adaptive : after nb_warmup executions, the schedule is executed at least
+ * nb_exec times, and then until the 95% confidence interval of the mean is within
+ * target_precision of the mean, or until max_nb_exec executions.
+ * The runner can be pinned to a set of cores, and can flush the caches before each execution.
+ */
+class benchmark_runner
+{
+private:
+
+protected:
+    /**
+     * The name of the function to execute.
+     * The runner calls the symbol fct_name + "_argv" of each shared library,
+     * so the program must be compiled with Halide metadata.
+     */
+    std::string fct_name;
+
+    /**
+     * The input and output buffers of the program.
+     */
+    std::vector<tiramisu::buffer*> arguments;
+    
+    /**
+     * The size of each dimension of each buffer, from outermost to innermost.
+     * Symbolic sizes are evaluated by the caller, as the runner has no access to the function.
+     */
+    std::vector<std::vector<int>> buffer_sizes;
+
+    /**
+     * Number of timed executions, and number of executions done before timing.
+     */
+    int nb_exec;
+    int nb_warmup;
+    
+    /**
+     * Maximum number of timed executions, and the relative half-width
+     * of the confidence interval at which to stop executing.
+     */
+    int max_nb_exec = DEFAULT_MAX_NB_EXEC;
+    double target_precision = DEFAULT_TARGET_PRECISION;
+    
+    /**
+     * The cores on which the runner executes schedules (all cores if empty).
+     * The Halide thread pool uses one thread per core of this list.
+     */
+    std::vector<int> cpus;
+    
+    /**
+     * If true, a buffer of cache_flush_size bytes is written before each timed
+     * execution, so that schedules are timed with cold caches.
+     * Otherwise, caches are warmed by the previous executions.
+     */
+    bool flush_cache = false;
+    int cache_flush_size = DEFAULT_CACHE_FLUSH_SIZE;
+
+    /**
+     * The PID of the runner process (-1 if the runner is not started).
+     */
+    pid_t runner_pid = -1;
+
+    /**
+     * The pipe on which to write the path of the shared library to execute.
+     */
+    FILE *runner_write = nullptr;
+
+    /**
+     * The pipe on which to read the execution time.
+     */
+    FILE *runner_read = nullptr;
+
+    /**
+     * Launch the runner process.
+     * Return false if the process could not be created.
+     */
+    bool start();
+
+    /**
+     * Kill the runner process.
+     */
+    void stop();
+
+    /**
+     * The loop executed by the runner process.
+     * Read time limits and paths to shared libraries from read_fd,
+     * and write execution times to write_fd.
+     * This function never returns.
+     */
+    void runner_main(int read_fd, int write_fd);
+
+public:
+    benchmark_runner(std::string const& fct_name, std::vector<tiramisu::buffer*> const& arguments,
+                     std::vector<std::vector<int>> const& buffer_sizes,
+                     int nb_exec = DEFAULT_NB_EXEC, int nb_warmup = DEFAULT_NB_WARMUP);
+
+    ~benchmark_runner() { stop(); }
+
+    /**
+     * Execute the program contained in the given shared library,
+     * and return its median execution time in milliseconds.
+     * Return FLT_MAX if the program could not be executed, if it crashed,
+     * or if it returned an error.
+     */
+    float run(std::string const& so_path);
+    
+    /**
+     * Same as run(so_path), but also store statistics about the execution times in stats.
+     *
+     * If time_limit > 0, an execution that takes more than time_limit milliseconds is stopped,
+     * and the runner is killed if it doesn't answer in time (e.g. if the schedule hangs).
+     * The schedule is then marked as timed out, and the returned time is a lower bound.
+     */
+    float run(std::string const& so_path, timing_stats& stats, double time_limit = 0);
+    
+    /**
+     * The following setters restart the runner, so that the new parameters are used
+     * for the next schedule.
+     */
+    void set_adaptive_timing(int max_nb_exec, double target_precision);
+    void set_cpus(std::vector<int> const& cpus);
+    void set_cache_flush(bool flush_cache, int cache_flush_size = DEFAULT_CACHE_FLUSH_SIZE);
+};
+
+}
+
+#endif
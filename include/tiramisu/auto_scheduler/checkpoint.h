@@ -0,0 +1,115 @@
+#ifndef _TIRAMISU_AUTO_SCHEDULER_CHECKPOINT_
+#define _TIRAMISU_AUTO_SCHEDULER_CHECKPOINT_
+
+#include <cfloat>
+#include <chrono>
+
+#include "ast.h"
+#include "evaluation_cache.h"
+#include "utils.h"
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * Saves the state of a search to a directory, so that an interrupted search can be resumed.
+ *
+ * The directory contains :
+ *  - evaluations.db : the evaluations of the schedules by the evaluation function of the search,
+ *    with their confidence intervals, estimated evaluations included.
+ *  - executions.db : the execution times measured by the execution evaluator, with their confidence intervals.
+ *  - state : the budget consumed so far, and the best schedule found so far.
+ *
+ * The evaluation databases are written as soon as a schedule is evaluated (see evaluation_cache).
+ * The state is written periodically by the search method.
+ *
+ * Search methods are deterministic (random generators are seeded), so a resumed search
+ * explores the same schedules as the interrupted one, and reaches the frontier where it
+ * stopped without evaluating anything again : the evaluations are found in the databases,
+ * with the confidence intervals that break ties between schedules.
+ * It then continues the search from there.
+ */
+class search_checkpoint
+{
+private:
+
+protected:
+    /**
+     * The directory where the checkpoint is stored.
+     */
+    std::string checkpoint_dir;
+
+    /**
+     * The state is saved at most once per save_interval seconds.
+     */
+    double save_interval;
+    std::chrono::steady_clock::time_point last_save = std::chrono::steady_clock::now();
+
+    /**
+     * Caches for the evaluations of the search and for the execution times.
+     */
+    evaluation_cache *eval_cache;
+    evaluation_cache *exec_cache;
+
+    /**
+     * The best schedule of the loaded state.
+     */
+    std::vector<optimization_info> best_optims;
+
+public:
+    /**
+     * The budget consumed by the previous runs of the search.
+     */
+    double elapsed_time = 0;
+    int nb_compilations = 0;
+    int nb_executions = 0;
+
+    /**
+     * The evaluation of the best schedule of the loaded state (FLT_MAX if there is none).
+     */
+    float best_evaluation = FLT_MAX;
+
+    /**
+     * True if a state was loaded from checkpoint_dir.
+     */
+    bool resumed = false;
+
+    /**
+     * Create the checkpoint directory if needed, and load the evaluation databases it contains.
+     */
+    search_checkpoint(std::string const& checkpoint_dir, double save_interval = 60);
+
+    ~search_checkpoint();
+
+    evaluation_cache* get_evaluation_cache() const { return eval_cache; }
+    evaluation_cache* get_execution_cache() const { return exec_cache; }
+
+    /**
+     * Load the state saved in checkpoint_dir for the program of the given AST.
+     * Return false if there is no state, or if it doesn't match the program.
+     */
+    bool load_state(syntax_tree const& ast);
+
+    /**
+     * Return a copy of the given unscheduled AST with the best schedule of the loaded state,
+     * or nullptr if the state has no best schedule.
+     */
+    syntax_tree* get_best_ast(syntax_tree const& ast) const;
+
+    /**
+     * Return true if the state must be saved, i.e. if it was saved more than save_interval seconds ago.
+     */
+    bool save_due() const;
+
+    /**
+     * Save the state of a search. best_ast can be nullptr.
+     * The state is written to a temporary file, then renamed,
+     * so that an interruption doesn't leave a partially written state.
+     */
+    void save_state(syntax_tree const *best_ast, float best_evaluation, double elapsed_time,
+                    int nb_compilations, int nb_executions);
+};
+
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef _TIRAMISU_AUTO_SCHEDULER_COST_MODEL_
+#define _TIRAMISU_AUTO_SCHEDULER_COST_MODEL_
+
+#include "ast.h"
+#include "evaluator.h"
+#include "utils.h"
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * The characteristics of the machine used by evaluate_by_cost_model.
+ * The default values describe a common x86 server core.
+ */
+struct machine_description
+{
+    /**
+     * Cache sizes in bytes, from L1 to L3, and size of a cache line in bytes.
+     */
+    int l1_size = 32 * 1024;
+    int l2_size = 256 * 1024;
+    int l3_size = 8 * 1024 * 1024;
+    int cache_line_size = 64;
+
+    /**
+     * Width of the vector registers in bytes.
+     */
+    int vector_width = 32;
+
+    /**
+     * Number of cores used to execute parallel loops.
+     */
+    int nb_cores = 4;
+
+    /**
+     * Clock frequency in GHz.
+     */
+    double frequency = 2.5;
+
+    /**
+     * Number of bytes per cycle that a core can load from L2 and from L3.
+     */
+    double l2_bandwidth = 32;
+    double l3_bandwidth = 16;
+
+    /**
+     * Memory bandwidth in GB/s, shared by all the cores.
+     */
+    double mem_bandwidth = 20;
+
+    /**
+     * Number of arithmetic instructions executed per cycle by a core.
+     */
+    double ipc = 2;
+
+    /**
+     * Cost in cycles of an iteration of a loop that is not unrolled.
+     */
+    double loop_overhead = 1;
+
+    /**
+     * Cost in cycles of a division, relative to an addition.
+     */
+    double division_cost = 10;
+
+    /**
+     * Fraction of the vector width used when the compiler vectorizes
+     * a loop level that is not tagged to be vectorized.
+     */
+    double autovectorization_efficiency = 0.5;
+
+    /**
+     * Cost in cycles of starting the threads of a parallel loop.
+     */
+    double parallel_overhead = 2000;
+
+    /**
+     * Beyond this number of instructions, the body of an unrolled loop
+     * doesn't fit in registers anymore, and unrolling doesn't pay off.
+     */
+    int max_unrolled_body = 256;
+};
+
+/**
+ * Return the description of the machine running the auto-scheduler.
+ * Cache sizes and the cache line size are read from /sys/devices/system/cpu/cpu0/cache,
+ * the number of cores from std::thread::hardware_concurrency().
+ * The values that can't be read keep their default value.
+ */
+machine_description get_host_machine_description();
+
+/**
+ * Read a machine description from the given file, and return false if the file can't be read.
+ * Each line of the file contains the name of a field of machine_description and its value,
+ * for example "l2_size 1048576". Fields not present in the file are left unchanged.
+ */
+bool read_machine_description(std::string const& config_path, machine_description& machine);
+
+/**
+ * Return the size in bytes of the given type.
+ */
+int get_type_size(primitive_t type);
+
+/**
+ * An analytical cost model : estimate the execution time of a schedule
+ * from the loop structure of the AST, without compiling anything.
+ *
+ * For each computation, the model estimates :
+ *  - The arithmetic cost, from the number of operations of the computation,
+ *    reduced by vectorization if the innermost loop accesses memory contiguously.
+ *  - The loop overhead, which is reduced by unrolling.
+ *  - The memory cost : for each cache level, the footprint of the accesses
+ *    is computed for each loop level, from the access matrices. The data of
+ *    the outermost loop level whose footprint fits in the cache is loaded once
+ *    for each iteration of the loops above it.
+ * Loop levels tagged by PARALLELIZE and VECTORIZE are taken into account. If the schedule
+ * has no PARALLELIZE, the outermost loop level is considered parallel, as done by evaluate_by_execution.
+ *
+ * The evaluation is an estimated execution time in milliseconds.
+ * It is meant to rank schedules, not to predict their exact execution time.
+ */
+class evaluate_by_cost_model : public evaluation_function
+{
+private:
+
+protected:
+    /**
+     * The machine for which execution times are estimated.
+     */
+    machine_description machine;
+
+    /**
+     * A loop level enclosing a computation.
+     */
+    struct loop_info
+    {
+        /**
+         * The iterator of the computation traversed by this loop level (-1 if none).
+         */
+        int iter_index;
+
+        /**
+         * The number of iterations of this loop level, and the value by which
+         * the iterator of the computation is incremented at each iteration.
+         */
+        int extent;
+        int stride;
+
+        bool unrolled;
+        bool parallel;
+        bool vectorized;
+    };
+
+    /**
+     * Return the loop levels enclosing the given computation, from the outermost
+     * to the innermost.
+     */
+    std::vector<loop_info> get_loop_nest(ast_node *node, computation_info const& comp_info) const;
+
+    /**
+     * Estimate the number of cycles needed to execute the given computation.
+     */
+    double estimate_computation(std::vector<loop_info> const& loops, computation_info const& comp_info, bool parallel) const;
+
+    /**
+     * Recursively estimate the cycles of the computations of the subtree rooted at node.
+     * If parallel is true, the outermost loop level is considered parallel.
+     */
+    double estimate_node(ast_node *node, bool parallel) const;
+
+public:
+    evaluate_by_cost_model(machine_description const& machine = machine_description())
+        : evaluation_function(), machine(machine) {}
+
+    virtual ~evaluate_by_cost_model() {}
+
+    /**
+     * Return the estimated execution time of the given AST in milliseconds.
+     */
+    virtual float evaluate(syntax_tree& ast);
+
+    machine_description const& get_machine() const { return machine; }
+    void set_machine(machine_description const& machine) { this->machine = machine; }
+};
+
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include <tiramisu/expr.h>
 
 #include "optimization_info.h"
+#include "utils.h"
 
 namespace tiramisu::auto_scheduler
 {
@@ -25,8 +26,12 @@ public:
         
     /**
      * Return a list of dnn_iterators from the iterators of the given computation.
+     * If the loop bounds depend on parameters, each parameter takes its value from params,
+     * or else from the context of the function (e.g. "[N]->{: N=1024}").
+     * The program stops if a parameter has no value.
      */
-    static std::vector<dnn_iterator> get_iterators_from_computation(tiramisu::computation const& comp);
+    static std::vector<dnn_iterator> get_iterators_from_computation(tiramisu::computation const& comp, 
+                                                                    parameters_values const& params = parameters_values());
 };
 
 /**
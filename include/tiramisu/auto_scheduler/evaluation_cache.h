@@ -0,0 +1,108 @@
+#ifndef _TIRAMISU_AUTO_SCHEDULER_EVALUATION_CACHE_
+#define _TIRAMISU_AUTO_SCHEDULER_EVALUATION_CACHE_
+
+#include <unordered_map>
+
+#include "ast.h"
+#include "utils.h"
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * An evaluation stored in an evaluation_cache.
+ */
+struct cached_evaluation
+{
+    float evaluation;
+    
+    /**
+     * The half-width of the confidence interval of the evaluation
+     * (see evaluation_function::get_confidence_interval()).
+     */
+    float ci = 0;
+    
+    /**
+     * True if the evaluation was estimated instead of measured
+     * (see evaluation_function::is_estimated()).
+     */
+    bool estimated = false;
+};
+
+/**
+ * Stores the evaluations of the schedules already explored,
+ * so that a schedule reached several times by a search method is evaluated only once.
+ * Each evaluation is stored with its confidence interval, and with whether it is an estimate,
+ * so that a search using the cache ranks the schedules as it would without it.
+ *
+ * Schedules are identified by syntax_tree::get_fingerprint().
+ * An evaluation cache must only be used with one evaluation function.
+ */
+class evaluation_cache
+{
+private:
+
+protected:
+    /**
+     * A mapping between the fingerprint of a schedule and its evaluation.
+     */
+    std::unordered_map<uint64_t, cached_evaluation> evaluations;
+
+    /**
+     * The file where evaluations are saved (empty if evaluations are only kept in memory).
+     * Each line of the file contains a fingerprint, its evaluation, the half-width of
+     * the confidence interval of the evaluation, and 1 if the evaluation is an estimate.
+     */
+    std::string db_path;
+
+    /**
+     * Number of schedules found in the cache, and number of schedules not found.
+     */
+    int nb_hits = 0;
+    int nb_misses = 0;
+
+public:
+    /**
+     * If db_path is not empty, load the evaluations stored in db_path,
+     * and save new evaluations to it. This allows to reuse the evaluations
+     * of a previous search on the same program.
+     */
+    evaluation_cache(std::string const& db_path = "");
+
+    /**
+     * If the schedule of the given AST is in the cache, store its evaluation
+     * in "evaluation" and return true. Otherwise, return false.
+     */
+    bool find(syntax_tree const& ast, float& evaluation);
+    
+    /**
+     * Same as find(), but also store the half-width of the confidence interval
+     * of the evaluation in "ci".
+     */
+    bool find(syntax_tree const& ast, float& evaluation, float& ci);
+    
+    /**
+     * Return true if the schedule of the given AST is in the cache with an estimated evaluation.
+     */
+    bool is_estimated(syntax_tree const& ast) const;
+
+    /**
+     * Return true if the schedule of the given AST is in the cache.
+     * Unlike find(), it is not counted as a hit or a miss.
+     */
+    bool contains(syntax_tree const& ast) const { return evaluations.count(ast.get_fingerprint()) > 0; }
+
+    /**
+     * Add the evaluation of the schedule of the given AST to the cache,
+     * with the half-width of its confidence interval, and whether it is an estimate.
+     */
+    void insert(syntax_tree const& ast, float evaluation, float ci = 0, bool estimated = false);
+
+    int get_nb_hits() const { return nb_hits; }
+    int get_nb_misses() const { return nb_misses; }
+    int get_nb_evaluations() const { return evaluations.size(); }
+};
+
+}
+
+#endif
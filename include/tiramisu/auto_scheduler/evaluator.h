@@ -1,12 +1,68 @@
 #ifndef _TIRAMISU_AUTO_SCHEDULER_EVALUATOR_
 #define _TIRAMISU_AUTO_SCHEDULER_EVALUATOR_
 
+#include <unordered_set>
+
 #include "auto_scheduler.h"
+#include "benchmark_runner.h"
 #include "utils.h"
 
 namespace tiramisu::auto_scheduler
 {
 
+/**
+ * Time in seconds spent on a schedule by each phase of its evaluation.
+ */
+struct evaluation_phases
+{
+    /**
+     * Generating the schedule and transforming its AST (measured by the search method).
+     */
+    double transform = 0;
+
+    /**
+     * Evaluating the schedule with an evaluation function that doesn't execute it.
+     */
+    double prediction = 0;
+
+    /**
+     * Applying the schedule with the Tiramisu scheduling commands, and generating
+     * the time-space domain, the ISL AST and the Halide statement.
+     */
+    double scheduling = 0;
+
+    /**
+     * Lowering the Halide statement, compiling it to an object file with LLVM,
+     * and linking the object file to a shared library.
+     */
+    double halide_lowering = 0;
+    double llvm_compile = 0;
+    double link = 0;
+
+    /**
+     * Executing the shared library.
+     */
+    double execution = 0;
+
+    double get_total() const
+    {
+        return transform + prediction + scheduling + halide_lowering + llvm_compile + link + execution;
+    }
+
+    evaluation_phases& operator+=(evaluation_phases const& other)
+    {
+        transform += other.transform;
+        prediction += other.prediction;
+        scheduling += other.scheduling;
+        halide_lowering += other.halide_lowering;
+        llvm_compile += other.llvm_compile;
+        link += other.link;
+        execution += other.execution;
+
+        return *this;
+    }
+};
+
 /**
   * An abstract class that represents an evaluation function.
   * Derive this class and implement the method "evaluate" to
@@ -26,6 +82,48 @@ public:
      * its evaluation.
      */
     virtual float evaluate(syntax_tree& ast) =0;
+    
+    /**
+     * Takes as input a list of abstract syntax trees and returns
+     * their evaluations, in the same order.
+     * By default, the ASTs are evaluated one by one with evaluate().
+     * Override this method if the evaluation function can process
+     * several ASTs at once.
+     */
+    virtual std::vector<float> evaluate_batch(std::vector<syntax_tree*> const& asts);
+    
+    /**
+     * Return true if this evaluation function compiles and executes the schedules.
+     * Search methods use this to know how many schedules a budget of compilations
+     * or executions allows to evaluate.
+     */
+    virtual bool measures_execution() const { return false; }
+    
+    /**
+     * Number of compilations and executions done by this evaluation function.
+     */
+    virtual int get_nb_compilations() const { return 0; }
+    virtual int get_nb_executions() const { return 0; }
+    
+    /**
+     * Return the half-width of the confidence interval of the last evaluation
+     * of the given AST, or 0 if evaluations are not noisy.
+     */
+    virtual float get_confidence_interval(syntax_tree const& ast) const { return 0; }
+    
+    /**
+     * Return true if the last evaluation of the given AST was estimated instead of measured.
+     * An estimated evaluation can be used to rank schedules, but it must not be
+     * taken as the execution time of the schedule (e.g. to select the best schedule).
+     */
+    virtual bool is_estimated(syntax_tree const& ast) const { return false; }
+
+    /**
+     * If this evaluation function measured the time of its phases when it last evaluated
+     * the given AST, store them in "phases", forget them, and return true.
+     * Evaluation functions that don't compile the schedules don't measure phases.
+     */
+    virtual bool take_evaluation_phases(syntax_tree const& ast, evaluation_phases& phases) { return false; }
 };
 
 /**
@@ -64,6 +162,145 @@ protected:
      * The command that will be used to execute the wrapper to measure execution time.
      */
     std::string wrapper_cmd;
+    
+    /**
+     * The number of schedules to compile concurrently in evaluate_batch().
+     * Each schedule is compiled in its own process (isl contexts can't be shared).
+     * The wrapper is always executed by one schedule at a time, so that
+     * execution times are not disturbed by the compilations.
+     */
+    int nb_workers = 1;
+    
+    /**
+     * If not null, execution times are measured by this runner
+     * instead of by the wrapper.
+     */
+    benchmark_runner *runner = nullptr;
+    
+    /**
+     * Number of compilations and executions done, and the time they took in seconds.
+     */
+    int nb_compilations = 0;
+    int nb_executions = 0;
+    double compile_time = 0;
+    double exec_time = 0;
+    
+    /**
+     * The timing statistics of the last execution, and of each schedule executed
+     * (indexed by the fingerprint of the schedule).
+     */
+    timing_stats last_timing;
+    std::unordered_map<uint64_t, timing_stats> timings;
+
+    /**
+     * The time spent by each phase on the schedules evaluated since the search method
+     * last took them (indexed by the fingerprint of the schedule).
+     */
+    std::unordered_map<uint64_t, evaluation_phases> phases;
+
+    /**
+     * If timeout_factor > 0, an execution is stopped when it takes more than timeout_factor
+     * times the best execution time measured so far. Its evaluation is then a lower bound
+     * of its execution time ("worse than X"), and the schedule is never executed again.
+     */
+    double timeout_factor = 0;
+    
+    /**
+     * If compile_timeout > 0, a compilation that takes more than compile_timeout seconds
+     * is killed, and the schedule gets an evaluation equal to FLT_MAX.
+     * Compilations are then done in child processes, even if nb_workers is 1.
+     */
+    double compile_timeout = 0;
+    
+    /**
+     * The best execution times measured so far, on full and on reduced iteration domains.
+     */
+    float best_exec_time = FLT_MAX;
+    float best_reduced_exec_time = FLT_MAX;
+    
+    /**
+     * Number of executions and compilations stopped by a timeout.
+     */
+    int nb_exec_timeouts = 0;
+    int nb_compile_timeouts = 0;
+    
+    /**
+     * If the given AST timed out before, store its evaluation in "evaluation" and return true.
+     */
+    bool get_timed_out_evaluation(syntax_tree const& ast, float& evaluation) const;
+    
+    /**
+     * Multi-fidelity evaluation : if multi_fidelity_topk > 0, evaluate_batch() first
+     * executes the schedules on reduced iteration domains, then executes the
+     * multi_fidelity_topk best ones on the full iteration domains.
+     */
+    int multi_fidelity_topk = 0;
+    
+    /**
+     * Each dimension of the iteration domains is shrunk by this ratio.
+     * Dimensions with an extent smaller than min_reduced_extent are not shrunk.
+     */
+    double reduced_size_ratio = 0.25;
+    int min_reduced_extent = 32;
+    
+    /**
+     * True if compile_schedule() must compile the program on reduced iteration domains.
+     */
+    bool use_reduced_sizes = false;
+    
+    /**
+     * The execution times, on reduced and on full iteration domains,
+     * of the schedules executed at both sizes.
+     */
+    std::vector<float> reduced_exec_times;
+    std::vector<float> full_exec_times;
+    
+    /**
+     * The fingerprints of the schedules whose last evaluation was estimated
+     * from their execution time on reduced iteration domains.
+     */
+    std::unordered_set<uint64_t> estimated_schedules;
+    
+    /**
+     * Apply the optimizations specified by the AST, compile the program
+     * to the given object file, and turn it into a shared library.
+     * Return true if compilation succeeded.
+     * The time spent by each compilation phase is stored in sched_phases.
+     */
+    bool compile_schedule(syntax_tree& ast, std::string const& obj_name, evaluation_phases& sched_phases);
+    
+    /**
+     * Shrink the iteration domain of each computation, and return the original domains.
+     * Each dimension keeps at least two blocks of the tiles, unrolled and vectorized
+     * loops applied on it by the schedule, so that these optimizations are still meaningful.
+     */
+    std::vector<isl_set*> shrink_iteration_domains(syntax_tree const& ast);
+    
+    /**
+     * Set back the iteration domains returned by shrink_iteration_domains().
+     */
+    void restore_iteration_domains(syntax_tree const& ast, std::vector<isl_set*> const& domains);
+    
+    /**
+     * Compile the given schedules using nb_workers processes, then execute them one by one.
+     * Schedules that timed out before are not compiled again.
+     */
+    std::vector<float> compile_and_run_batch(std::vector<syntax_tree*> const& asts);
+    
+    /**
+     * Return the size of each dimension of each argument of the program.
+     * Symbolic sizes are evaluated with the values fixed by the context of the function.
+     * Stop with an error if a size has no fixed value, as the buffers can't be allocated.
+     */
+    std::vector<std::vector<int>> get_argument_sizes() const;
+    
+    /**
+     * Execute the program compiled in obj_name, and return its execution time.
+     * Uses the persistent runner if there is one, otherwise uses the wrapper,
+     * which loads obj_filename.so.
+     * The timing statistics are stored in last_timing (the wrapper only gives the median).
+     */
+    float run_schedule(std::string const& obj_name);
 
 public:
     /**
@@ -73,32 +310,167 @@ public:
 						  std::string const& obj_filename, 
 						  std::string const& wrapper_cmd,
 						  tiramisu::function *fct = tiramisu::global::get_implicit_function());
+						  
+    virtual ~evaluate_by_execution() { delete runner; }
     
 	/**
 	 * Apply the specified optimizations, compile the program and execute it.
 	 */
     virtual float evaluate(syntax_tree& ast);
+    
+    /**
+     * Compile the given schedules using nb_workers processes,
+     * then execute them one by one.
+     * A schedule that fails to compile gets an evaluation equal to FLT_MAX.
+     *
+     * In multi-fidelity mode, only the best schedules on reduced iteration domains
+     * are executed at full size. The other schedules get their reduced execution time
+     * scaled by the median ratio between full and reduced execution times : these
+     * evaluations are only estimates (see is_estimated()).
+     * If there are no more than multi_fidelity_topk schedules, they are all executed
+     * at full size directly.
+     */
+    virtual std::vector<float> evaluate_batch(std::vector<syntax_tree*> const& asts);
+    
+    /**
+     * Enable multi-fidelity evaluation (disabled if topk <= 0).
+     */
+    void set_multi_fidelity(int topk, double reduced_size_ratio = 0.25, int min_reduced_extent = 32)
+    {
+        this->multi_fidelity_topk = topk;
+        this->reduced_size_ratio = reduced_size_ratio;
+        this->min_reduced_extent = min_reduced_extent;
+    }
+    
+    /**
+     * Print how well the ranking on reduced iteration domains matches
+     * the ranking on full iteration domains.
+     */
+    void print_fidelity_report() const;
+    
+    /**
+     * Set the number of schedules to compile concurrently.
+     */
+    void set_nb_workers(int nb_workers) { this->nb_workers = nb_workers; }
+    
+    /**
+     * Set the timeouts of executions (relative to the best execution time) and of compilations (in seconds).
+     * A value <= 0 disables the timeout.
+     */
+    void set_timeouts(double timeout_factor, double compile_timeout = 0)
+    {
+        this->timeout_factor = timeout_factor;
+        this->compile_timeout = compile_timeout;
+    }
+    
+    int get_nb_exec_timeouts() const { return nb_exec_timeouts; }
+    int get_nb_compile_timeouts() const { return nb_compile_timeouts; }
+    
+    /**
+     * Measure execution times with a persistent benchmark_runner instead of the wrapper.
+     * The runner allocates the buffers given to the constructor once, and executes
+     * each schedule nb_exec times (after nb_warmup executions).
+     * The wrapper command is not used anymore.
+     */
+    void use_benchmark_runner(int nb_exec = DEFAULT_NB_EXEC, int nb_warmup = DEFAULT_NB_WARMUP);
+    
+    /**
+     * Return the benchmark runner (nullptr if use_benchmark_runner() was not called),
+     * to set its timing parameters.
+     */
+    benchmark_runner* get_benchmark_runner() const { return runner; }
+    
+    /**
+     * Return the timing statistics of the last execution of the given AST.
+     * Return false if the AST was not executed.
+     */
+    bool get_timing_stats(syntax_tree const& ast, timing_stats& stats) const;
+    
+    virtual float get_confidence_interval(syntax_tree const& ast) const;
+    
+    virtual bool is_estimated(syntax_tree const& ast) const { return estimated_schedules.count(ast.get_fingerprint()) > 0; }
+
+    virtual bool take_evaluation_phases(syntax_tree const& ast, evaluation_phases& sched_phases);
+
+    virtual bool measures_execution() const { return true; }
+    
+    virtual int get_nb_compilations() const { return nb_compilations; }
+    virtual int get_nb_executions() const { return nb_executions; }
+    double get_compile_time() const { return compile_time; }
+    double get_exec_time() const { return exec_time; }
+    
+    /**
+     * Return the average time in seconds spent to compile and to execute a schedule.
+     */
+    double get_avg_evaluation_time() const
+    {
+        double avg_time = 0;
+        if (nb_compilations > 0)
+            avg_time += compile_time / nb_compilations;
+        if (nb_executions > 0)
+            avg_time += exec_time / nb_executions;
+            
+        return avg_time;
+    }
 };
 
 /**
  * This evaluation function uses system pipes to communicate with an ML model
  * that will evaluate schedules.
- * JSON is used to transfer information about the schedule to evaluate.
+ *
+ * Messages are length-prefixed binary frames (integers are 32 bits, in the native byte order) :
+ *  - 'P', length, program JSON : the program to which the next schedules apply.
+ *    It is sent only when the program changes, i.e. once per search.
+ *  - 'B', number of schedules, then for each schedule : length, schedule JSON.
+ * The model answers each 'B' frame with the number of schedules, followed
+ * by the predicted speedup of each schedule as a 32-bit float.
  */
 class evaluate_by_learning_model : public evaluation_function
 {
 private:
 
 protected:
+    /**
+     * The command that launches the model, and its arguments.
+     */
+    std::string cmd_path;
+    std::vector<std::string> cmd_args;
+    
+    /**
+     * The PID of the model process.
+     */
+    pid_t model_pid = -1;
+    
     /**
      * The pipe on which to write information about schedules to evaluate.
      */
-    FILE *model_write;
+    FILE *model_write = nullptr;
     
     /**
      * The pipe on which to read the evaluation of a schedule.
      */
-    FILE *model_read;
+    FILE *model_read = nullptr;
+    
+    /**
+     * The JSON of the program last sent to the model.
+     * It depends on the order of the computations in the AST, not only on the function.
+     */
+    std::string sent_program_json;
+    
+    /**
+     * Launch the model process.
+     */
+    void start_model();
+    
+    /**
+     * Kill the model process.
+     */
+    void stop_model();
+    
+    /**
+     * Send the program of the given AST to the model, if it was not already sent.
+     */
+    void send_program(syntax_tree const& ast);
 
 public:
     /**
@@ -107,11 +479,20 @@ public:
      */
     evaluate_by_learning_model(std::string const& cmd_path, std::vector<std::string> const& cmd_args);
     
+    ~evaluate_by_learning_model() { stop_model(); }
+    
 	/**
 	 * Call the model and return its evaluation.
 	 */
     virtual float evaluate(syntax_tree& ast);
     
+    /**
+     * Send all the given ASTs to the model in one message,
+     * and return their evaluations.
+     * The ASTs must represent the same program.
+     */
+    virtual std::vector<float> evaluate_batch(std::vector<syntax_tree*> const& asts);
+    
     /**
      * Return a JSON representation of the program represented by the AST.
      * Uses the function : represent_computations_from_nodes. 
@@ -160,6 +541,60 @@ public:
     static std::string get_tree_structure_json(ast_node *node);
 };
 
+/**
+ * Evaluate schedules of a program with symbolic loop bounds over a distribution of sizes,
+ * so that the search finds a schedule that performs well on all of them.
+ *
+ * For each size (a value for each parameter), the schedule is replayed on an AST built
+ * with these parameters values (see syntax_tree::replay_optimizations()), and evaluated by eval_func.
+ * The evaluation is the weighted mean over the sizes of :
+ * evaluation of the schedule / |evaluation of the unscheduled program at the same size|,
+ * so that each size counts as much as its weight, whatever its execution time.
+ *
+ * eval_func must evaluate the AST itself, like evaluate_by_cost_model or evaluate_by_learning_model.
+ * evaluate_by_execution compiles the program at the size it is declared with.
+ */
+class evaluate_over_sizes : public evaluation_function
+{
+private:
+
+protected:
+    /**
+     * The evaluation function used for each size.
+     */
+    evaluation_function *eval_func;
+    
+    /**
+     * An unscheduled AST for each size, its weight, and the evaluation of the unscheduled program.
+     */
+    std::vector<syntax_tree*> sized_asts;
+    std::vector<double> weights;
+    std::vector<float> initial_evaluations;
+
+public:
+    /**
+     * sizes : the values of the parameters of fct for each size of the distribution.
+     * weights : the weight of each size (e.g. its frequency). By default, all sizes have the same weight.
+     */
+    evaluate_over_sizes(evaluation_function *eval_func, tiramisu::function *fct, 
+                        std::vector<parameters_values> const& sizes, std::vector<double> const& weights = {});
+                        
+    virtual ~evaluate_over_sizes();
+    
+    virtual float evaluate(syntax_tree& ast);
+    
+    /**
+     * For each size, the schedules are evaluated in one batch by eval_func.
+     */
+    virtual std::vector<float> evaluate_batch(std::vector<syntax_tree*> const& asts);
+    
+    /**
+     * Return the evaluation of the schedule of the given AST for each size,
+     * divided by the evaluation of the unscheduled program at this size.
+     */
+    std::vector<float> evaluate_per_size(syntax_tree const& ast);
+};
+
 }
 
 #endif
@@ -14,7 +14,10 @@ enum optimization_type
     FUSION,
     TILING,
     INTERCHANGE,
-    UNROLLING
+    UNROLLING,
+    PARALLELIZE,
+    VECTORIZE,
+    COMPUTE_AT
 };
 
 /**
@@ -50,11 +53,17 @@ struct optimization_info
      * The loop levels this optimization affects.
      * nb_l indicates the number of loop levels to consider.
      *
-     * 1. In the case of unrolling, if l0 == -1, unrolling is applied
-     * on all innermost levels.
+     * 1. In the case of unrolling and vectorization, if l0 == -1, the optimization
+     * is applied on all innermost levels.
      *
      * 2. In the case of fusion, l0 and l1 will contain the indices
      * of the two nodes to fuse, in the tree level to which "node" belongs to.
+     * l2 is the depth of this tree level, and comps contains the computations of the two nodes.
+     *
+     * 3. In the case of compute_at, comps contains the producer and then the consumer.
+     * l0 is the loop level of the consumer at which the producer is computed, and l1 the
+     * loop level at which the storage of the producer is allocated. If l1 == -1, the producer
+     * keeps its buffer. Otherwise, it is stored in a buffer only large enough for one iteration of l1.
      */
     int l0, l1, l2;
     
@@ -62,10 +71,17 @@ struct optimization_info
      * Contains the factors of each loop level.
      * For example, if the optimization is a 2 level tiling,
      * l0_fact and l1_fact will contain the tiling factors for each loop level.
+     * In the case of vectorization, l0_fact contains the vector length.
      */
     int l0_fact, l1_fact, l2_fact;
 };
 
+/**
+ * Return a string that identifies the given optimization :
+ * its type, the computations it is applied to, its loop levels and its factors.
+ */
+std::string get_optimization_str(optimization_info const& optim_info);
+
 /**
  * Tag the outermost level of each computation to be parallelized.
  */
@@ -76,6 +92,16 @@ void parallelize_outermost_levels(std::vector<tiramisu::computation*> const& com
  */
 void unroll_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int unroll_fact);
 
+/**
+ * Tag the innermost level of each computation to be vectorized with a vector length = vector_len.
+ */
+void vectorize_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int vector_len);
+
+/**
+ * Return true if the schedule of the given AST contains an optimization of the given type.
+ */
+bool ast_has_optimization(syntax_tree const& ast, optimization_type optim);
+
 /**
  * Apply the optimizations specified by the syntax tree using the Tiramisu API.
  */
@@ -85,6 +111,14 @@ void apply_optimizations(syntax_tree const& ast);
  * Apply the given optimization using the Tiramisu API.
  */
 void apply_optimizations(optimization_info const& optim_info);
+
+/**
+ * Apply the compute_at optimizations of the AST, after the other optimizations.
+ * compute_at adds computations and buffers to the function, so it must only be applied
+ * in a process that doesn't compile other schedules afterwards (see evaluate_by_execution),
+ * or to the final schedule.
+ */
+void apply_compute_at(syntax_tree const& ast);
     
 /**
  * Schedule the computations so as to be in the order specified by the AST.
@@ -3,14 +3,76 @@
 
 #include "ast.h"
 #include "evaluator.h"
+#include "cost_model.h"
 
 namespace tiramisu::auto_scheduler
 {
 
 const std::vector<int> TILING_FACTORS_DEFAULT_LIST = {32, 64, 128};
 const std::vector<int> UNROLLING_FACTORS_DEFAULT_LIST = {4, 8, 16};
+const std::vector<int> VECTORIZATION_FACTORS_DEFAULT_LIST = {4, 8, 16};
 const int DEFAULT_MAX_NB_ITERATORS = 7;
 
+/**
+ * Propose tiling factors from the caches of the machine, instead of a fixed list.
+ *
+ * For a tiling of nb_levels loop levels, the candidate factors of a loop level are
+ * divisors of its extent (tiling requires the factor to divide the extent) : the powers of two,
+ * and for each cache level, the largest factor whose tile fits in the cache when the other
+ * levels take their smallest factor. At most max_factors_per_level factors are kept per level,
+ * so that the number of combinations stays small for large extents.
+ * For each combination of factors, the footprint in bytes of a tile is computed from the
+ * access matrices of the computations enclosed by the tiled levels : a tile touches, in each
+ * dimension of a buffer, a span depending on the tiled iterators and on the loop levels below them.
+ * For each cache level, the combinations with the largest footprint that fits in the cache are kept.
+ */
+class tiling_factors_generator
+{
+private:
+
+protected:
+    /**
+     * The cache sizes used to select the tiling factors.
+     */
+    machine_description machine;
+    
+    /**
+     * Smallest tiling factor to propose.
+     */
+    int min_factor;
+    
+    /**
+     * Number of combinations of factors proposed for each cache level (L1 and L2).
+     */
+    int nb_factors_per_cache;
+    
+    /**
+     * Maximal number of candidate factors of a loop level.
+     */
+    int max_factors_per_level;
+    
+    /**
+     * Return the footprint in bytes of a tile of the given computation.
+     * levels contains the tiled loop levels, and factors the size of the tile along each of them.
+     */
+    double get_tile_footprint(computation_info const& comp_info, std::vector<ast_node*> const& levels, 
+                              std::vector<int> const& factors, syntax_tree const& ast) const;
+
+public:
+    tiling_factors_generator(machine_description const& machine = get_host_machine_description(),
+                             int min_factor = 8, int nb_factors_per_cache = 2, int max_factors_per_level = 8)
+        : machine(machine), min_factor(min_factor), nb_factors_per_cache(nb_factors_per_cache),
+          max_factors_per_level(max_factors_per_level) {}
+        
+    /**
+     * Return combinations of tiling factors to tile nb_levels loop levels, starting from node
+     * and following the first child of each level. Each combination contains nb_levels factors.
+     */
+    std::vector<std::vector<int>> get_tiling_factors(ast_node *node, int nb_levels, syntax_tree const& ast) const;
+    
+    machine_description const& get_machine() const { return machine; }
+};
+
 /**
  * Generate a set of AST's from a given AST.
  * Inherit this class to implement a new way to generate schedules.
@@ -29,15 +91,107 @@ protected:
      * A list of unrolling factors to apply when unrolling is applied.
      */
     std::vector<int> unrolling_factors_list;
+    
+    /**
+     * A list of vector lengths to use when vectorization is applied.
+     */
+    std::vector<int> vectorization_factors_list = VECTORIZATION_FACTORS_DEFAULT_LIST;
+    
+    /**
+     * If not null, tiling factors are chosen from the caches of the machine,
+     * and tiling_factors_list is not used.
+     */
+    tiling_factors_generator *tiling_factors_gen = nullptr;
+    
+    /**
+     * The function on which performe_full_dependecy_analysis() has been called.
+     * The dependence analysis is needed to check the legality of parallelization
+     * and vectorization, and it is done only once per function.
+     */
+    tiramisu::function *analyzed_fct = nullptr;
+    
+    /**
+     * If true, the generated schedules that violate data dependences are removed
+     * before being returned, so that they are never evaluated.
+     */
+    bool check_legality = true;
+    
+    /**
+     * Number of generated schedules removed because they violate data dependences.
+     */
+    int nb_pruned_schedules = 0;
+    
+    /**
+     * Compute the dependences of the given function, if it was not done yet.
+     */
+    void analyze_dependences(tiramisu::function *fct);
+    
+    /**
+     * Apply the schedule of the given AST to its function, so that the legality of
+     * new optimizations can be checked with loop_level_is_legal().
+     * Call ast.fct->reset_schedules() once the checks are done.
+     */
+    void apply_schedule_for_legality_check(syntax_tree const& ast);
+    
+    /**
+     * Return true if the schedule of the given generated AST respects the dependences.
+     * The last optimization of the AST (the one just generated) doesn't need to be
+     * applied on the AST yet.
+     */
+    bool schedule_is_legal(syntax_tree const& ast);
+    
+    /**
+     * Return true if the schedule applied to the function respects the dependences
+     * when the producer is computed at a loop level of the consumer.
+     * compute_at is modeled as a fusion of the producer into the loop nest of the consumer
+     * at that level (see syntax_tree::transform_ast_by_compute_at()). The dependences from
+     * the producer to the consumer are not checked : compute_at() computes the values read
+     * by an iteration of the consumer before it, redundantly if needed.
+     */
+    bool compute_at_is_legal(syntax_tree const& ast, tiramisu::computation *producer, tiramisu::computation *consumer);
+    
+    /**
+     * Remove and delete the schedules that violate data dependences.
+     * Only the optimizations that change the order of execution (fusion, unfuse,
+     * tiling, interchange, compute_at) are checked : the others are always legal,
+     * or have been checked when generated.
+     */
+    void remove_illegal_schedules(std::vector<syntax_tree*>& states);
+    
+    /**
+     * Return true if the given loop level can be parallelized (optim = PARALLELIZE)
+     * or vectorized (optim = VECTORIZE) for all the given computations.
+     * If level is -1, the innermost loop level of each computation is checked.
+     */
+    bool loop_level_is_legal(std::vector<tiramisu::computation*> const& comps, int level, optimization_type optim);
+    
+    /**
+     * Return the combinations of factors to use to tile nb_levels loop levels, starting from node
+     * and following the first child of each level. The combinations come from tiling_factors_gen
+     * if it is set, otherwise from tiling_factors_list.
+     */
+    std::vector<std::vector<int>> get_tiling_factors(ast_node *node, int nb_levels, syntax_tree const& ast) const;
 
 public:
     schedules_generator(std::vector<int> const& tiling_factors_list = TILING_FACTORS_DEFAULT_LIST,
                         std::vector<int> const& unrolling_factors_list = UNROLLING_FACTORS_DEFAULT_LIST)
         
         : tiling_factors_list(tiling_factors_list), unrolling_factors_list(unrolling_factors_list) {}
+        
+    void set_vectorization_factors(std::vector<int> const& vectorization_factors_list) { this->vectorization_factors_list = vectorization_factors_list; }
+    void set_tiling_factors_generator(tiling_factors_generator *tiling_factors_gen) { this->tiling_factors_gen = tiling_factors_gen; }
+    
+    void set_check_legality(bool check_legality) { this->check_legality = check_legality; }
+    int get_nb_pruned_schedules() const { return nb_pruned_schedules; }
 
     virtual ~schedules_generator() {}
 
+    /**
+     * Return true if generate_schedules() can apply the given optimization.
+     * The search methods skip the optimizations that are not supported.
+     */
+    virtual bool supports_optimization(optimization_type optim) const { return true; }
+
     /**
      * Given an AST, and an optimization to apply, 
      * generate new ASTs by applying the given optimization.
@@ -47,7 +201,7 @@ public:
 
 /**
  * Generate all combinations of the following optimizations :
- * Fusion, tiling, interchange, unrolling.
+ * Fusion, compute_at, tiling, interchange, unrolling, parallelization, vectorization.
  */
 class exhaustive_generator : public schedules_generator
 {
@@ -77,6 +231,26 @@ protected:
      * apply unrolling recursively on children of the given node.
      */
     void generate_unrollings(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast);
+    
+    /**
+     * Try to parallelize the given node if none of its ancestors is parallelized,
+     * and then call this method recursively on children of the given node.
+     */
+    void generate_parallelizations(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast);
+    
+    /**
+     * Try to vectorize the given node if it is an innermost loop level,
+     * and then call this method recursively on children of the given node.
+     */
+    void generate_vectorizations(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast);
+    
+    /**
+     * For each computation that is alone in its loop nest, and whose buffer is only read by
+     * one computation of a later loop nest, compute it at each loop level of its consumer.
+     * Each compute_at is generated twice : the producer either keeps its buffer, or is stored
+     * in a buffer only large enough for one iteration of the compute_at level.
+     */
+    void generate_compute_ats(std::vector<syntax_tree*>& states, syntax_tree const& ast);
 
 public:
     exhaustive_generator(std::vector<int> const& tiling_factors_list = TILING_FACTORS_DEFAULT_LIST,
@@ -84,13 +258,15 @@ public:
         
         : schedules_generator(tiling_factors_list, unrolling_factors_list) {}
 
+    virtual bool supports_optimization(optimization_type optim) const { return optim != optimization_type::UNFUSE; }
+
     virtual std::vector<syntax_tree*> generate_schedules(syntax_tree const& ast, optimization_type optim);
 };
 
 /**
  * Generate unfuse applied to shared loop levels.
- * Generate tilings and interchanges applied to shared loop levels.
- * Generate unrollings applied to innermost loop levels.
+ * Generate tilings, interchanges and parallelizations applied to shared loop levels.
+ * Generate unrollings and vectorizations applied to innermost loop levels.
  */
 class ml_model_schedules_generator : public schedules_generator
 {
@@ -109,6 +285,11 @@ public:
         
         : schedules_generator(tiling_factors_list, unrolling_factors_list),    
           max_nb_iterators(max_nb_iterators) {}
+          
+    virtual bool supports_optimization(optimization_type optim) const
+    {
+        return optim != optimization_type::FUSION && optim != optimization_type::COMPUTE_AT;
+    }
         
     virtual std::vector<syntax_tree*> generate_schedules(syntax_tree const& ast, optimization_type optim);
 };
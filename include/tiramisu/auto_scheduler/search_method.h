@@ -3,20 +3,43 @@
 
 #include <climits>
 #include <cfloat>
+#include <chrono>
+#include <random>
 
 #include "auto_scheduler.h"
 #include "schedules_generator.h"
 #include "evaluator.h"
+#include "evaluation_cache.h"
+#include "checkpoint.h"
+#include "telemetry.h"
 #include "utils.h"
 
 namespace tiramisu::auto_scheduler
 {
 
-const std::vector<optimization_type> DEFAULT_OPTIMIZATIONS_ORDER = {UNFUSE, INTERCHANGE, TILING, UNROLLING};
+const std::vector<optimization_type> DEFAULT_OPTIMIZATIONS_ORDER = {COMPUTE_AT, UNFUSE, INTERCHANGE, TILING, PARALLELIZE, VECTORIZE, UNROLLING};
 
 const int NB_OPTIMIZATIONS = DEFAULT_OPTIMIZATIONS_ORDER.size();
 const int DEFAULT_MAX_DEPTH = INT_MAX;
 
+/**
+ * The resources a search method is allowed to use.
+ * A limit equal to 0 means that the resource is not limited.
+ */
+struct search_budget
+{
+    /**
+     * Maximum wall-clock time of the search, in seconds.
+     */
+    double max_time = 0;
+    
+    /**
+     * Maximum number of compilations and of executions of schedules.
+     */
+    int max_compilations = 0;
+    int max_executions = 0;
+};
+
 /**
   * An abstract class that represents a search method.
   * Derive this class and give an implementation of
@@ -54,24 +77,240 @@ protected:
      */
     syntax_tree *best_ast = nullptr;
     
+    /**
+     * True if best_ast is not used by the search anymore, and must be deleted
+     * by the search method when a better AST is found, or when the search method is deleted.
+     */
+    bool owns_best_ast = false;
+    
     /**
      * An evaluator returning the execution time of a program.
      * Not mandatory, can be usefull for some search methods (like MCTS).
      */
     evaluate_by_execution *exec_eval = nullptr;
     
+    /**
+     * If not null, the evaluations of eval_func are stored in this cache,
+     * and a schedule already in the cache is not evaluated again.
+     */
+    evaluation_cache *eval_cache = nullptr;
+    
+    /**
+     * The budget of the search. When it is exhausted, the search stops,
+     * and best_ast contains the best AST found so far.
+     */
+    search_budget budget;
+    
+    /**
+     * The time at which the budget started to be consumed.
+     */
+    std::chrono::steady_clock::time_point budget_start = std::chrono::steady_clock::now();
+    
+    /**
+     * If not null, the state of the search is saved periodically to this checkpoint.
+     */
+    search_checkpoint *checkpoint = nullptr;
+    
+    /**
+     * If not null, the execution times measured by exec_eval are stored in this cache,
+     * and a schedule already in the cache is not executed again.
+     */
+    evaluation_cache *exec_cache = nullptr;
+    
+    /**
+     * The budget consumed by the previous runs of a resumed search.
+     */
+    double resumed_time = 0;
+    int resumed_compilations = 0;
+    int resumed_executions = 0;
+    
+    /**
+     * If not null, a cheap evaluation function (e.g. evaluate_by_cost_model)
+     * used to evaluate the most promising children first.
+     */
+    evaluation_function *ranking_func = nullptr;
+    
+    /**
+     * Time in seconds spent by each phase of the search : generating schedules,
+     * evaluating them with eval_func, and executing the best schedules at the end of the search.
+     */
+    double generation_time = 0;
+    double evaluation_time = 0;
+    double final_exec_time = 0;
+    
+    /**
+     * If not null, every schedule evaluated by eval_func or executed by exec_eval is recorded here.
+     */
+    search_telemetry *telemetry = nullptr;
+    
+    /**
+     * The value of generation_time when schedules were last recorded to telemetry.
+     */
+    double recorded_generation_time = 0;
+    
+    /**
+     * Evaluate the given ASTs with eval_func, and return their evaluations.
+     * ASTs found in eval_cache are not evaluated, and each schedule
+     * is given only once to eval_func.
+     */
+    std::vector<float> evaluate_schedules(std::vector<syntax_tree*> const& asts);
+    
+    /**
+     * Subroutine of evaluate_schedules() used when eval_cache is not null.
+     * evaluated[i] is set to false if asts[i] was not given to eval_func.
+     */
+    std::vector<float> evaluate_schedules_with_cache(std::vector<syntax_tree*> const& asts, std::vector<bool>& evaluated);
+    
+    /**
+     * Record to telemetry the given ASTs, evaluated by func in batch_time seconds.
+     * evaluated[i] is false if the evaluation of asts[i] was found in a cache.
+     * The time spent generating schedules since the last record is shared among the ASTs.
+     */
+    void record_candidates(std::vector<syntax_tree*> const& asts, std::vector<float> const& evals,
+                           std::vector<bool> const& evaluated, evaluation_function *func, double batch_time);
+    
+    /**
+     * Return true if a has a better evaluation than b, and if their
+     * confidence intervals don't overlap. Otherwise, a and b are considered tied.
+     */
+    static bool is_better(syntax_tree const& a, syntax_tree const& b)
+    {
+        return a.evaluation + a.evaluation_ci < b.evaluation - b.evaluation_ci;
+    }
+    
+    /**
+     * Sort the given ASTs from the best evaluation to the worst.
+     * ASTs tied with the best AST of their group are sorted by their number of optimizations,
+     * so that noise in the evaluations doesn't decide their order.
+     */
+    static void sort_by_evaluation(std::vector<syntax_tree*>& asts);
+    
+    /**
+     * Return true if the evaluation of the given AST by eval_func is an estimate,
+     * either from its last evaluation or from the evaluation found in eval_cache.
+     */
+    bool is_estimated(syntax_tree const& ast) const;
+    
+    /**
+     * Return the optimizations of DEFAULT_OPTIMIZATIONS_ORDER that scheds_gen supports,
+     * in this order. Unsupported optimizations are skipped, so that they don't count
+     * against the maximum depth of the search.
+     */
+    std::vector<optimization_type> get_optimizations_order() const;
+    
+    /**
+     * Replace best_ast by the given AST if the given AST is better (see is_better()).
+     */
+    void update_best_ast(syntax_tree *ast);
+    
+    /**
+     * Called when the search doesn't need the given AST anymore.
+     * The AST is deleted, unless it is best_ast, in which case it is kept until a better AST is found.
+     */
+    void release_ast(syntax_tree *ast);
+    
+    /**
+     * Execute the topk first distinct schedules of the given list with exec_eval, and set best_ast
+     * to the fastest one. The schedules must be sorted from the most promising to the least promising :
+     * a schedule only replaces a previous one if it is faster and their confidence intervals don't overlap.
+     * The current best_ast (e.g. restored from a checkpoint) is executed first, and is only replaced
+     * by a faster schedule. If no schedule can be executed, best_ast is kept, or set to the first
+     * schedule if there is none.
+     * Without exec_eval, best_ast is only replaced by a schedule with a better evaluation.
+     */
+    void execute_best_schedules(std::vector<syntax_tree*> const& schedules, int topk);
+    
+    /**
+     * Sort the given children from the most promising to the least promising with ranking_func,
+     * and delete the children that the remaining budget doesn't allow to evaluate.
+     */
+    void prioritize_children(std::vector<syntax_tree*>& children);
+    
+    /**
+     * Return true if the search must stop because its budget is exhausted.
+     */
+    bool budget_exhausted() const;
+    
+    /**
+     * Return the number of compilations and executions done by eval_func and exec_eval.
+     */
+    int get_nb_compilations() const;
+    int get_nb_executions() const;
+    
+    /**
+     * Return the number of seconds elapsed since the budget started to be consumed.
+     */
+    double get_elapsed_time() const
+    {
+        return resumed_time + std::chrono::duration<double>(std::chrono::steady_clock::now() - budget_start).count();
+    }
+    
+    /**
+     * Return the execution time of the given AST measured by exec_eval, and store the half-width
+     * of its confidence interval in exec_ci. If exec_cache is not null, it is used to avoid
+     * executing the schedule again (exec_ci is then 0).
+     */
+    float execute_schedule(syntax_tree& ast, float& exec_ci);
+    
+    /**
+     * Return the execution times of the given ASTs. The ASTs not found in exec_cache are executed in one batch.
+     */
+    std::vector<float> execute_schedules(std::vector<syntax_tree*> const& asts);
+    
 public:
     search_method(evaluation_function *eval_func = nullptr, schedules_generator *scheds_gen = nullptr)
         : eval_func(eval_func), scheds_gen(scheds_gen) {}
             
-    virtual ~search_method() {}
+    virtual ~search_method()
+    {
+        if (owns_best_ast)
+            delete best_ast;
+    }
 
     int get_nb_explored_schedules() const { return nb_explored_schedules; }
     float get_best_evaluation() const { return best_evaluation; }
     syntax_tree* get_best_ast() const { return best_ast; }
     
+    schedules_generator* get_schedules_generator() const { return scheds_gen; }
+    
     void set_eval_func(evaluation_function *eval_func) { this->eval_func = eval_func; }
     void set_exec_eval(evaluate_by_execution *exec_eval) { this->exec_eval = exec_eval; }
+    
+    evaluation_cache* get_evaluation_cache() const { return eval_cache; }
+    void set_evaluation_cache(evaluation_cache *eval_cache) { this->eval_cache = eval_cache; }
+    
+    search_budget const& get_budget() const { return budget; }
+    void set_budget(search_budget const& budget) { this->budget = budget; }
+    void set_ranking_func(evaluation_function *ranking_func) { this->ranking_func = ranking_func; }
+    
+    search_telemetry* get_telemetry() const { return telemetry; }
+    void set_telemetry(search_telemetry *telemetry) { this->telemetry = telemetry; }
+    
+    /**
+     * Start consuming the budget : the wall-clock time is counted from now.
+     * Called by auto_scheduler::find_schedule() before the search.
+     */
+    void start_budget() { budget_start = std::chrono::steady_clock::now(); }
+    
+    /**
+     * Print the budget used by the search, and the time spent by each phase.
+     */
+    void print_budget_report() const;
+    
+    /**
+     * Save the state of the search to the given checkpoint from now on, and resume
+     * from the state it contains (see search_checkpoint).
+     * initial_ast is the unscheduled AST of the program, used to rebuild the best schedule.
+     * The evaluation cache and the execution cache of the checkpoint are used,
+     * unless an evaluation cache was already given.
+     */
+    void set_checkpoint(search_checkpoint *checkpoint, syntax_tree const& initial_ast);
+    
+    /**
+     * Save the state of the search to the checkpoint.
+     * Search methods call this when they evaluate schedules, at most once per checkpoint interval.
+     */
+    void save_checkpoint();
         
     /**
       * The method to call to start a search.
@@ -109,7 +348,20 @@ public:
 };
 
 /**
- * Implements the MCTS search method.
+ * Implements the MCTS search method, with UCT selection.
+ *
+ * The search tree is kept during the whole search. At each iteration :
+ *  - Selection : starting from the root, the child maximizing the UCT score is selected,
+ *    until reaching a node that is not expanded yet.
+ *  - Expansion : the children of this node are generated and evaluated with eval_func.
+ *    Each node is evaluated only once.
+ *  - Rollout : if rollout_func is given, optimizations are applied greedily on the
+ *    best child according to rollout_func (e.g. evaluate_by_cost_model), to estimate
+ *    how much the child can still be improved.
+ *  - Backpropagation : the value found is added to the nodes of the path.
+ *
+ * At the end of the search, the topk schedules with the best evaluations are executed
+ * with exec_eval (if given), and the best of them is returned.
  */
 class mcts : public search_method
 {
@@ -117,7 +369,35 @@ private:
 
 protected:
     /**
-     * The number of times to sample schedules from the search tree.
+     * A node of the search tree.
+     */
+    struct mcts_node
+    {
+        syntax_tree *ast;
+        mcts_node *parent;
+        std::vector<mcts_node*> children;
+        
+        /**
+         * True if the children of this node have been generated.
+         * A terminal node has been expanded, but has no children.
+         */
+        bool expanded = false;
+        
+        /**
+         * Number of times this node has been visited, and sum of the values
+         * backpropagated through this node (values are evaluations, lower is better).
+         */
+        int nb_visits = 0;
+        double total_value = 0;
+        
+        mcts_node(syntax_tree *ast, mcts_node *parent)
+            : ast(ast), parent(parent) {}
+        
+        double get_mean_value() const { return total_value / nb_visits; }
+    };
+    
+    /**
+     * The number of iterations of the search (each iteration expands a node).
      */
     int nb_samples;
     
@@ -131,6 +411,66 @@ protected:
      * The maximum depth of the search tree.
      */
     int max_depth;
+    
+    /**
+     * The exploration constant of UCT.
+     */
+    double exploration_constant = 1.41;
+    
+    /**
+     * The seed of the random generator used to break ties between children.
+     */
+    unsigned int seed = 0;
+    std::mt19937 rand_generator;
+    
+    /**
+     * If not null, a cheap evaluation function used to do rollouts.
+     */
+    evaluation_function *rollout_func = nullptr;
+    
+    /**
+     * The smallest and largest evaluations found in the tree (failed evaluations excluded).
+     * Used to normalize values between 0 and 1.
+     */
+    float min_evaluation = FLT_MAX;
+    float max_evaluation = -FLT_MAX;
+    
+    /**
+     * Starting from ast, try the optimizations of get_optimizations_order()
+     * until some children are generated, and return these children transformed.
+     * nb_explored_optims is set to the number of optimizations explored by the children.
+     */
+    std::vector<syntax_tree*> generate_children(syntax_tree& ast, int& nb_explored_optims);
+    
+    /**
+     * Starting from the root, select the node to expand with UCT.
+     */
+    mcts_node* select(mcts_node *root);
+    
+    /**
+     * Generate and evaluate the children of the given node.
+     */
+    void expand(mcts_node *node);
+    
+    /**
+     * Return an estimation of the best evaluation that can be reached from the given node.
+     */
+    double rollout(mcts_node *node);
+    
+    /**
+     * Add the given value to the node and to its ancestors.
+     */
+    void backpropagate(mcts_node *node, double value);
+    
+    /**
+     * Return the UCT score of the given child.
+     */
+    double get_uct_score(mcts_node const *child) const;
+    
+    /**
+     * Update min_evaluation and max_evaluation with the given evaluation.
+     */
+    void update_evaluation_bounds(float evaluation);
 
 public:
     mcts(int nb_samples, int topk, int max_depth = DEFAULT_MAX_DEPTH, evaluation_function *eval_func = nullptr, evaluate_by_execution *exec_eval = nullptr, schedules_generator *scheds_gen = nullptr)
@@ -140,6 +480,136 @@ public:
         
     virtual ~mcts() {}
     
+    void set_exploration_constant(double exploration_constant) { this->exploration_constant = exploration_constant; }
+    void set_seed(unsigned int seed) { this->seed = seed; }
+    void set_rollout_func(evaluation_function *rollout_func) { this->rollout_func = rollout_func; }
+    
+    virtual void search(syntax_tree& ast);
+};
+
+/**
+ * Implements an evolutionary search.
+ *
+ * An individual is a sequence of genes, one for each optimization of get_optimizations_order().
+ * To get the schedule of an individual, the optimizations are applied in order on the initial AST :
+ * at each step, the gene chooses one of the schedules generated by scheds_gen, or chooses to skip the optimization.
+ * Since scheds_gen only generates legal schedules, crossover and mutation always give legal schedules.
+ *
+ * At each generation, the schedules of the population are evaluated all at once by eval_func.
+ * The nb_elites best individuals are kept, and the others are replaced by children of parents
+ * chosen by tournament selection.
+ *
+ * At the end of the search, the topk schedules with the best evaluations are executed
+ * with exec_eval (if given), and the best of them is returned.
+ */
+class evolutionary_search : public search_method
+{
+private:
+
+protected:
+    /**
+     * An individual of the population.
+     */
+    struct individual
+    {
+        std::vector<int> genes;
+        
+        /**
+         * The schedule of this individual, nullptr if it has not been computed yet.
+         */
+        syntax_tree *ast = nullptr;
+        float evaluation = FLT_MAX;
+    };
+    
+    /**
+     * The number of individuals of the population.
+     */
+    int population_size;
+    
+    /**
+     * The number of generations to evolve.
+     */
+    int nb_generations;
+    
+    /**
+     * The number of schedules to execute at the end of the search
+     * to return the best schedule.
+     */
+    int topk;
+    
+    /**
+     * The maximum number of optimizations applied on the initial AST.
+     */
+    int max_depth;
+    
+    /**
+     * The number of best individuals copied unchanged to the next generation.
+     */
+    int nb_elites = 2;
+    
+    /**
+     * The number of individuals compared to choose a parent.
+     */
+    int tournament_size = 3;
+    
+    /**
+     * The probability to cross two parents, and the probability to mutate each gene.
+     */
+    double crossover_rate = 0.9;
+    double mutation_rate = 0.1;
+    
+    /**
+     * The seed of the random generator.
+     */
+    unsigned int seed = 0;
+    std::mt19937 rand_generator;
+    
+    /**
+     * The topk best schedules found so far, sorted from the best to the worst.
+     * These are copies owned by the search, best_ast is only chosen among them
+     * by execute_best_schedules() at the end of the search.
+     */
+    std::vector<syntax_tree*> best_schedules;
+    
+    /**
+     * Return a random gene.
+     */
+    int get_random_gene();
+    
+    /**
+     * Apply the optimizations chosen by the given genes on a copy of ast, and return the copy.
+     */
+    syntax_tree* decode(syntax_tree const& ast, std::vector<int> const& genes);
+    
+    /**
+     * Compute the schedules of the individuals that don't have one, and evaluate them all at once.
+     */
+    void evaluate_population(syntax_tree const& ast, std::vector<individual>& population);
+    
+    /**
+     * Choose a parent with tournament selection.
+     */
+    individual const& select_parent(std::vector<individual> const& population);
+    
+    /**
+     * Add the schedule of the given individual to best_schedules if it is among the topk best.
+     */
+    void update_best_schedules(individual const& indiv);
+
+public:
+    evolutionary_search(int population_size, int nb_generations, int topk, int max_depth = DEFAULT_MAX_DEPTH, evaluation_function *eval_func = nullptr, evaluate_by_execution *exec_eval = nullptr, schedules_generator *scheds_gen = nullptr)
+        : search_method(eval_func, scheds_gen), population_size(population_size), 
+          nb_generations(nb_generations), topk(topk), max_depth(max_depth)
+    { set_exec_eval(exec_eval); }
+    
+    virtual ~evolutionary_search() {}
+    
+    void set_nb_elites(int nb_elites) { this->nb_elites = nb_elites; }
+    void set_tournament_size(int tournament_size) { this->tournament_size = tournament_size; }
+    void set_crossover_rate(double crossover_rate) { this->crossover_rate = crossover_rate; }
+    void set_mutation_rate(double mutation_rate) { this->mutation_rate = mutation_rate; }
+    void set_seed(unsigned int seed) { this->seed = seed; }
+    
     virtual void search(syntax_tree& ast);
 };
 
@@ -230,6 +700,16 @@ public:
         for (int i = 0; i < model_evals_list.size(); ++i)
             std::cout << model_evals_list[i] << " " << exec_evals_list[i] << std::endl;
     }
+    
+    /**
+     * Print how well the evaluations of the model rank the schedules,
+     * compared to their execution times :
+     *  - Spearman's rank correlation between the two lists of evaluations.
+     *  - The percentage of pairs of schedules ordered the same way by the model and by execution.
+     *  - The execution time of the schedule preferred by the model, compared to the best execution time.
+     * Schedules that could not be executed are ignored.
+     */
+    void print_accuracy_report() const;
 };
 
 }
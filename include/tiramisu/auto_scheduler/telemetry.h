@@ -0,0 +1,79 @@
+#ifndef _TIRAMISU_AUTO_SCHEDULER_TELEMETRY_
+#define _TIRAMISU_AUTO_SCHEDULER_TELEMETRY_
+
+#include <cstdio>
+#include <cfloat>
+
+#include "ast.h"
+#include "evaluator.h"
+#include "utils.h"
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * Records every schedule evaluated by a search method, one JSON object per line :
+ *
+ *   {"time": 12.5, "schedule": "...", "optimizations": ["I(L0,L1)", ...],
+ *    "predicted": 1.2, "measured": 3.4, "ci": 0.1, "cached": false,
+ *    "phases": {"transform": ..., "scheduling": ..., ...}}
+ *
+ * "time" is the wall-clock time of the search in seconds when the schedule was evaluated.
+ * "predicted" is the evaluation of an evaluation function that doesn't execute the schedule
+ * (e.g. the learning model), "measured" is an execution time in milliseconds.
+ * Each of them is null when it is not known. "cached" is true if the evaluation was found
+ * in an evaluation cache, the phases then contain no time.
+ * Phase times are in seconds (see evaluation_phases).
+ *
+ * The trace can be used to find where the tuning time goes, and as training data for a model.
+ */
+class search_telemetry
+{
+private:
+
+protected:
+    /**
+     * The file where candidates are written (nullptr if it couldn't be opened).
+     */
+    FILE *trace_file = nullptr;
+
+    /**
+     * Total time spent by each phase, and number of candidates recorded.
+     */
+    evaluation_phases total_phases;
+    int nb_candidates = 0;
+    int nb_cached_candidates = 0;
+
+    /**
+     * The best measured value so far (or the best predicted value if nothing was measured),
+     * and the wall-clock times at which it improved.
+     */
+    float best_measured = FLT_MAX;
+    float best_predicted = FLT_MAX;
+    std::vector<std::pair<double, float>> best_measured_curve;
+    std::vector<std::pair<double, float>> best_predicted_curve;
+
+public:
+    /**
+     * Open the given file for writing. If append is true, the candidates are added
+     * to the end of the file (e.g. when resuming a search from a checkpoint).
+     */
+    search_telemetry(std::string const& trace_path, bool append = false);
+
+    ~search_telemetry();
+
+    /**
+     * Record a candidate. predicted and measured are FLT_MAX when they are not known.
+     */
+    void record_candidate(syntax_tree const& ast, double time, float predicted, float measured,
+                          float ci, bool cached, evaluation_phases const& phases);
+
+    /**
+     * Print the time spent by each phase, and the best value found against wall-clock time.
+     */
+    void print_summary() const;
+};
+
+}
+
+#endif
@@ -2,10 +2,19 @@
 #define _TIRAMISU_AUTO_SCHEDULER_UTILS_
 
 #include <vector>
+#include <string>
+#include <map>
+#include <cstdint>
 
 namespace tiramisu::auto_scheduler
 {
 
+/**
+ * A value for each symbolic parameter of a program, for example {{"N", 1024}}.
+ * Used to build the AST of a program whose loop bounds depend on parameters.
+ */
+typedef std::map<std::string, int> parameters_values;
+
 /**
  * Return true if an iterator having extent = it_extent can
  * be split perfectly by a factor = split_fact.
@@ -15,6 +24,24 @@ inline bool can_split_iterator(int it_extent, int split_fact)
     return it_extent > split_fact && it_extent % split_fact == 0;
 }
 
+/**
+ * Return a 64-bit FNV-1a hash of the given string.
+ * Unlike std::hash, the result is the same from one execution to another,
+ * so it can be stored on disk.
+ */
+inline uint64_t hash_string(std::string const& str)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    
+    for (unsigned char c : str)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    
+    return hash;
+}
+
 }
 
 #endif
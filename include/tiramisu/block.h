@@ -90,6 +90,7 @@ public:
     void unroll(int L, int fac) override;
     void vectorize(var L, int v) override;
     void vectorize(var L, int v, var L_outer, var L_inner) override;
+    void vectorize(int L, int v) override;
     // @}
 };  // class block
 
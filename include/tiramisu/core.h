@@ -22,6 +22,7 @@
 #include <tiramisu/debug.h>
 #include <tiramisu/expr.h>
 #include <tiramisu/type.h>
+#include <tiramisu/jit.h>
 #include "cuda_ast.h"
 
 namespace tiramisu
@@ -48,9 +49,14 @@ class ast_node;
 class computation_info;
 class evaluate_by_execution;
 class dnn_access_matrix;
+class dnn_iterator;
 class simple_generator;
+class schedules_generator;
+class tiling_factors_generator;
 
 void unroll_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int unroll_fact);
+void vectorize_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int vector_len);
+void apply_compute_at(syntax_tree const& ast);
 }
 
 struct HalideCodegenOutput
@@ -138,9 +144,21 @@ void codegen(const std::vector<tiramisu::buffer *> &arguments, const std::string
 
 //*******************************************************
 
-void codegen_select_schedule_number(int schedule_number,
+/**
+  * \brief Generate code using a schedule saved in a schedules file.
+  * \details Load the schedule number \p schedule_number (starting from 0) from
+  * the file \p path_name, written by codegen_write_potential_schedules() or by the
+  * auto-scheduler, and generate code with it. The schedules specified in the
+  * generator are replaced, and no legality check is done.
+  */
+void codegen_select_schedule_number(std::string const& path_name, int schedule_number,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt = false);
 
+/**
+  * \brief Save the current schedule and generate code.
+  * \details The schedule of the implicit function is appended to the schedules
+  * file \p path_name, then code is generated as done by codegen().
+  */
 void codegen_write_potential_schedules(std::string& path_name,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt = false) ;
 
@@ -161,7 +179,10 @@ class function
     friend auto_scheduler::syntax_tree;
     friend auto_scheduler::evaluate_by_execution;
     friend auto_scheduler::dnn_access_matrix;
+    friend auto_scheduler::dnn_iterator;
     friend auto_scheduler::simple_generator;
+    friend auto_scheduler::schedules_generator;
+    friend auto_scheduler::tiling_factors_generator;
 
 private:
     /**
@@ -330,6 +351,50 @@ private:
       */
     Halide::Internal::Stmt halide_stmt;
 
+    /**
+      * True if incremental code generation is enabled (see set_incremental_codegen()).
+      */
+    bool incremental_codegen = false;
+
+    /**
+      * A root-level loop nest generated by incremental code generation :
+      * its isl AST and the Halide statement generated from it (undefined
+      * until gen_halide_stmt() is called).
+      */
+    struct codegen_group
+    {
+        isl_ast_node *ast;
+        Halide::Internal::Stmt stmt;
+    };
+
+    /**
+      * The root-level loop nests generated by incremental code generation,
+      * identified by the fingerprint of their computations.
+      */
+    std::map<std::string, codegen_group> codegen_groups_cache;
+
+    /**
+      * The fingerprints of the root-level loop nests of the function, in their
+      * order of execution, computed by the last call to gen_isl_ast() when
+      * incremental code generation is enabled.
+      */
+    std::vector<std::string> codegen_groups;
+
+    /**
+      * Fingerprint of what the code of every loop nest depends on (buffers,
+      * invariants, context, access relations). The cache of loop nests is
+      * cleared when it changes.
+      */
+    std::string codegen_groups_cache_base;
+
+    /**
+      * The modules compiled by jit_compile(), identified by the key of their
+      * lowered Halide module (see object_cache::get_key()), and the last one.
+      * The cache is an LRU list : the most recently used module is at its front.
+      */
+    std::list<std::pair<std::string, jit_function>> jit_functions_cache;
+    jit_function last_jit_function;
+
     /**
       * A map representing the buffers of the function. Some of these
       * buffers are passed to the function as arguments and some are
@@ -395,6 +460,42 @@ private:
      */
     void remove_dimension_tags();
 
+    /**
+      * Build an isl AST from the schedule \p umap, which maps the
+      * time-processor domain of computations to their execution order.
+      * Takes ownership of \p umap.
+      */
+    isl_ast_node *gen_isl_ast_from_schedule(isl_union_map *umap);
+
+    /**
+      * Return a string that identifies everything the code of a loop nest
+      * depends on apart from its computations : the context, the iterator names,
+      * the invariants, the buffers and the access relations of all computations.
+      */
+    std::string get_codegen_base_fingerprint() const;
+
+    /**
+      * Return a string that identifies the code generated for the computation
+      * \p comp : its name, expression, predicate, time-processor domain and the
+      * tags of its loop levels.
+      */
+    std::string get_codegen_fingerprint(computation *comp) const;
+
+    /**
+      * Split the scheduled computations of the function into its root-level loop
+      * nests (computations that have the same value in the outermost dimension of
+      * their time-processor domain), in their order of execution.
+      * A single group is returned if the function can't be split safely (let
+      * statements, allocate/free/memcpy operations and GPU mappings may
+      * span several loop nests).
+      */
+    std::vector<std::vector<computation *>> get_root_level_groups() const;
+
+    /**
+      * Generate the isl AST of the function incrementally (see set_incremental_codegen()).
+      */
+    void gen_isl_ast_incrementally();
+
     /**
      * Get live in/out computations in the function.
      */
@@ -1165,12 +1266,124 @@ public:
     void codegen(const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt = false);
     void codegen(const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const tiramisu::hardware_architecture_t gen_architecture_flag);
 
-    void codegen_select_schedule_number(int schedule_number,
+    /**
+      * \brief Compile the function in memory with Halide's JIT.
+      * \details Generate the code of the function like codegen() does, but
+      * compile it for the host in the current process instead of generating an
+      * object file. \p arguments are the arguments of the function, as in codegen().
+      * The returned jit_function can be called with Halide buffers.
+      *
+      * The compiled modules are cached : if the lowered Halide module is the same as
+      * in a previous call (e.g. because the schedule did not change), it is not
+      * compiled again.
+      */
+    jit_function jit_compile(const std::vector<tiramisu::buffer *> &arguments);
+
+    /**
+      * \overload
+      * Use the arguments set by set_arguments() or by a previous code generation.
+      */
+    jit_function jit_compile();
+
+    /**
+      * \brief Compile with the JIT a variant of the function specialized for
+      * the given values of its parameters.
+      * \details \p parameter_values are pairs of a parameter name and its value.
+      * The parameters are fixed by context constraints (see add_context_constraints()),
+      * so the loop bounds that depend on them become constants. The context of the
+      * function and the function returned by run() are restored afterwards.
+      * The specialized code must only be run with these values of the parameters.
+      */
+    jit_function jit_compile_specialized(const std::vector<std::pair<std::string, int64_t>> &parameter_values);
+
+    /**
+      * \brief Run the function on \p buffers in the current process.
+      * \details The function is compiled by jit_compile() on the first call, then
+      * the last compiled function is reused (call jit_compile() again after
+      * changing the schedule). \p buffers are given in the order of the arguments.
+      * Return 0 on success, or the error code of the function.
+      */
+    int run(std::vector<Halide::Buffer<>> const& buffers);
+
+    void codegen_select_schedule_number(std::string const& path_name, int schedule_number,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt = false);
 
     void codegen_write_potential_schedules(std::string& path_name,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt = false) ;
 
+    /**
+      * \brief Append the current schedule of the function to a schedules file.
+      * \details A schedules file contains a list of schedules, numbered from 0
+      * in the order they were appended. A schedule is stored as the time-space
+      * schedule map of each computation (in the order of the body of the function,
+      * after the ordering given by .after() and .then() is applied), and the tags of
+      * the loop levels (parallel, vector, unroll, distributed and GPU dimensions).
+      * Each schedule has the following form :
+      *
+      * \code
+      * schedule <number>
+      * buffer <name> <type> <size0> ... <sizeN>
+      * computation <name> <ISL schedule map>
+      * definition <name> <ISL schedule map>
+      * duplicate <name> <ISL schedule map>
+      * allocation <buffer> <consumer> <level> <ISL schedule map>
+      * access <name> <ISL access map>
+      * parallel <name> <level>
+      * vector <name> <level> <length>
+      * unroll <name> <level> <factor>
+      * distributed <name> <level>
+      * gpu_block <name> <level0> <level1> <level2>
+      * gpu_thread <name> <level0> <level1> <level2>
+      * end
+      * \endcode
+      *
+      * Computations added to the function by the schedule are saved with what is
+      * needed to add them again : "definition" for the definitions added by separate(),
+      * "duplicate" for the duplicates added by compute_at(), and "allocation" for the
+      * allocations added by allocate_at(). The temporary buffers of constant size
+      * ("buffer") and the access relations to these buffers ("access") are saved too,
+      * as compute_at() is usually combined with store_in() on a smaller buffer.
+      *
+      * Return the number of the saved schedule, or -1 if the file can't be written.
+      */
+    int save_schedule(std::string const& path_name);
+
+    /**
+      * \brief Replace the schedule of the function by a schedule saved by save_schedule().
+      * \details The saved schedule maps are set as low level schedules, so that
+      * code generation uses them as they are, without dependence analysis or ordering.
+      * The computations of the function must be the same as when the schedule was saved.
+      * The computations, buffers and access relations added by the schedule are added
+      * again before the schedule maps are set.
+      * Return false if the schedule can't be found or doesn't match the function.
+      */
+    bool load_schedule(std::string const& path_name, int schedule_number);
+
+    /**
+      * \brief Enable or disable incremental code generation.
+      * \details When the same function is generated many times with different
+      * schedules (e.g. by the auto-scheduler), most of its loop nests usually
+      * keep the same schedule. With incremental code generation,
+      * gen_time_space_domain() keeps the time-processor domain of the computations
+      * whose schedule didn't change, and gen_isl_ast() and gen_halide_stmt() generate
+      * each root-level loop nest of the function separately. The isl AST and the
+      * Halide statement of a loop nest are cached with a fingerprint of its
+      * computations (schedule, tags, expressions), and are reused as long as the
+      * fingerprint doesn't change. A change to the buffers, the invariants or the
+      * access relations invalidates all the loop nests.
+      *
+      * Incremental code generation is disabled by default, and is not supported
+      * by gen_cuda_stmt(). Disabling it keeps the cached loop nests, so that
+      * they are reused when it is enabled again (e.g. by the auto-scheduler,
+      * which only enables it while it compiles a schedule).
+      */
+    void set_incremental_codegen(bool incremental);
+
+    /**
+      * Return true if incremental code generation is enabled.
+      */
+    bool is_incremental_codegen_set() const;
+
     /**
      * \brief Set the context of the function.
      * \details A context is an ISL set that represents constraints over the
@@ -1616,9 +1829,13 @@ class computation
     friend auto_scheduler::syntax_tree;
     friend auto_scheduler::ast_node;
     friend auto_scheduler::computation_info;
+    friend auto_scheduler::dnn_iterator;
     friend auto_scheduler::evaluate_by_execution;
+    friend auto_scheduler::schedules_generator;
     
     friend void auto_scheduler::unroll_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int unroll_fact);
+    friend void auto_scheduler::vectorize_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int vector_len);
+    friend void auto_scheduler::apply_compute_at(auto_scheduler::syntax_tree const& ast);
 
 private:
 
@@ -1814,6 +2031,17 @@ private:
       */
     isl_set *time_processor_domain;
 
+    /**
+      * The schedule, iteration domain and context from which time_processor_domain
+      * was computed. When incremental code generation is enabled, the time-processor
+      * domain is only computed again if one of them changed.
+      */
+    // @{
+    isl_map *time_processor_domain_schedule = NULL;
+    isl_set *time_processor_domain_iteration_domain = NULL;
+    isl_set *time_processor_domain_context = NULL;
+    // @}
+
     /**
      * The shape of the thread block that this computation is mapped to in case
      * a gpu_tile operation is done.
@@ -4542,6 +4770,7 @@ public:
     // @{
     virtual void vectorize(var L, int v);
     virtual void vectorize(var L, int v, var L_outer, var L_inner);
+    virtual void vectorize(int L, int v);
     // @}
 
     /**
@@ -15,6 +15,7 @@
 #include <vector>
 #include <string.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <type_traits>
 
 #include <Halide.h>
@@ -66,6 +67,18 @@ private:
       */
     static function *implicit_fct;
 
+    /**
+      * Profile the phases of function::codegen() ?
+      * And the path of the Chrome trace of the profile.
+      */
+    static bool compile_time_profiling;
+    static std::string compile_time_trace_path;
+
+    /**
+      * Directory of the cache of object files (empty if there is no cache).
+      */
+    static std::string object_cache_directory;
+
 public:
 
     /**
@@ -142,6 +155,74 @@ public:
         return global::loop_iterator_type;
     }
 
+    /**
+      * If this option is set to true, function::codegen() measures the wall time
+      * and the peak memory of each of its phases, of each Halide lowering pass
+      * and of each computation. They are printed as a table, and written as a
+      * Chrome trace to \p trace_path (by default, "<function name>_compile_profile.json").
+      * See tiramisu::compile_time_profiler.
+      *
+      * Profiling is also enabled if the environment variable TIRAMISU_COMPILE_PROFILE
+      * is set to 1, or to the path of the trace.
+      */
+    static void set_compile_time_profiling(bool v, const std::string &trace_path = "")
+    {
+        global::compile_time_profiling = v;
+        global::compile_time_trace_path = trace_path;
+    }
+
+    /**
+      * Return whether compile-time profiling is set, by set_compile_time_profiling()
+      * or by the environment variable TIRAMISU_COMPILE_PROFILE.
+      */
+    static bool is_compile_time_profiling_set()
+    {
+        const char *env = getenv("TIRAMISU_COMPILE_PROFILE");
+        return global::compile_time_profiling || (env != NULL && strcmp(env, "") != 0 && strcmp(env, "0") != 0);
+    }
+
+    /**
+      * Return the path of the compile-time trace, or an empty string
+      * if the default path must be used.
+      */
+    static std::string get_compile_time_trace_path()
+    {
+        const char *env = getenv("TIRAMISU_COMPILE_PROFILE");
+        if (global::compile_time_trace_path.empty() && env != NULL &&
+            strcmp(env, "") != 0 && strcmp(env, "0") != 0 && strcmp(env, "1") != 0)
+            return env;
+
+        return global::compile_time_trace_path;
+    }
+
+    /**
+      * Cache the object files generated by function::codegen() in the directory
+      * \p directory, or disable the cache if \p directory is empty.
+      * An object file is reused when the lowered Halide statement, the target
+      * and the arguments of the function did not change, instead of being
+      * compiled again by LLVM. See tiramisu::object_cache.
+      *
+      * The cache can also be set by the environment variable TIRAMISU_OBJECT_CACHE_DIR.
+      */
+    static void set_object_cache_directory(const std::string &directory)
+    {
+        global::object_cache_directory = directory;
+    }
+
+    /**
+      * Return the directory of the cache of object files, set by
+      * set_object_cache_directory() or by the environment variable
+      * TIRAMISU_OBJECT_CACHE_DIR, or an empty string if there is no cache.
+      */
+    static std::string get_object_cache_directory()
+    {
+        const char *env = getenv("TIRAMISU_OBJECT_CACHE_DIR");
+        if (global::object_cache_directory.empty() && env != NULL)
+            return env;
+
+        return global::object_cache_directory;
+    }
+
     global()
     {
         set_default_tiramisu_options();
@@ -0,0 +1,238 @@
+#ifndef _H_TIRAMISU_JIT_
+#define _H_TIRAMISU_JIT_
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Halide.h>
+
+namespace tiramisu
+{
+
+class function;
+class buffer;
+
+/**
+  * A Tiramisu function compiled in memory by Halide's JIT.
+  *
+  * A jit_function is returned by function::jit_compile(). It can be called
+  * in the process that compiled it, without generating an object file or
+  * linking a wrapper. It is a handle : copies share the same compiled code,
+  * which stays valid as long as a copy exists.
+  *
+  * \code
+  * tiramisu::jit_function f = fct->jit_compile({&b_input, &b_output});
+  * Halide::Buffer<int32_t> input(N, M), output(N, M);
+  * f({input, output});
+  * \endcode
+  */
+class jit_function
+{
+private:
+    /**
+      * The JIT compiled module (it also keeps the Halide runtime alive).
+      */
+    Halide::Internal::JITModule module;
+
+    /**
+      * Entry point of the function, that takes an array of pointers
+      * to its arguments (halide_buffer_t pointers for buffers).
+      */
+    int (*argv_function)(const void **);
+
+    /**
+      * The arguments of the function, in order.
+      */
+    std::vector<Halide::Argument> arguments;
+
+    std::string name;
+
+public:
+    /**
+      * Create an undefined jit_function.
+      */
+    jit_function();
+
+    /**
+      * Create a jit_function from the lowered Halide module \p m, by compiling
+      * its function \p name. The module must be lowered for a JIT target,
+      * with the ExternalPlusMetadata linkage.
+      */
+    jit_function(Halide::Module const& m, std::string const& name, std::vector<Halide::Argument> const& arguments);
+
+    /**
+      * Return true if the function is compiled.
+      */
+    bool defined() const;
+
+    /**
+      * Return the name of the function.
+      */
+    std::string const& get_name() const;
+
+    /**
+      * Return the arguments of the function.
+      */
+    std::vector<Halide::Argument> const& get_arguments() const;
+
+    /**
+      * Run the function on \p buffers, given in the order of the arguments
+      * of the function. The number of dimensions and the type of each buffer
+      * must match the argument.
+      * Return 0 on success, or the error code of the function.
+      */
+    int run(std::vector<Halide::Buffer<>> const& buffers) const;
+
+    /**
+      * \overload
+      */
+    int operator()(std::vector<Halide::Buffer<>> const& buffers) const
+    {
+        return run(buffers);
+    }
+};
+
+/**
+  * A parameter of a function (e.g. a tiramisu::constant used in the iteration
+  * domains) that is equal to the extent of a dimension of one of its arguments.
+  */
+struct shape_parameter
+{
+    /**
+      * Name of the parameter.
+      */
+    std::string name;
+
+    /**
+      * Index of the argument in the arguments of the function.
+      */
+    int argument;
+
+    /**
+      * Dimension of the argument. As in tiramisu::buffer, the dimension 0
+      * is the outermost one (the last dimension of the Halide buffer).
+      */
+    int dimension;
+};
+
+/**
+  * Runs a function with variants of its code specialized for the shapes
+  * it is called with.
+  *
+  * Code generated for symbolic parameters has to handle any value : loop
+  * bounds are not known, and tiled loops get a tail loop on every dimension.
+  * The first time run() is called with a new shape, a variant is compiled in
+  * the background, with context constraints that set each parameter to its value
+  * (see function::jit_compile_specialized()). Until it is ready, the generic code
+  * is used. Specialized variants are kept in an LRU cache of \p capacity variants.
+  *
+  * The function is modified by the background compilations, so it must not be
+  * used while a jit_specializer exists.
+  *
+  * \code
+  * // N is the extent of the outermost dimension of the first argument
+  * tiramisu::jit_specializer specializer(&f, {&b_input, &b_output}, {{"N", 0, 0}});
+  * specializer.run({input, output});
+  * \endcode
+  */
+class jit_specializer
+{
+private:
+    tiramisu::function *fct;
+
+    std::vector<shape_parameter> parameters;
+
+    /**
+      * Maximal number of specialized variants.
+      */
+    int capacity;
+
+    /**
+      * The function compiled for any value of its parameters.
+      */
+    jit_function generic_function;
+
+    /**
+      * Specialized variants, identified by the values of the parameters,
+      * from the most recently used to the least recently used.
+      */
+    std::list<std::pair<std::vector<int64_t>, jit_function>> specialized_functions;
+
+    /**
+      * The thread that compiles a specialized variant, and whether it is running.
+      * Only one variant is compiled at a time.
+      */
+    std::thread compile_thread;
+    bool compiling;
+
+    /**
+      * Number of calls to run() that used a specialized variant.
+      */
+    int nb_specialized_runs;
+
+    /**
+      * Protects specialized_functions, compiling and nb_specialized_runs.
+      */
+    std::mutex mutex;
+
+    /**
+      * Return the values of the parameters for the given buffers.
+      */
+    std::vector<int64_t> get_shape(std::vector<Halide::Buffer<>> const& buffers) const;
+
+    /**
+      * Compile the variant specialized for \p shape and add it to the cache.
+      */
+    void compile_specialized_function(std::vector<int64_t> shape);
+
+public:
+    /**
+      * Compile the generic code of \p fct with the given arguments.
+      * \p parameters are the parameters to specialize.
+      */
+    jit_specializer(tiramisu::function *fct, std::vector<tiramisu::buffer *> const& arguments,
+                    std::vector<shape_parameter> const& parameters, int capacity = 8);
+
+    /**
+      * Wait for the compilation running in the background.
+      */
+    ~jit_specializer();
+
+    /**
+      * Run the variant specialized for the shape of \p buffers if it is compiled,
+      * or the generic code otherwise.
+      * Return 0 on success, or the error code of the function.
+      */
+    int run(std::vector<Halide::Buffer<>> const& buffers);
+
+    /**
+      * \overload
+      */
+    int operator()(std::vector<Halide::Buffer<>> const& buffers)
+    {
+        return run(buffers);
+    }
+
+    /**
+      * Wait until the compilation running in the background (if any) is done.
+      */
+    void wait();
+
+    /**
+      * Return the number of specialized variants in the cache.
+      */
+    int get_nb_specialized_functions();
+
+    /**
+      * Return the number of calls to run() that used a specialized variant
+      * instead of the generic code.
+      */
+    int get_nb_specialized_runs();
+};
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef _H_TIRAMISU_OBJECT_CACHE_
+#define _H_TIRAMISU_OBJECT_CACHE_
+
+#include <string>
+
+#include <Halide.h>
+
+namespace tiramisu
+{
+
+/**
+  * A cache of the object files compiled from lowered Halide modules.
+  *
+  * The cache is a directory (see global::set_object_cache_directory()) where
+  * each object file is stored under the hash of the module it was compiled from.
+  * The key of a module is made of the versions of LLVM and Halide, the builds
+  * of the Halide and Tiramisu libraries, its target (with its features), the name,
+  * linkage and arguments of its functions, and their lowered statements.
+  * Two modules with the same key generate the same object file, so
+  * function::gen_halide_obj() copies the cached object file instead of running
+  * LLVM when the algorithm and the schedule did not change. The auto-scheduler
+  * uses the same cache when it compiles schedules.
+  *
+  * Object files are written to a temporary file and then renamed, so the cache
+  * can be shared by several processes.
+  */
+class object_cache
+{
+private:
+    /**
+      * Return the path of the object file with the given key in the cache.
+      */
+    static std::string get_object_path(std::string const& key);
+
+public:
+    /**
+      * Return true if a cache directory is set.
+      */
+    static bool is_enabled();
+
+    /**
+      * Return the key of the module \p m.
+      */
+    static std::string get_key(Halide::Module const& m);
+
+    /**
+      * Copy the object file with the key \p key from the cache to \p obj_file_name.
+      * Return false if the cache doesn't contain it.
+      */
+    static bool load(std::string const& key, std::string const& obj_file_name);
+
+    /**
+      * Add the object file \p obj_file_name to the cache with the key \p key.
+      */
+    static void store(std::string const& key, std::string const& obj_file_name);
+
+    /**
+      * Compile the module \p m to the object file \p obj_file_name, or copy it
+      * from the cache if it was compiled before.
+      * Return true if the object file was found in the cache.
+      */
+    static bool compile(Halide::Module const& m, std::string const& obj_file_name);
+};
+
+}
+
+#endif
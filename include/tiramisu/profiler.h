@@ -0,0 +1,134 @@
+#ifndef _H_TIRAMISU_PROFILER_
+#define _H_TIRAMISU_PROFILER_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace tiramisu
+{
+
+/**
+  * Return the given string as a JSON string literal.
+  * Quotes, backslashes and control characters are escaped.
+  * Used to write the Chrome trace of the profiler and the traces of the auto-scheduler.
+  */
+std::string get_json_string(std::string const& str);
+
+/**
+  * Measures where function::codegen() spends its time.
+  *
+  * Profiling is enabled by global::set_compile_time_profiling(), or by setting
+  * the environment variable TIRAMISU_COMPILE_PROFILE.
+  * codegen() starts a profiling session, and each phase of the code generation
+  * (gen_time_space_domain, gen_isl_ast, gen_halide_stmt, each Halide lowering pass,
+  * the LLVM compilation, ...) and each computation processed by these phases
+  * records an event with its wall time and the peak RSS of the process at its end.
+  *
+  * At the end of codegen(), the events are printed as a table, and written as a
+  * Chrome trace (to be opened with chrome://tracing or https://ui.perfetto.dev).
+  *
+  * Events are only recorded during a session, so the phases called outside
+  * of codegen() (e.g. by the auto-scheduler) are not recorded.
+  */
+class compile_time_profiler
+{
+private:
+    /**
+      * A phase, a Halide lowering pass, or the processing of a computation by a phase.
+      * Times are in seconds since the start of the session, the peak RSS in kilobytes.
+      */
+    struct event
+    {
+        std::string name;
+        std::string category;
+        double start;
+        double duration;
+        long peak_rss_start;
+        long peak_rss_end;
+        int depth;
+    };
+
+    static std::vector<event> events;
+
+    /**
+      * Indices of the events that are not ended yet, from the outermost to the innermost.
+      */
+    static std::vector<int> open_events;
+
+    static bool recording;
+    static std::string session_name;
+    static std::chrono::steady_clock::time_point session_start;
+
+    static void print_table();
+    static void write_trace(std::string const& trace_path);
+
+public:
+    /**
+      * Return true if profiling is enabled (see global::set_compile_time_profiling()).
+      */
+    static bool is_enabled();
+
+    /**
+      * Return true if a session is started.
+      */
+    static bool is_recording() { return recording; }
+
+    /**
+      * Start a session for the function fct_name, if profiling is enabled.
+      */
+    static void start(std::string const& fct_name);
+
+    /**
+      * End the session, print the table and write the Chrome trace.
+      */
+    static void stop();
+
+    /**
+      * Start and end an event. Events are nested : end() ends the last event started.
+      * Categories are "phase", "halide_pass" and "computation".
+      */
+    static void begin(std::string const& name, std::string const& category);
+    static void end();
+};
+
+/**
+  * Record an event from its construction to its destruction, if a session is started.
+  */
+class compile_time_scope
+{
+private:
+    bool active;
+    const char *category;
+
+public:
+    compile_time_scope(std::string const& name, const char *category = "phase")
+        : active(compile_time_profiler::is_recording()), category(category)
+    {
+        if (active)
+            compile_time_profiler::begin(name, category);
+    }
+
+    ~compile_time_scope()
+    {
+        if (active)
+            compile_time_profiler::end();
+    }
+
+    /**
+      * End the current event and start a new one of the same category.
+      * Used to record a sequence of passes.
+      */
+    void next(std::string const& name)
+    {
+        if (!active)
+            return;
+
+        compile_time_profiler::end();
+        compile_time_profiler::begin(name, category);
+    }
+};
+
+}
+
+#endif
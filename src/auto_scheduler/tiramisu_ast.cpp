@@ -5,7 +5,7 @@ namespace tiramisu::auto_scheduler
 {
 
 computation_info::computation_info(tiramisu::computation *comp, syntax_tree *ast)
-    : comp_ptr(comp), iters(dnn_iterator::get_iterators_from_computation(*comp)),
+    : comp_ptr(comp), iters(dnn_iterator::get_iterators_from_computation(*comp, ast->params)),
       accesses(comp, iters.size(), comp->get_function()), buffer_nb_dims(iters.size()),
       nb_additions(0), nb_substractions(0), nb_multiplications(0), nb_divisions(0)
 {
@@ -70,8 +70,8 @@ void computation_info::get_info_from_expr(tiramisu::expr const& e)
 
 // ---------------------------------------------------------------------------- //
 
-syntax_tree::syntax_tree(tiramisu::function *fct)
-    : fct(fct)
+syntax_tree::syntax_tree(tiramisu::function *fct, parameters_values const& params)
+    : fct(fct), params(params)
 {
     const std::vector<computation*> computations = fct->get_computations();
     
@@ -102,13 +102,49 @@ syntax_tree::syntax_tree(tiramisu::function *fct)
     order_computations();
     
     // Get the JSON representation of this AST iterators
+    std::string iters_json;
     for (ast_node *node : roots)
-        evaluate_by_learning_model::represent_iterators_from_nodes(node, iterators_json);
+        evaluate_by_learning_model::represent_iterators_from_nodes(node, iters_json);
         
-    iterators_json.pop_back();
+    iters_json.pop_back();
+    iterators_json = std::make_shared<const std::string>(iters_json);
     
     // Get the JSON representation of this tree
     tree_structure_json = evaluate_by_learning_model::get_tree_structure_json(*this);
+    
+    program_fingerprint = get_program_fingerprint(fct);
+}
+
+uint64_t syntax_tree::get_program_fingerprint(tiramisu::function *fct)
+{
+    std::string program_str;
+    
+    for (tiramisu::computation *comp : fct->get_computations())
+    {
+        char *domain_str = isl_set_to_str(comp->get_iteration_domain());
+        char *access_str = comp->access == nullptr ? nullptr : isl_map_to_str(comp->access);
+        
+        program_str += comp->get_name() + ":" + std::to_string(comp->get_data_type()) + ":";
+        program_str += std::string(domain_str) + ":" + (access_str == nullptr ? "" : access_str) + ":";
+        program_str += comp->get_expr().to_str() + ";";
+        
+        free(domain_str);
+        free(access_str);
+    }
+    
+    program_str += "|";
+    for (auto const& buf : fct->get_buffers())
+    {
+        program_str += buf.first + ":" + std::to_string(buf.second->get_elements_type()) + ":";
+        program_str += std::to_string(buf.second->get_argument_type()) + ":";
+        
+        for (tiramisu::expr const& dim_size : buf.second->get_dim_sizes())
+            program_str += dim_size.to_str() + ",";
+            
+        program_str += ";";
+    }
+    
+    return hash_string(program_str);
 }
 
 ast_node::ast_node(tiramisu::computation *comp, syntax_tree *ast)
@@ -147,7 +183,7 @@ ast_node::ast_node(tiramisu::computation *comp, syntax_tree *ast)
         nodes[i + 1]->parent = nodes[i];
     }
     
-    nodes.back()->computations.push_back(computation_info(comp, ast));
+    nodes.back()->computations.push_back(std::make_shared<const computation_info>(comp, ast));
 }
 
 void syntax_tree::order_computations()
@@ -176,10 +212,10 @@ void syntax_tree::order_computations()
             {
                 if (parent_comp_ast_node->children.empty())
                 {
-                    for (computation_info& comp_info : child_comp_ast_node->computations)
+                    for (auto const& comp_info : child_comp_ast_node->computations)
                     {
                         parent_comp_ast_node->computations.push_back(comp_info);
-                        computations_mapping[comp_info.comp_ptr] = parent_comp_ast_node;
+                        computations_mapping[comp_info->comp_ptr] = parent_comp_ast_node;
                     }
                 }
                 
@@ -195,8 +231,8 @@ void syntax_tree::order_computations()
                     new_node->computations = child_comp_ast_node->computations;
                     new_node->parent = parent_comp_ast_node;
                     
-                    for (computation_info& comp_info : child_comp_ast_node->computations)
-                        computations_mapping[comp_info.comp_ptr] = new_node;
+                    for (auto const& comp_info : child_comp_ast_node->computations)
+                        computations_mapping[comp_info->comp_ptr] = new_node;
                         
                     parent_comp_ast_node->children.push_back(new_node);
                 }
@@ -226,6 +262,8 @@ void syntax_tree::transform_ast()
 
 void syntax_tree::transform_ast(optimization_info const& opt)
 {
+    fingerprint_nb_optims = -1;
+    
     switch(opt.type)
     {
         case optimization_type::FUSION:
@@ -248,11 +286,54 @@ void syntax_tree::transform_ast(optimization_info const& opt)
             transform_ast_by_unrolling(opt);
             break;
             
+        case optimization_type::PARALLELIZE:
+            transform_ast_by_parallelism(opt);
+            break;
+            
+        case optimization_type::VECTORIZE:
+            transform_ast_by_vectorization(opt);
+            break;
+            
+        case optimization_type::COMPUTE_AT:
+            transform_ast_by_compute_at(opt);
+            break;
+            
         default:
             break;
     }
 }
 
+void syntax_tree::replay_optimizations(std::vector<optimization_info> const& optims)
+{
+    for (optimization_info optim_info : optims)
+    {
+        switch (optim_info.type)
+        {
+            case optimization_type::UNFUSE:
+                break;
+                
+            case optimization_type::FUSION:
+                optim_info.node = find_node_by_level(optim_info.comps[0], optim_info.l2);
+                break;
+                
+            // The node is a loop level of the consumer
+            case optimization_type::COMPUTE_AT:
+                optim_info.node = find_node_by_level(optim_info.comps[1], optim_info.l0);
+                break;
+                
+            default:
+                if (optim_info.l0 != -1)
+                    optim_info.node = find_node_by_level(optim_info.comps[0], optim_info.l0);
+                break;
+        }
+        
+        transform_ast(optim_info);
+        recompute_computations_mapping();
+        
+        previous_optims.push_back(optim_info);
+    }
+}
+
 void syntax_tree::transform_ast_by_fusion(optimization_info const& opt)
 {
     std::vector<ast_node*> *tree_level;
@@ -268,10 +349,10 @@ void syntax_tree::transform_ast_by_fusion(optimization_info const& opt)
     for (ast_node *child : node2->children)
         node1->children.push_back(child);
 
-    for (computation_info& comp_info : node2->computations)
+    for (auto const& comp_info : node2->computations)
     {
         node1->computations.push_back(comp_info);
-        computations_mapping[comp_info.comp_ptr] = node1;
+        computations_mapping[comp_info->comp_ptr] = node1;
     }
 
     tree_level->erase(tree_level->begin() + opt.l1);
@@ -469,9 +550,9 @@ void syntax_tree::transform_ast_by_unrolling(optimization_info const& opt)
             i_inner->parent = i_outer;
             
             // Location of computations have changed, update computations_mapping
-            for (computation_info& comp_info : i_inner->computations)
+            for (auto const& comp_info : i_inner->computations)
             {
-                computations_mapping[comp_info.comp_ptr] = i_inner;
+                computations_mapping[comp_info->comp_ptr] = i_inner;
             }
             
             // Rename the nodes
@@ -492,6 +573,91 @@ void syntax_tree::transform_ast_by_unrolling(optimization_info const& opt)
     }
 }
 
+void syntax_tree::transform_ast_by_parallelism(optimization_info const& opt)
+{
+    opt.node->parallelized = true;
+}
+
+void syntax_tree::transform_ast_by_vectorization(optimization_info const& opt)
+{
+    std::vector<ast_node*> nodes_list;
+    
+    // Apply vectorization on the node provided by opt
+    if (opt.l0 != -1)
+        nodes_list = {opt.node};
+        
+    // Apply vectorization on every innermost loop level
+    else
+        nodes_list = get_innermost_nodes();
+    
+    for (ast_node *node : nodes_list)
+    {
+        // The loop level is split by the vector length, and the inner loop level is vectorized
+        ast_node *i_outer = node;
+        ast_node *i_inner = new ast_node();
+        
+        // Chain the nodes
+        i_inner->computations = i_outer->computations;
+        i_inner->children = i_outer->children;
+        
+        i_outer->computations.clear();
+        i_outer->children.clear();
+        i_outer->children.push_back(i_inner);
+        
+        i_inner->parent = i_outer;
+        for (ast_node *child : i_inner->children)
+            child->parent = i_inner;
+        
+        // Location of computations have changed, update computations_mapping
+        for (auto const& comp_info : i_inner->computations)
+        {
+            computations_mapping[comp_info->comp_ptr] = i_inner;
+        }
+        
+        // Rename the nodes
+        i_inner->name = i_outer->name + "_inner";
+        i_outer->name = i_outer->name + "_outer";
+        
+        // Set lower and upper bounds
+        i_outer->low_bound = 0;
+        i_outer->up_bound = i_outer->get_extent() / opt.l0_fact - 1;
+        
+        i_inner->low_bound = 0;
+        i_inner->up_bound = opt.l0_fact - 1;
+        
+        i_inner->vectorized = true;
+        i_inner->update_depth(i_outer->depth + 1);
+    }
+}
+
+void syntax_tree::transform_ast_by_compute_at(optimization_info const& opt)
+{
+    // The producer is alone in its loop nest
+    ast_node *producer_root = computations_mapping[opt.comps[0]]->get_root_node();
+    roots.erase(std::find(roots.begin(), roots.end(), producer_root));
+    
+    // The loop levels of the producer down to l0 are merged with the ones of the consumer,
+    // and the remaining levels are placed before the consumer, in the node given by opt.
+    ast_node *producer_node = producer_root;
+    for (int i = 0; i < opt.l0 && !producer_node->children.empty(); ++i)
+        producer_node = producer_node->children[0];
+        
+    opt.node->computations.insert(opt.node->computations.begin(), producer_node->computations.begin(), producer_node->computations.end());
+    opt.node->children.insert(opt.node->children.begin(), producer_node->children.begin(), producer_node->children.end());
+    
+    for (ast_node *child : producer_node->children)
+    {
+        child->parent = opt.node;
+        child->update_depth(opt.node->depth + 1);
+    }
+    
+    producer_node->children.clear();
+    delete producer_root;
+    
+    recompute_computations_mapping();
+    tree_structure_json = evaluate_by_learning_model::get_tree_structure_json(*this);
+}
+
 syntax_tree* syntax_tree::copy_ast() const
 {
     syntax_tree *ast = new syntax_tree();
@@ -527,14 +693,17 @@ ast_node* syntax_tree::copy_and_return_node(syntax_tree& new_ast, ast_node *node
 
     // Copy AST data
     new_ast.fct = fct;
+    new_ast.params = params;
     new_ast.computations_list = computations_list;
     new_ast.buffers_list = buffers_list;
     new_ast.buffers_mapping = buffers_mapping;
     
     new_ast.iterators_json = iterators_json;
     new_ast.tree_structure_json = tree_structure_json;
+    new_ast.program_fingerprint = program_fingerprint;
     
     new_ast.evaluation = evaluation;
+    new_ast.evaluation_ci = evaluation_ci;
     new_ast.search_depth = search_depth;
     new_ast.nb_explored_optims = nb_explored_optims;
     new_ast.previous_optims = previous_optims;
@@ -572,6 +741,8 @@ ast_node* ast_node::copy_and_return_node(ast_node *new_node, ast_node *node_to_f
     new_node->low_bound = low_bound;
     new_node->up_bound = up_bound;
     new_node->unrolled = unrolled;
+    new_node->parallelized = parallelized;
+    new_node->vectorized = vectorized;
     new_node->computations = computations;
 
     return ret_node;
@@ -587,8 +758,8 @@ void syntax_tree::recompute_computations_mapping()
     
 void syntax_tree::recompute_computations_mapping(ast_node *node)
 {
-    for (computation_info& comp_info : node->computations)
-        computations_mapping[comp_info.comp_ptr] = node;
+    for (auto const& comp_info : node->computations)
+        computations_mapping[comp_info->comp_ptr] = node;
         
     for (ast_node *child : node->children)
         recompute_computations_mapping(child);
@@ -603,6 +774,33 @@ std::vector<optimization_info> syntax_tree::get_schedule() const
     return schedule;
 }
 
+std::string syntax_tree::get_schedule_str() const
+{
+    std::string sched_str = fct->get_name() + ":";
+    
+    for (ast_node *root : roots)
+        root->get_structure_str(sched_str);
+        
+    sched_str += "|";
+    for (optimization_info const& optim_info : get_schedule())
+        sched_str += get_optimization_str(optim_info) + ";";
+        
+    return sched_str;
+}
+
+uint64_t syntax_tree::get_fingerprint() const
+{
+    int nb_optims = previous_optims.size() + new_optims.size();
+    
+    if (fingerprint_nb_optims != nb_optims)
+    {
+        fingerprint = hash_string(std::to_string(program_fingerprint) + "#" + get_schedule_str());
+        fingerprint_nb_optims = nb_optims;
+    }
+    
+    return fingerprint;
+}
+
 void syntax_tree::clear_new_optimizations()
 {
     for (optimization_info const& optim_info : new_optims)
@@ -682,8 +880,8 @@ void ast_node::get_innermost_computations(std::vector<tiramisu::computation*>& c
 {
     if (children.empty() && get_extent() > 1)
     {
-        for (computation_info& comp_info : computations)
-            comps.push_back(comp_info.comp_ptr);
+        for (auto const& comp_info : computations)
+            comps.push_back(comp_info->comp_ptr);
     }
     
     for (ast_node *child : children)
@@ -766,8 +964,8 @@ void ast_node::update_depth(int depth)
 
 void ast_node::get_all_computations(std::vector<tiramisu::computation*>& comps)
 {
-    for (computation_info& comp_info : computations)
-        comps.push_back(comp_info.comp_ptr);
+    for (auto const& comp_info : computations)
+        comps.push_back(comp_info->comp_ptr);
         
     for (ast_node *child : children)
         child->get_all_computations(comps);
@@ -778,7 +976,7 @@ int ast_node::get_loop_levels_chain_depth() const
     int ret = depth + 1;
     const ast_node *node = this;
     
-    while (node->children.size() == 1 && node->computations.size() == 0 && !node->unrolled)
+    while (node->children.size() == 1 && node->computations.size() == 0 && !node->unrolled && !node->vectorized)
     {
         ret++;
         node = node->children[0];
@@ -787,6 +985,27 @@ int ast_node::get_loop_levels_chain_depth() const
     return ret;
 }
 
+void ast_node::get_structure_str(std::string& str) const
+{
+    str += name + "[" + std::to_string(low_bound) + "," + std::to_string(up_bound) + "]";
+    if (unrolled)
+        str += "u";
+    if (parallelized)
+        str += "p";
+    if (vectorized)
+        str += "v";
+        
+    str += "(";
+    for (auto const& comp_info : computations)
+        str += comp_info->comp_ptr->get_name() + ",";
+        
+    str += "){";
+    for (ast_node *child : children)
+        child->get_structure_str(str);
+        
+    str += "}";
+}
+
 void syntax_tree::print_ast() const
 {
     for (ast_node *root : roots)
@@ -800,15 +1019,22 @@ void ast_node::print_node() const
         for (int i = 0; i < depth; ++i)
             std::cout << "\t";
             
-        std::cout << "for " << low_bound << " <= " << name << " < " << up_bound + 1 << " | " << unrolled << std::endl;
+        std::cout << "for " << low_bound << " <= " << name << " < " << up_bound + 1 << " | " << unrolled;
+        
+        if (parallelized)
+            std::cout << " | P";
+        if (vectorized)
+            std::cout << " | V";
+            
+        std::cout << std::endl;
     }
     
-    for (computation_info const& comp_info : computations) 
+    for (auto const& comp_info : computations) 
     {
         for (int i = 0; i < depth + 1; ++i)
             std::cout << "\t";
             
-        std::cout << comp_info.comp_ptr->get_name() << std::endl;
+        std::cout << comp_info->comp_ptr->get_name() << std::endl;
     }
 
     for (ast_node *child : children)
@@ -1,48 +1,137 @@
 #include <tiramisu/auto_scheduler/auto_scheduler.h>
 #include <tiramisu/auto_scheduler/evaluator.h>
 #include <tiramisu/auto_scheduler/search_method.h>
+#include <tiramisu/auto_scheduler/optimization_info.h>
+#include <tiramisu/auto_scheduler/checkpoint.h>
+#include <tiramisu/auto_scheduler/telemetry.h>
 
-#include <chrono>
+#include <sys/resource.h>
 
 namespace tiramisu::auto_scheduler
 {
 
 auto_scheduler::auto_scheduler(search_method *searcher, evaluation_function *eval_func, 
-                               tiramisu::function *fct)
+                               tiramisu::function *fct, parameters_values const& params)
                                
-    : fct(fct), ast(fct), searcher(searcher), eval_func(eval_func)
+    : fct(fct), ast(fct, params), searcher(searcher), eval_func(eval_func)
 {
     searcher->set_eval_func(eval_func);
 }
 
+auto_scheduler::~auto_scheduler()
+{
+    delete checkpoint;
+    delete telemetry;
+}
+
+void auto_scheduler::set_checkpoint(std::string const& checkpoint_dir, double save_interval)
+{
+    delete checkpoint;
+    
+    checkpoint = new search_checkpoint(checkpoint_dir, save_interval);
+    searcher->set_checkpoint(checkpoint, ast);
+    
+    if (checkpoint->resumed)
+        std::cout << "Resuming the search from " << checkpoint_dir << std::endl;
+}
+
+void auto_scheduler::set_telemetry(std::string const& trace_path)
+{
+    delete telemetry;
+    
+    telemetry = new search_telemetry(trace_path, checkpoint != nullptr && checkpoint->resumed);
+    searcher->set_telemetry(telemetry);
+}
+
 void auto_scheduler::find_schedule()
 {
     fct->reset_schedules();
+    
+    // When resuming a search, the initial execution time and evaluation are in the checkpoint
     if (exec_evaluator != nullptr)
-        initial_exec_time = exec_evaluator->evaluate(ast);
+    {
+        evaluation_cache *exec_cache = nullptr;
+        if (checkpoint != nullptr)
+            exec_cache = checkpoint->get_execution_cache();
+            
+        float exec_ci;
+        if (exec_cache == nullptr || !exec_cache->find(ast, initial_exec_time, exec_ci))
+        {
+            initial_exec_time = exec_evaluator->evaluate(ast);
+            
+            if (exec_cache != nullptr)
+                exec_cache->insert(ast, initial_exec_time, exec_evaluator->get_confidence_interval(ast));
+        }
+    }
     
-    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    // The budget of the search doesn't include the initial execution
+    searcher->start_budget();
     
     // Get the initial evaluation, and start the search.
-    ast.evaluation = eval_func->evaluate(ast);
-    searcher->search(ast);
+    evaluation_cache *eval_cache = searcher->get_evaluation_cache();
+    if (eval_cache == nullptr || !eval_cache->find(ast, ast.evaluation, ast.evaluation_ci))
+    {
+        ast.evaluation = eval_func->evaluate(ast);
+        ast.evaluation_ci = eval_func->get_confidence_interval(ast);
+        
+        if (eval_cache != nullptr)
+            eval_cache->insert(ast, ast.evaluation, ast.evaluation_ci);
+    }
     
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    searcher->search(ast);
+    searcher->save_checkpoint();
     
     // Print some info about the search
     std::cout << "NB explored schedules : " << searcher->get_nb_explored_schedules() << std::endl;
+    
+    if (eval_cache != nullptr)
+        std::cout << "Evaluation cache hits : " << eval_cache->get_nb_hits() 
+                  << ", misses : " << eval_cache->get_nb_misses() << std::endl;
+                  
+    schedules_generator *scheds_gen = searcher->get_schedules_generator();
+    if (scheds_gen != nullptr)
+    {
+        std::cout << "NB pruned illegal schedules : " << scheds_gen->get_nb_pruned_schedules();
+        
+        // Each pruned schedule would have been compiled and executed by exec_evaluator
+        if (exec_evaluator != nullptr)
+            std::cout << " (estimated compile and run time saved : " 
+                      << scheds_gen->get_nb_pruned_schedules() * exec_evaluator->get_avg_evaluation_time() << " s)";
+                      
+        std::cout << std::endl;
+    }
+                  
     std::cout << "Best evaluation : " << searcher->get_best_evaluation() << std::endl;
     
     if (exec_evaluator != nullptr)
+    {
         std::cout << "Initial exec time : " << initial_exec_time << std::endl;
+        std::cout << "NB executions timed out : " << exec_evaluator->get_nb_exec_timeouts()
+                  << ", compilations timed out : " << exec_evaluator->get_nb_compile_timeouts() << std::endl;
+                  
+        exec_evaluator->print_fidelity_report();
+    }
         
     std::cout << "Initial evaluation : " << ast.evaluation << std::endl;
-    std::cout << "Search time : " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms " << std::endl;  
+    searcher->print_budget_report();
+    
+    if (telemetry != nullptr)
+        telemetry->print_summary();
+    
+    // ru_maxrss is given in kilobytes
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        std::cout << "Peak memory : " << usage.ru_maxrss / 1024 << " MB" << std::endl;
 }
 
 void auto_scheduler::apply_best_schedule()
 {
     syntax_tree *best_ast = searcher->get_best_ast();
+    
+    // The budget was exhausted before any schedule was evaluated
+    if (best_ast == nullptr)
+        best_ast = &ast;
+        
     best_ast->print_ast();
     
     // To apply the best schedule, we need to use exec_evaluator.
@@ -56,4 +145,26 @@ void auto_scheduler::apply_best_schedule()
     }
 }
 
+int auto_scheduler::save_best_schedule(std::string const& path_name)
+{
+    syntax_tree *best_ast = searcher->get_best_ast();
+    if (best_ast == nullptr)
+        best_ast = &ast;
+        
+    // Apply the schedule as evaluate_by_execution does. The computations and buffers added
+    // by compute_at are saved with the schedule, so that load_schedule() adds them again.
+    fct->reset_schedules();
+    apply_optimizations(*best_ast);
+    apply_compute_at(*best_ast);
+    
+    if (!ast_has_optimization(*best_ast, optimization_type::PARALLELIZE))
+        parallelize_outermost_levels(best_ast->computations_list);
+        
+    int schedule_number = fct->save_schedule(path_name);
+    if (schedule_number >= 0)
+        std::cout << "Best schedule saved to " << path_name << " (schedule " << schedule_number << ")" << std::endl;
+        
+    return schedule_number;
+}
+
 }
@@ -0,0 +1,465 @@
+#include <tiramisu/auto_scheduler/benchmark_runner.h>
+
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dlfcn.h>
+#include <sched.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cfloat>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * Return the 0.975 quantile of Student's t-distribution with the given degrees of freedom.
+ */
+static double get_t_quantile(int degrees_of_freedom)
+{
+    static const double t_quantiles[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    
+    if (degrees_of_freedom < 1)
+        return t_quantiles[0];
+        
+    if (degrees_of_freedom > 30)
+        return 1.96;
+        
+    return t_quantiles[degrees_of_freedom - 1];
+}
+
+/**
+ * Compute the mean, the median and the 95% confidence interval of the mean of the given durations.
+ */
+static timing_stats get_timing_stats(std::vector<double> durations)
+{
+    timing_stats stats;
+    stats.nb_runs = durations.size();
+    
+    if (durations.empty())
+        return stats;
+        
+    double mean = 0;
+    for (double duration : durations)
+        mean += duration;
+        
+    mean /= durations.size();
+    
+    double variance = 0;
+    for (double duration : durations)
+        variance += (duration - mean) * (duration - mean);
+        
+    if (durations.size() > 1)
+        variance /= durations.size() - 1;
+        
+    double half_width = get_t_quantile(durations.size() - 1) * std::sqrt(variance / durations.size());
+    
+    std::sort(durations.begin(), durations.end());
+    
+    stats.mean = mean;
+    stats.median = durations[durations.size() / 2];
+    stats.ci_low = mean - half_width;
+    stats.ci_high = mean + half_width;
+    
+    return stats;
+}
+
+/**
+ * Fill the given buffer with ones.
+ */
+template<typename T>
+static void fill_buffer(Halide::Buffer<>& buf)
+{
+    T *data = (T*)buf.raw_buffer()->host;
+
+    for (size_t i = 0; i < buf.number_of_elements(); ++i)
+        data[i] = (T)1;
+}
+
+benchmark_runner::benchmark_runner(std::string const& fct_name, std::vector<tiramisu::buffer*> const& arguments,
+                                   std::vector<std::vector<int>> const& buffer_sizes,
+                                   int nb_exec, int nb_warmup)
+    : fct_name(fct_name), arguments(arguments), buffer_sizes(buffer_sizes), 
+      nb_exec(std::max(nb_exec, 1)), nb_warmup(nb_warmup)
+{
+}
+
+bool benchmark_runner::start()
+{
+    int inpipe_fd[2];
+    int outpipe_fd[2];
+
+    if (pipe(inpipe_fd) != 0)
+    {
+        perror("Can't create the pipes of the benchmark runner");
+        return false;
+    }
+    
+    if (pipe(outpipe_fd) != 0)
+    {
+        perror("Can't create the pipes of the benchmark runner");
+        close(inpipe_fd[0]);
+        close(inpipe_fd[1]);
+        return false;
+    }
+
+    // Flush our output buffers so that the runner doesn't inherit them
+    fflush(stdout);
+    fflush(stderr);
+
+    runner_pid = fork();
+    if (runner_pid < 0)
+    {
+        perror("Can't start the benchmark runner");
+        
+        close(inpipe_fd[0]);
+        close(inpipe_fd[1]);
+        close(outpipe_fd[0]);
+        close(outpipe_fd[1]);
+        
+        runner_pid = -1;
+        return false;
+    }
+    
+    if (runner_pid == 0)
+    {
+        close(outpipe_fd[1]);
+        close(inpipe_fd[0]);
+
+        runner_main(outpipe_fd[0], inpipe_fd[1]);
+    }
+
+    close(outpipe_fd[0]);
+    close(inpipe_fd[1]);
+
+    runner_write = fdopen(outpipe_fd[1], "w");
+    runner_read = fdopen(inpipe_fd[0], "r");
+    
+    return true;
+}
+
+void benchmark_runner::stop()
+{
+    if (runner_pid <= 0)
+        return ;
+
+    fclose(runner_write);
+    fclose(runner_read);
+
+    kill(runner_pid, SIGKILL);
+    waitpid(runner_pid, nullptr, 0);
+
+    runner_pid = -1;
+    runner_write = nullptr;
+    runner_read = nullptr;
+}
+
+float benchmark_runner::run(std::string const& so_path)
+{
+    timing_stats stats;
+    return run(so_path, stats);
+}
+
+float benchmark_runner::run(std::string const& so_path, timing_stats& stats, double time_limit)
+{
+    stats = timing_stats();
+
+    // dlopen only loads a path containing a slash, it searches the library path otherwise
+    std::string absolute_so_path = so_path;
+    char *resolved_path = realpath(so_path.c_str(), nullptr);
+    
+    if (resolved_path != nullptr)
+    {
+        absolute_so_path = resolved_path;
+        free(resolved_path);
+    }
+    
+    else if (so_path.find('/') == std::string::npos)
+        absolute_so_path = "./" + so_path;
+
+    // If the runner died, writing to its pipe must not kill the autoscheduler.
+    // SIGPIPE is only ignored during the write, the handler of the program is restored after.
+    struct sigaction ignore_action, previous_action;
+    memset(&ignore_action, 0, sizeof(ignore_action));
+    ignore_action.sa_handler = SIG_IGN;
+    sigemptyset(&ignore_action.sa_mask);
+    
+    // If the runner died before the schedule (e.g. killed after answering for the previous one),
+    // the write fails : restart the runner and send the schedule again, so that the schedule
+    // is not reported as failed.
+    bool command_sent = false;
+    for (int attempt = 0; attempt < 2 && !command_sent; ++attempt)
+    {
+        if (runner_pid <= 0 && !start())
+            return FLT_MAX;
+            
+        sigaction(SIGPIPE, &ignore_action, &previous_action);
+        
+        fprintf(runner_write, "%lf %s\n", time_limit, absolute_so_path.c_str());
+        command_sent = (fflush(runner_write) == 0);
+        
+        sigaction(SIGPIPE, &previous_action, nullptr);
+        
+        if (!command_sent)
+            stop();
+    }
+    
+    if (!command_sent)
+        return FLT_MAX;
+    
+    // Wait for the answer of the runner. If the schedule doesn't finish in time,
+    // kill the runner, it will be restarted for the next schedule.
+    if (time_limit > 0)
+    {
+        double timeout = time_limit * (nb_warmup + std::max(nb_exec, max_nb_exec)) / 1000 + TIMEOUT_SLACK;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+        
+        struct pollfd poll_fd;
+        poll_fd.fd = fileno(runner_read);
+        poll_fd.events = POLLIN;
+        
+        // A signal interrupts poll : wait again for the remaining time
+        int nb_ready;
+        do
+        {
+            int remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            nb_ready = remaining_ms <= 0 ? 0 : poll(&poll_fd, 1, remaining_ms);
+        } while (nb_ready < 0 && errno == EINTR);
+        
+        if (nb_ready == 0)
+        {
+            stop();
+            
+            stats.timed_out = true;
+            stats.median = stats.mean = time_limit;
+            
+            return time_limit;
+        }
+    }
+
+    char answer[256];
+    double mean = -1, median = -1, ci_low = -1, ci_high = -1;
+    int nb_runs = 0;
+
+    // The runner died while executing the schedule, restart it for the next one
+    if (fgets(answer, sizeof(answer), runner_read) == nullptr)
+    {
+        stop();
+        return FLT_MAX;
+    }
+    
+    // The runner stopped an execution that exceeded the time limit
+    if (answer[0] == 'T')
+    {
+        sscanf(answer + 1, "%lf", &median);
+        
+        stats.timed_out = true;
+        stats.median = stats.mean = median;
+        
+        return median;
+    }
+
+    if (sscanf(answer, "%lf %lf %lf %lf %d", &mean, &median, &ci_low, &ci_high, &nb_runs) != 5 || median < 0)
+        return FLT_MAX;
+        
+    stats.mean = mean;
+    stats.median = median;
+    stats.ci_low = ci_low;
+    stats.ci_high = ci_high;
+    stats.nb_runs = nb_runs;
+
+    return median;
+}
+
+void benchmark_runner::set_adaptive_timing(int max_nb_exec, double target_precision)
+{
+    this->max_nb_exec = max_nb_exec;
+    this->target_precision = target_precision;
+    stop();
+}
+
+void benchmark_runner::set_cpus(std::vector<int> const& cpus)
+{
+    this->cpus = cpus;
+    stop();
+}
+
+void benchmark_runner::set_cache_flush(bool flush_cache, int cache_flush_size)
+{
+    this->flush_cache = flush_cache;
+    this->cache_flush_size = cache_flush_size;
+    stop();
+}
+
+void benchmark_runner::runner_main(int read_fd, int write_fd)
+{
+    FILE *cmd_read = fdopen(read_fd, "r");
+    FILE *time_write = fdopen(write_fd, "w");
+    
+    // Pin the runner to the given cores, and size the Halide thread pool accordingly.
+    // The variable must be set before the first schedule starts the thread pool.
+    if (!cpus.empty())
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        
+        for (int cpu : cpus)
+            CPU_SET(cpu, &cpu_set);
+            
+        sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+        setenv("HL_NUM_THREADS", std::to_string(cpus.size()).c_str(), 1);
+    }
+    
+    std::vector<char> flush_buffer;
+    if (flush_cache)
+        flush_buffer.resize(cache_flush_size);
+
+    // Allocate and initialize the buffers once for all schedules.
+    // Halide stores dimensions from innermost to outermost, so sizes are reversed.
+    std::vector<Halide::Buffer<>> buffers;
+    std::vector<void*> fct_args;
+
+    for (int i = 0; i < arguments.size(); ++i)
+    {
+        tiramisu::buffer *buf = arguments[i];
+        std::vector<int> sizes(buffer_sizes[i].rbegin(), buffer_sizes[i].rend());
+
+        Halide::Buffer<> halide_buf(halide_type_from_tiramisu_type(buf->get_elements_type()), sizes);
+
+        switch (buf->get_elements_type())
+        {
+            case p_uint8:   fill_buffer<uint8_t>(halide_buf);   break;
+            case p_int8:    fill_buffer<int8_t>(halide_buf);    break;
+            case p_uint16:  fill_buffer<uint16_t>(halide_buf);  break;
+            case p_int16:   fill_buffer<int16_t>(halide_buf);   break;
+            case p_uint32:  fill_buffer<uint32_t>(halide_buf);  break;
+            case p_int32:   fill_buffer<int32_t>(halide_buf);   break;
+            case p_uint64:  fill_buffer<uint64_t>(halide_buf);  break;
+            case p_int64:   fill_buffer<int64_t>(halide_buf);   break;
+            case p_float32: fill_buffer<float>(halide_buf);     break;
+            case p_float64: fill_buffer<double>(halide_buf);    break;
+            case p_boolean: fill_buffer<bool>(halide_buf);      break;
+            default:        break;
+        }
+
+        buffers.push_back(halide_buf);
+    }
+    
+    // Halide::Buffer objects hold their halide_buffer_t, so take the addresses
+    // once the vector won't move anymore.
+    for (Halide::Buffer<>& halide_buf : buffers)
+        fct_args.push_back(halide_buf.raw_buffer());
+
+    std::string argv_name = fct_name + "_argv";
+    char command[4096];
+    char so_path[4096];
+
+    while (fgets(command, sizeof(command), cmd_read) != nullptr)
+    {
+        double time_limit = 0;
+        if (sscanf(command, "%lf %4095[^\n]", &time_limit, so_path) != 2)
+            continue;
+            
+        timing_stats stats;
+        bool executed = false;
+
+        void *handle = dlopen(so_path, RTLD_NOW | RTLD_LOCAL);
+        if (handle != nullptr)
+        {
+            int (*fct_argv)(void**) = (int (*)(void**))dlsym(handle, argv_name.c_str());
+
+            if (fct_argv != nullptr)
+            {
+                std::vector<double> durations;
+                bool failed = false;
+
+                // Stop as soon as an execution exceeds the time limit, or fails
+                for (int i = 0; i < nb_warmup && !stats.timed_out && !failed; ++i)
+                {
+                    auto begin = std::chrono::steady_clock::now();
+                    failed = (fct_argv(fct_args.data()) != 0);
+                    auto end = std::chrono::steady_clock::now();
+                    
+                    double duration = std::chrono::duration<double, std::milli>(end - begin).count();
+                    if (!failed && time_limit > 0 && duration > time_limit)
+                    {
+                        stats.timed_out = true;
+                        stats.median = duration;
+                    }
+                }
+
+                // Execute at least nb_exec times, then until the confidence interval is tight enough
+                while (!stats.timed_out && !failed && (durations.size() < nb_exec || durations.size() < max_nb_exec))
+                {
+                    if (durations.size() >= nb_exec)
+                    {
+                        stats = get_timing_stats(durations);
+                        if (stats.get_ci_half_width() <= target_precision * stats.mean)
+                            break;
+                    }
+                    
+                    // Evict the data of the program from the caches
+                    if (flush_cache)
+                    {
+                        volatile char *flush_data = flush_buffer.data();
+                        for (int i = 0; i < flush_buffer.size(); i += 64)
+                            flush_data[i]++;
+                    }
+                    
+                    auto begin = std::chrono::steady_clock::now();
+                    failed = (fct_argv(fct_args.data()) != 0);
+                    auto end = std::chrono::steady_clock::now();
+
+                    // A nonzero return value is a Halide error, the schedule can't be timed
+                    if (failed)
+                        break;
+
+                    durations.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+                    
+                    if (time_limit > 0 && durations.back() > time_limit)
+                    {
+                        stats.timed_out = true;
+                        stats.median = durations.back();
+                    }
+                }
+
+                if (!stats.timed_out && !failed)
+                    stats = get_timing_stats(durations);
+                    
+                executed = !failed;
+            }
+
+            // Each shared library embeds its own Halide runtime. Its threads must be
+            // stopped before unloading the library.
+            void (*shutdown_thread_pool)() = (void (*)())dlsym(handle, "halide_shutdown_thread_pool");
+            if (shutdown_thread_pool != nullptr)
+                shutdown_thread_pool();
+
+            dlclose(handle);
+        }
+
+        if (stats.timed_out)
+            fprintf(time_write, "T %lf\n", stats.median);
+        else if (executed)
+            fprintf(time_write, "%lf %lf %lf %lf %d\n", stats.mean, stats.median, stats.ci_low, stats.ci_high, stats.nb_runs);
+        else
+            fprintf(time_write, "-1 -1 -1 -1 0\n");
+            
+        fflush(time_write);
+    }
+
+    _exit(0);
+}
+
+}
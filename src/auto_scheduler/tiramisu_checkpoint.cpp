@@ -0,0 +1,169 @@
+#include <tiramisu/auto_scheduler/checkpoint.h>
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace tiramisu::auto_scheduler
+{
+
+search_checkpoint::search_checkpoint(std::string const& checkpoint_dir, double save_interval)
+    : checkpoint_dir(checkpoint_dir), save_interval(save_interval)
+{
+    mkdir(checkpoint_dir.c_str(), 0755);
+
+    eval_cache = new evaluation_cache(checkpoint_dir + "/evaluations.db");
+    exec_cache = new evaluation_cache(checkpoint_dir + "/executions.db");
+}
+
+search_checkpoint::~search_checkpoint()
+{
+    delete eval_cache;
+    delete exec_cache;
+}
+
+bool search_checkpoint::load_state(syntax_tree const& ast)
+{
+    std::ifstream state_file(checkpoint_dir + "/state");
+    if (!state_file)
+        return false;
+
+    std::vector<tiramisu::computation*> const& comps = ast.computations_list;
+    std::vector<optimization_info> optims;
+    std::string line;
+
+    double elapsed = 0;
+    int nb_comps = -1, nb_compils = 0, nb_execs = 0;
+    float best_eval = FLT_MAX;
+
+    while (std::getline(state_file, line))
+    {
+        std::istringstream line_stream(line);
+        std::string field;
+        line_stream >> field;
+
+        if (field == "elapsed_time")
+            line_stream >> elapsed;
+
+        else if (field == "nb_compilations")
+            line_stream >> nb_compils;
+
+        else if (field == "nb_executions")
+            line_stream >> nb_execs;
+
+        else if (field == "nb_computations")
+            line_stream >> nb_comps;
+
+        else if (field == "best_evaluation")
+            line_stream >> best_eval;
+
+        // An optimization of the best schedule.
+        // Computations are identified by their index in the AST.
+        else if (field == "optim")
+        {
+            optimization_info optim_info;
+            int type, nb_optim_comps;
+
+            line_stream >> type >> optim_info.nb_l >> optim_info.l0 >> optim_info.l1 >> optim_info.l2
+                        >> optim_info.l0_fact >> optim_info.l1_fact >> optim_info.l2_fact >> nb_optim_comps;
+
+            optim_info.type = (optimization_type)type;
+            optim_info.node = nullptr;
+
+            for (int i = 0; i < nb_optim_comps; ++i)
+            {
+                int comp_index = -1;
+                line_stream >> comp_index;
+
+                if (comp_index < 0 || comp_index >= comps.size())
+                    return false;
+
+                optim_info.comps.push_back(comps[comp_index]);
+            }
+
+            if (!line_stream)
+                return false;
+
+            optims.push_back(optim_info);
+        }
+    }
+
+    // The checkpoint was made for another program
+    if (!optims.empty() && nb_comps != comps.size())
+        return false;
+
+    elapsed_time = elapsed;
+    nb_compilations = nb_compils;
+    nb_executions = nb_execs;
+    best_evaluation = best_eval;
+    best_optims = optims;
+    resumed = true;
+
+    return true;
+}
+
+syntax_tree* search_checkpoint::get_best_ast(syntax_tree const& ast) const
+{
+    if (best_evaluation == FLT_MAX)
+        return nullptr;
+
+    syntax_tree *best_ast = ast.copy_ast();
+    best_ast->replay_optimizations(best_optims);
+    best_ast->evaluation = best_evaluation;
+
+    return best_ast;
+}
+
+bool search_checkpoint::save_due() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - last_save).count() >= save_interval;
+}
+
+void search_checkpoint::save_state(syntax_tree const *best_ast, float best_evaluation, double elapsed_time,
+                                   int nb_compilations, int nb_executions)
+{
+    last_save = std::chrono::steady_clock::now();
+
+    std::string state_path = checkpoint_dir + "/state";
+    std::string tmp_path = state_path + ".tmp";
+
+    std::ofstream state_file(tmp_path);
+    if (!state_file)
+        return ;
+
+    state_file.precision(9);
+    state_file << "elapsed_time " << elapsed_time << std::endl;
+    state_file << "nb_compilations " << nb_compilations << std::endl;
+    state_file << "nb_executions " << nb_executions << std::endl;
+
+    if (best_ast != nullptr)
+    {
+        std::vector<tiramisu::computation*> const& comps = best_ast->computations_list;
+        state_file << "nb_computations " << comps.size() << std::endl;
+        state_file << "best_evaluation " << best_evaluation << std::endl;
+
+        std::vector<optimization_info> optims = best_ast->previous_optims;
+        optims.insert(optims.end(), best_ast->new_optims.begin(), best_ast->new_optims.end());
+
+        for (optimization_info const& optim_info : optims)
+        {
+            state_file << "optim " << (int)optim_info.type << " " << optim_info.nb_l << " "
+                       << optim_info.l0 << " " << optim_info.l1 << " " << optim_info.l2 << " "
+                       << optim_info.l0_fact << " " << optim_info.l1_fact << " " << optim_info.l2_fact << " "
+                       << optim_info.comps.size();
+
+            for (tiramisu::computation *comp : optim_info.comps)
+                state_file << " " << std::find(comps.begin(), comps.end(), comp) - comps.begin();
+
+            state_file << std::endl;
+        }
+    }
+
+    state_file.close();
+    rename(tmp_path.c_str(), state_path.c_str());
+}
+
+}
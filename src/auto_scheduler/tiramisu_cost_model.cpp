@@ -0,0 +1,428 @@
+#include <tiramisu/auto_scheduler/cost_model.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * Read a size written as in sysfs ("32K", "8192K", "1M", "64") and return it in bytes.
+ * Return -1 if the file can't be read.
+ */
+static int read_sysfs_size(std::string const& path)
+{
+    std::ifstream file(path);
+    
+    long size;
+    if (!(file >> size))
+        return -1;
+        
+    char unit = 0;
+    file >> unit;
+    
+    if (unit == 'K')
+        size *= 1024;
+    else if (unit == 'M')
+        size *= 1024 * 1024;
+        
+    return size;
+}
+
+machine_description get_host_machine_description()
+{
+    machine_description machine;
+    
+    int nb_cores = std::thread::hardware_concurrency();
+    if (nb_cores > 0)
+        machine.nb_cores = nb_cores;
+        
+    // Each indexN directory describes a cache level. Instruction caches are ignored.
+    for (int index = 0; ; ++index)
+    {
+        std::string cache_dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        
+        std::ifstream level_file(cache_dir + "level");
+        std::ifstream type_file(cache_dir + "type");
+        
+        int level;
+        std::string type;
+        
+        if (!(level_file >> level) || !(type_file >> type))
+            break;
+            
+        if (type == "Instruction")
+            continue;
+            
+        int size = read_sysfs_size(cache_dir + "size");
+        if (size <= 0)
+            continue;
+            
+        if (level == 1)
+            machine.l1_size = size;
+        else if (level == 2)
+            machine.l2_size = size;
+        else if (level == 3)
+            machine.l3_size = size;
+            
+        int line_size = read_sysfs_size(cache_dir + "coherency_line_size");
+        if (line_size > 0)
+            machine.cache_line_size = line_size;
+    }
+    
+    return machine;
+}
+
+bool read_machine_description(std::string const& config_path, machine_description& machine)
+{
+    FILE *config_file = fopen(config_path.c_str(), "r");
+    if (config_file == nullptr)
+        return false;
+        
+    char field[64];
+    double value;
+    
+    while (fscanf(config_file, "%63s %lf", field, &value) == 2)
+    {
+        if (strcmp(field, "l1_size") == 0) machine.l1_size = value;
+        else if (strcmp(field, "l2_size") == 0) machine.l2_size = value;
+        else if (strcmp(field, "l3_size") == 0) machine.l3_size = value;
+        else if (strcmp(field, "cache_line_size") == 0) machine.cache_line_size = value;
+        else if (strcmp(field, "vector_width") == 0) machine.vector_width = value;
+        else if (strcmp(field, "nb_cores") == 0) machine.nb_cores = value;
+        else if (strcmp(field, "frequency") == 0) machine.frequency = value;
+        else if (strcmp(field, "l2_bandwidth") == 0) machine.l2_bandwidth = value;
+        else if (strcmp(field, "l3_bandwidth") == 0) machine.l3_bandwidth = value;
+        else if (strcmp(field, "mem_bandwidth") == 0) machine.mem_bandwidth = value;
+        else if (strcmp(field, "ipc") == 0) machine.ipc = value;
+        else if (strcmp(field, "loop_overhead") == 0) machine.loop_overhead = value;
+        else if (strcmp(field, "division_cost") == 0) machine.division_cost = value;
+        else if (strcmp(field, "autovectorization_efficiency") == 0) machine.autovectorization_efficiency = value;
+        else if (strcmp(field, "parallel_overhead") == 0) machine.parallel_overhead = value;
+        else if (strcmp(field, "max_unrolled_body") == 0) machine.max_unrolled_body = value;
+    }
+    
+    fclose(config_file);
+    return true;
+}
+
+int get_type_size(primitive_t type)
+{
+    switch (type)
+    {
+        case p_uint8:
+        case p_int8:
+        case p_boolean:
+            return 1;
+
+        case p_uint16:
+        case p_int16:
+            return 2;
+
+        case p_uint64:
+        case p_int64:
+        case p_float64:
+            return 8;
+
+        default:
+            return 4;
+    }
+}
+
+/**
+ * Loop levels created by tiling and unrolling are named after the loop level they split,
+ * followed by "_outer" or "_inner". Split the given name into the original name
+ * and the list of suffixes.
+ */
+static std::string get_base_name(std::string const& name, std::vector<dnn_iterator> const& iters,
+                                 std::vector<std::string>& suffixes)
+{
+    std::string base_name = name;
+    const std::string outer_suffix = "_outer", inner_suffix = "_inner";
+
+    auto is_iterator = [&](std::string const& str) {
+        for (dnn_iterator const& it : iters)
+            if (it.name == str)
+                return true;
+        return false;
+    };
+
+    while (!is_iterator(base_name) && base_name.size() > outer_suffix.size())
+    {
+        std::string suffix = base_name.substr(base_name.size() - outer_suffix.size());
+        if (suffix != outer_suffix && suffix != inner_suffix)
+            break;
+
+        suffixes.insert(suffixes.begin(), suffix);
+        base_name.erase(base_name.size() - suffix.size());
+    }
+
+    return base_name;
+}
+
+std::vector<evaluate_by_cost_model::loop_info> evaluate_by_cost_model::get_loop_nest(ast_node *node, computation_info const& comp_info) const
+{
+    std::vector<ast_node*> nodes;
+    for (ast_node *n = node; n != nullptr; n = n->parent)
+        nodes.insert(nodes.begin(), n);
+
+    std::vector<std::string> names;
+    std::vector<std::string> base_names;
+    std::vector<std::vector<std::string>> suffixes(nodes.size());
+
+    for (int i = 0; i < nodes.size(); ++i)
+    {
+        names.push_back(nodes[i]->name);
+        base_names.push_back(get_base_name(nodes[i]->name, comp_info.iters, suffixes[i]));
+    }
+
+    // Map each original loop level to an iterator of the computation.
+    // If the names don't match (computations fused with different iterator names),
+    // take the first iterator not used yet.
+    std::vector<bool> used_iters(comp_info.iters.size(), false);
+    std::unordered_map<std::string, int> base_to_iter;
+
+    for (std::string const& base_name : base_names)
+        for (int j = 0; j < comp_info.iters.size(); ++j)
+            if (comp_info.iters[j].name == base_name)
+            {
+                base_to_iter[base_name] = j;
+                used_iters[j] = true;
+            }
+
+    for (std::string const& base_name : base_names)
+    {
+        if (base_to_iter.find(base_name) != base_to_iter.end())
+            continue;
+
+        base_to_iter[base_name] = -1;
+        for (int j = 0; j < comp_info.iters.size(); ++j)
+            if (!used_iters[j])
+            {
+                base_to_iter[base_name] = j;
+                used_iters[j] = true;
+                break;
+            }
+    }
+
+    std::vector<loop_info> loops;
+    for (int i = 0; i < nodes.size(); ++i)
+    {
+        loop_info loop;
+        loop.iter_index = base_to_iter[base_names[i]];
+        loop.extent = std::max(nodes[i]->get_extent(), 1);
+        loop.unrolled = nodes[i]->unrolled;
+        loop.parallel = nodes[i]->parallelized;
+        loop.vectorized = nodes[i]->vectorized;
+
+        // An outer loop level steps over all the iterations of its inner counterpart
+        loop.stride = 1;
+        std::string prefix = base_names[i];
+
+        for (std::string const& suffix : suffixes[i])
+        {
+            if (suffix == "_outer")
+            {
+                std::string inner_prefix = prefix + "_inner";
+                for (int j = 0; j < nodes.size(); ++j)
+                    if (names[j] == inner_prefix || names[j].compare(0, inner_prefix.size() + 1, inner_prefix + "_") == 0)
+                        loop.stride *= std::max(nodes[j]->get_extent(), 1);
+            }
+
+            prefix += suffix;
+        }
+
+        loops.push_back(loop);
+    }
+
+    return loops;
+}
+
+double evaluate_by_cost_model::estimate_computation(std::vector<loop_info> const& loops, computation_info const& comp_info, bool parallel) const
+{
+    int nb_loops = loops.size();
+    int nb_iters = comp_info.iters.size();
+    int elem_size = get_type_size(comp_info.comp_ptr->get_data_type());
+
+    // The accesses of the computation, including the store (the store is not in the access matrices).
+    // Each row gives the coefficients of the iterators in a dimension of the buffer.
+    std::vector<std::vector<std::vector<int>>> accesses;
+
+    std::vector<std::vector<int>> store(comp_info.buffer_nb_dims, std::vector<int>(nb_iters, 0));
+    for (int i = 0; i < comp_info.buffer_nb_dims && i < nb_iters; ++i)
+        store[i][i] = 1;
+
+    accesses.push_back(store);
+    for (dnn_access_matrix const& matrix : comp_info.accesses.accesses_list)
+        accesses.push_back(matrix.matrix);
+
+    auto coeff = [&](std::vector<int> const& row, int iter_index) {
+        if (iter_index < 0 || iter_index >= row.size() || iter_index >= nb_iters)
+            return 0;
+        return std::abs(row[iter_index]);
+    };
+
+    // Number of executions of the computation
+    double nb_executions = 1;
+    for (loop_info const& loop : loops)
+        nb_executions *= loop.extent;
+
+    // Footprint, in cache lines, of the accesses made by the loop levels from level to the innermost one.
+    // footprint[nb_loops] is the footprint of one execution of the computation.
+    std::vector<double> footprint(nb_loops + 1, 0);
+    for (int level = 0; level <= nb_loops; ++level)
+    {
+        for (auto const& access : accesses)
+        {
+            double nb_lines = 1;
+
+            for (int r = 0; r < access.size(); ++r)
+            {
+                double span = 1;
+                for (int l = level; l < nb_loops; ++l)
+                    span += (double)coeff(access[r], loops[l].iter_index) * loops[l].stride * (loops[l].extent - 1);
+
+                // The last dimension is contiguous in memory
+                if (r == access.size() - 1)
+                    nb_lines *= std::ceil(span * elem_size / machine.cache_line_size);
+                else
+                    nb_lines *= span;
+            }
+
+            footprint[level] += nb_lines;
+        }
+    }
+
+    // Number of cache lines loaded into a cache of the given size : the data used by the outermost
+    // loop level that fits in the cache is loaded once per iteration of the loop levels above it.
+    auto get_nb_misses = [&](int cache_size) {
+        int level = 0;
+        while (level < nb_loops && footprint[level] * machine.cache_line_size > cache_size)
+            level++;
+
+        double nb_outer_iterations = 1;
+        for (int l = 0; l < level; ++l)
+            nb_outer_iterations *= loops[l].extent;
+
+        return footprint[level] * nb_outer_iterations;
+    };
+
+    double l1_misses = get_nb_misses(machine.l1_size);
+    double l2_misses = get_nb_misses(machine.l2_size);
+    double l3_misses = get_nb_misses(machine.l3_size);
+
+    // Vectorization : the innermost loop level must access the output contiguously,
+    // and must access the inputs either contiguously or always at the same address.
+    int innermost = nb_loops - 1;
+    while (innermost > 0 && loops[innermost].extent <= 1)
+        innermost--;
+
+    double vector_factor = 1;
+    if (innermost >= 0 && loops[innermost].stride == 1)
+    {
+        int iter_index = loops[innermost].iter_index;
+        bool vectorizable = !store.empty() && coeff(store.back(), iter_index) == 1;
+
+        for (auto const& access : accesses)
+            for (int r = 0; r < access.size(); ++r)
+            {
+                int c = coeff(access[r], iter_index);
+                if ((r < access.size() - 1 && c != 0) || c > 1)
+                    vectorizable = false;
+            }
+
+        // Loop levels that are not tagged to be vectorized are left to the compiler's auto-vectorizer
+        if (vectorizable)
+        {
+            vector_factor = std::min(machine.vector_width / elem_size, loops[innermost].extent);
+            if (!loops[innermost].vectorized)
+                vector_factor = std::max(1.0, vector_factor * machine.autovectorization_efficiency);
+        }
+    }
+
+    // Arithmetic cost
+    double nb_ops = comp_info.nb_additions + comp_info.nb_substractions + comp_info.nb_multiplications
+                  + machine.division_cost * comp_info.nb_divisions + 1;
+
+    double arith_cycles = nb_executions * nb_ops / (machine.ipc * vector_factor);
+
+    // Loop overhead, reduced by unrolling if the unrolled body fits in registers
+    double unroll_factor = 1;
+    for (loop_info const& loop : loops)
+        if (loop.unrolled)
+            unroll_factor *= loop.extent;
+
+    if (unroll_factor * nb_ops > machine.max_unrolled_body)
+        unroll_factor = 1;
+
+    double overhead_cycles = nb_executions * machine.loop_overhead / (unroll_factor * vector_factor);
+
+    // Memory cost
+    double cache_cycles = l1_misses * machine.cache_line_size / machine.l2_bandwidth
+                        + l2_misses * machine.cache_line_size / machine.l3_bandwidth;
+
+    double mem_cycles = l3_misses * machine.cache_line_size / (machine.mem_bandwidth / machine.frequency);
+
+    // The parallel loop level is distributed among the cores. The memory bandwidth is shared.
+    // If no loop level is tagged to be parallel, the outermost one is parallelized.
+    int parallel_level = -1;
+    if (parallel && nb_loops > 0)
+        parallel_level = 0;
+        
+    for (int l = 0; l < nb_loops && !parallel; ++l)
+        if (loops[l].parallel)
+        {
+            parallel_level = l;
+            break;
+        }
+            
+    double parallel_factor = 1;
+    double parallel_cycles = 0;
+    
+    if (parallel_level != -1)
+    {
+        double extent = loops[parallel_level].extent;
+        parallel_factor = extent / std::ceil(extent / machine.nb_cores);
+        
+        // The threads are started at each iteration of the loop levels above the parallel one
+        parallel_cycles = machine.parallel_overhead;
+        for (int l = 0; l < parallel_level; ++l)
+            parallel_cycles *= loops[l].extent;
+    }
+
+    return (arith_cycles + overhead_cycles + cache_cycles) / parallel_factor + mem_cycles + parallel_cycles;
+}
+
+double evaluate_by_cost_model::estimate_node(ast_node *node, bool parallel) const
+{
+    double cycles = 0;
+
+    for (auto const& comp_info : node->computations)
+        cycles += estimate_computation(get_loop_nest(node, *comp_info), *comp_info, parallel);
+
+    for (ast_node *child : node->children)
+        cycles += estimate_node(child, parallel);
+
+    return cycles;
+}
+
+float evaluate_by_cost_model::evaluate(syntax_tree& ast)
+{
+    double cycles = 0;
+
+    // evaluate_by_execution parallelizes the outermost loop level of each computation,
+    // unless the schedule parallelizes another loop level
+    bool parallelize_outermost = !ast_has_optimization(ast, optimization_type::PARALLELIZE);
+    
+    for (ast_node *root : ast.roots)
+        cycles += estimate_node(root, parallelize_outermost);
+
+    // Cycles to milliseconds
+    return cycles / (machine.frequency * 1e6);
+}
+
+}
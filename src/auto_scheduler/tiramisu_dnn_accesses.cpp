@@ -4,12 +4,44 @@ namespace tiramisu::auto_scheduler
 {
 
 std::vector<dnn_iterator> 
-dnn_iterator::get_iterators_from_computation(tiramisu::computation const& comp)
+dnn_iterator::get_iterators_from_computation(tiramisu::computation const& comp, parameters_values const& params)
 {
     std::vector<dnn_iterator> iters_list;
     
     // In the next lines, we use Tiramisu internals to get information about iterators
-    isl_set *iter_domain = comp.get_iteration_domain();
+    isl_set *iter_domain = isl_set_copy(comp.get_iteration_domain());
+    
+    // Symbolic loop bounds : give a value to each parameter, and remove the parameters from the domain
+    if (isl_set_dim(iter_domain, isl_dim_param) > 0)
+    {
+        isl_set *context = comp.get_function()->get_program_context();
+        if (context != nullptr)
+            iter_domain = isl_set_intersect_params(iter_domain, context);
+            
+        int nb_params = isl_set_dim(iter_domain, isl_dim_param);
+        for (int i = 0; i < nb_params; ++i)
+        {
+            std::string param_name = isl_set_get_dim_name(iter_domain, isl_dim_param, i);
+            auto param_it = params.find(param_name);
+            
+            if (param_it != params.end())
+            {
+                iter_domain = isl_set_fix_si(iter_domain, isl_dim_param, i, param_it->second);
+                continue;
+            }
+            
+            isl_val *value = isl_set_plain_get_val_if_fixed(iter_domain, isl_dim_param, i);
+            bool is_fixed = isl_val_is_int(value);
+            isl_val_free(value);
+            
+            if (!is_fixed)
+                ERROR("The auto-scheduler needs a value for the parameter " + param_name + 
+                      " of the computation " + comp.get_name() + ".", true);
+        }
+        
+        iter_domain = isl_set_project_out(iter_domain, isl_dim_param, 0, nb_params);
+    }
+    
     int nb_iterators = isl_set_dim(iter_domain, isl_dim_set);
     
     for (int i = 0; i < nb_iterators; ++i)
@@ -21,6 +53,7 @@ dnn_iterator::get_iterators_from_computation(tiramisu::computation const& comp)
         iters_list.push_back(dnn_iterator(name, low_bound, up_bound));
     }
     
+    isl_set_free(iter_domain);
     return iters_list;
 }
 
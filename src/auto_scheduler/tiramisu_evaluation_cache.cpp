@@ -0,0 +1,93 @@
+#include <tiramisu/auto_scheduler/evaluation_cache.h>
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace tiramisu::auto_scheduler
+{
+
+evaluation_cache::evaluation_cache(std::string const& db_path)
+    : db_path(db_path)
+{
+    if (db_path.empty())
+        return ;
+
+    FILE *db_file = fopen(db_path.c_str(), "r");
+    if (db_file == nullptr)
+        return ;
+
+    char line[256];
+
+    while (fgets(line, sizeof(line), db_file) != nullptr)
+    {
+        uint64_t fingerprint;
+        cached_evaluation entry;
+        int estimated = 0;
+
+        // The confidence interval and the estimated flag are missing from older databases
+        int nb_fields = sscanf(line, "%" SCNx64 " %f %f %d", &fingerprint, &entry.evaluation, &entry.ci, &estimated);
+        if (nb_fields < 2)
+            continue;
+
+        if (nb_fields < 3)
+            entry.ci = 0;
+
+        entry.estimated = estimated != 0;
+        evaluations[fingerprint] = entry;
+    }
+
+    fclose(db_file);
+}
+
+bool evaluation_cache::find(syntax_tree const& ast, float& evaluation)
+{
+    float ci;
+    return find(ast, evaluation, ci);
+}
+
+bool evaluation_cache::find(syntax_tree const& ast, float& evaluation, float& ci)
+{
+    auto it = evaluations.find(ast.get_fingerprint());
+
+    if (it == evaluations.end())
+    {
+        nb_misses++;
+        return false;
+    }
+
+    nb_hits++;
+    evaluation = it->second.evaluation;
+    ci = it->second.ci;
+
+    return true;
+}
+
+bool evaluation_cache::is_estimated(syntax_tree const& ast) const
+{
+    auto it = evaluations.find(ast.get_fingerprint());
+    return it != evaluations.end() && it->second.estimated;
+}
+
+void evaluation_cache::insert(syntax_tree const& ast, float evaluation, float ci, bool estimated)
+{
+    uint64_t fingerprint = ast.get_fingerprint();
+
+    cached_evaluation& entry = evaluations[fingerprint];
+    entry.evaluation = evaluation;
+    entry.ci = ci;
+    entry.estimated = estimated;
+
+    if (db_path.empty())
+        return ;
+
+    // Append the evaluation to the database, so that it is kept
+    // even if the search is interrupted.
+    FILE *db_file = fopen(db_path.c_str(), "a");
+    if (db_file == nullptr)
+        return ;
+
+    fprintf(db_file, "%" PRIx64 " %.9g %.9g %d\n", fingerprint, evaluation, ci, estimated ? 1 : 0);
+    fclose(db_file);
+}
+
+}
@@ -1,16 +1,44 @@
 #include <tiramisu/auto_scheduler/evaluator.h>
+#include <tiramisu/object_cache.h>
 
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <signal.h>
+#include <poll.h>
 
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cfloat>
+#include <map>
+#include <unordered_set>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 
 namespace tiramisu::auto_scheduler
 {
 
+/**
+ * Return the number of seconds elapsed since the given time point.
+ */
+static double get_time_since(std::chrono::steady_clock::time_point const& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<float> evaluation_function::evaluate_batch(std::vector<syntax_tree*> const& asts)
+{
+    std::vector<float> evals;
+    
+    for (syntax_tree *ast : asts)
+        evals.push_back(evaluate(*ast));
+        
+    return evals;
+}
+
 evaluate_by_execution::evaluate_by_execution(std::vector<tiramisu::buffer*> const& arguments, 
                                              std::string const& obj_filename, 
                                              std::string const& wrapper_cmd,
@@ -35,43 +63,743 @@ evaluate_by_execution::evaluate_by_execution(std::vector<tiramisu::buffer*> cons
     }
 }
 
+/**
+ * Execute the given shell command, and read a number from its output (FLT_MAX if there is none).
+ * If timeout > 0, the command is killed after timeout seconds, and false is returned.
+ */
+static bool run_command(std::string const& cmd, double timeout, double& result)
+{
+    result = FLT_MAX;
+    
+    int pipe_fd[2];
+    if (pipe(pipe_fd) != 0)
+        return true;
+        
+    fflush(stdout);
+    fflush(stderr);
+    
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // Run the command in its own process group, so that it can be killed with its children
+        setpgid(0, 0);
+        
+        close(pipe_fd[0]);
+        dup2(pipe_fd[1], STDOUT_FILENO);
+        close(pipe_fd[1]);
+        
+        execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    
+    close(pipe_fd[1]);
+    
+    if (pid < 0)
+    {
+        close(pipe_fd[0]);
+        return true;
+    }
+    
+    // Read the output until the first line containing a number is complete, or until the
+    // command exits. The timeout applies to the whole output, not only to its beginning.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    std::string output;
+    bool success = true;
+    bool has_result = false;
+    
+    while (true)
+    {
+        if (timeout > 0)
+        {
+            int remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            
+            struct pollfd poll_fd;
+            poll_fd.fd = pipe_fd[0];
+            poll_fd.events = POLLIN;
+            
+            int nb_ready = remaining_ms <= 0 ? 0 : poll(&poll_fd, 1, remaining_ms);
+            if (nb_ready < 0 && errno == EINTR)
+                continue;
+                
+            if (nb_ready == 0)
+            {
+                kill(-pid, SIGKILL);
+                
+                // The command only failed if it didn't give its result in time
+                success = has_result;
+                break;
+            }
+        }
+        
+        char buffer[256];
+        ssize_t nb_read = read(pipe_fd[0], buffer, sizeof(buffer));
+        
+        if (nb_read < 0 && errno == EINTR)
+            continue;
+            
+        if (nb_read <= 0)
+            break;
+            
+        // Once the result is read, the rest of the output is only drained,
+        // so that the command doesn't block on a full pipe
+        if (has_result)
+            continue;
+            
+        output.append(buffer, nb_read);
+        
+        size_t result_begin = output.find_first_not_of(" \t\r\n");
+        has_result = result_begin != std::string::npos && output.find('\n', result_begin) != std::string::npos;
+    }
+    
+    if (!success || sscanf(output.c_str(), "%lf", &result) != 1)
+        result = FLT_MAX;
+        
+    close(pipe_fd[0]);
+    waitpid(pid, nullptr, 0);
+    
+    return success;
+}
+
+bool evaluate_by_execution::get_timed_out_evaluation(syntax_tree const& ast, float& evaluation) const
+{
+    auto it = timings.find(ast.get_fingerprint());
+    if (it == timings.end() || !it->second.timed_out)
+        return false;
+        
+    evaluation = it->second.median;
+    return true;
+}
+
 float evaluate_by_execution::evaluate(syntax_tree& ast)
 {
+    estimated_schedules.erase(ast.get_fingerprint());
+    
+    // A schedule that timed out is not executed again
+    float exec_time = FLT_MAX;
+    if (get_timed_out_evaluation(ast, exec_time))
+        return exec_time;
+        
+    // Compilations are done in a child process, so that they can be killed,
+    // or so that compute_at doesn't modify the function of the auto-scheduler
+    if (compile_timeout > 0 || ast_has_optimization(ast, optimization_type::COMPUTE_AT))
+        return compile_and_run_batch({&ast})[0];
+        
+    // Compile the program, then execute the wrapper and get execution time
+    
+    evaluation_phases sched_phases;
+    
+    auto begin = std::chrono::steady_clock::now();
+    bool compiled = compile_schedule(ast, obj_filename, sched_phases);
+    
+    compile_time += get_time_since(begin);
+    nb_compilations++;
+    
+    if (compiled)
+    {
+        auto exec_begin = std::chrono::steady_clock::now();
+        exec_time = run_schedule(obj_filename);
+        sched_phases.execution = get_time_since(exec_begin);
+        
+        if (!use_reduced_sizes)
+            timings[ast.get_fingerprint()] = last_timing;
+    }
+    
+    phases[ast.get_fingerprint()] += sched_phases;
+    
+    // Remove all the optimizations
+    fct->reset_schedules();
+    
+    return exec_time;
+}
+
+std::vector<float> evaluate_by_execution::evaluate_batch(std::vector<syntax_tree*> const& asts)
+{
+    // The schedules executed at full size are measured
+    for (syntax_tree *ast : asts)
+        estimated_schedules.erase(ast->get_fingerprint());
+        
+    // Executing the schedules on reduced iteration domains first would only
+    // compile them twice if all of them are executed at full size anyway
+    if (multi_fidelity_topk <= 0 || asts.size() <= multi_fidelity_topk)
+        return compile_and_run_batch(asts);
+        
+    // Rank the schedules on reduced iteration domains
+    use_reduced_sizes = true;
+    std::vector<float> reduced_evals = compile_and_run_batch(asts);
+    use_reduced_sizes = false;
+    
+    std::vector<int> indices;
+    for (int i = 0; i < asts.size(); ++i)
+        if (reduced_evals[i] != FLT_MAX)
+            indices.push_back(i);
+            
+    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
+        return reduced_evals[a] < reduced_evals[b];
+    });
+    
+    if (indices.size() > multi_fidelity_topk)
+        indices.resize(multi_fidelity_topk);
+        
+    // Execute the best schedules on full iteration domains
+    std::vector<syntax_tree*> topk_asts;
+    for (int i : indices)
+        topk_asts.push_back(asts[i]);
+        
+    std::vector<float> full_evals = compile_and_run_batch(topk_asts);
+    
+    std::vector<float> evals(asts.size(), FLT_MAX);
+    std::vector<double> ratios;
+    
+    for (int i = 0; i < indices.size(); ++i)
+    {
+        evals[indices[i]] = full_evals[i];
+        
+        if (full_evals[i] == FLT_MAX || reduced_evals[indices[i]] <= 0)
+            continue;
+            
+        reduced_exec_times.push_back(reduced_evals[indices[i]]);
+        full_exec_times.push_back(full_evals[i]);
+        ratios.push_back(full_evals[i] / reduced_evals[indices[i]]);
+    }
+    
+    if (ratios.empty())
+        return evals;
+        
+    // Estimate the full execution time of the other schedules.
+    // These estimates only rank the schedules, they are not execution times.
+    std::sort(ratios.begin(), ratios.end());
+    double ratio = ratios[ratios.size() / 2];
+    
+    for (int i = 0; i < asts.size(); ++i)
+        if (evals[i] == FLT_MAX && reduced_evals[i] != FLT_MAX && std::find(indices.begin(), indices.end(), i) == indices.end())
+        {
+            evals[i] = reduced_evals[i] * ratio;
+            estimated_schedules.insert(asts[i]->get_fingerprint());
+        }
+            
+    return evals;
+}
+
+void evaluate_by_execution::print_fidelity_report() const
+{
+    if (multi_fidelity_topk <= 0)
+        return ;
+        
+    int nb_schedules = full_exec_times.size();
+    std::cout << "NB schedules executed at reduced and full sizes : " << nb_schedules << std::endl;
+    
+    if (nb_schedules < 2)
+        return ;
+        
+    // Fraction of pairs of schedules ordered the same way at both sizes
+    int nb_pairs = 0, nb_agreements = 0;
+    
+    for (int i = 0; i < nb_schedules; ++i)
+        for (int j = i + 1; j < nb_schedules; ++j)
+        {
+            if (full_exec_times[i] == full_exec_times[j])
+                continue;
+                
+            nb_pairs++;
+            if ((reduced_exec_times[i] < reduced_exec_times[j]) == (full_exec_times[i] < full_exec_times[j]))
+                nb_agreements++;
+        }
+        
+    if (nb_pairs > 0)
+        std::cout << "Ranking agreement between reduced and full sizes : " << (double)nb_agreements / nb_pairs << std::endl;
+}
+
+std::vector<isl_set*> evaluate_by_execution::shrink_iteration_domains(syntax_tree const& ast)
+{
+    std::vector<isl_set*> domains;
+    
+    for (tiramisu::computation *comp : ast.computations_list)
+    {
+        isl_set *domain = comp->get_iteration_domain();
+        isl_set *reduced_domain = isl_set_copy(domain);
+        domains.push_back(domain);
+        
+        // The loop levels enclosing the computation, from the outermost to the innermost
+        std::vector<ast_node*> nodes;
+        auto mapping_it = ast.computations_mapping.find(comp);
+        
+        if (mapping_it != ast.computations_mapping.end())
+            for (ast_node *node = mapping_it->second; node != nullptr; node = node->parent)
+                nodes.insert(nodes.begin(), node);
+        
+        std::vector<dnn_iterator> iters = dnn_iterator::get_iterators_from_computation(*comp, ast.params);
+        
+        for (int i = 0; i < iters.size(); ++i)
+        {
+            int extent = iters[i].up_bound - iters[i].low_bound + 1;
+            if (extent < min_reduced_extent)
+                continue;
+                
+            // Loop levels split by tiling, unrolling or vectorization are named after the
+            // original one. The outermost of them iterates over blocks of block_size iterations.
+            int block_size = 1;
+            
+            for (ast_node *node : nodes)
+            {
+                std::string const& name = node->name;
+                if (name == iters[i].name)
+                    break;
+                    
+                if (name.compare(0, iters[i].name.size() + 6, iters[i].name + "_outer") == 0 ||
+                    name.compare(0, iters[i].name.size() + 6, iters[i].name + "_inner") == 0)
+                {
+                    block_size = std::max(extent / std::max(node->get_extent(), 1), 1);
+                    break;
+                }
+            }
+            
+            int reduced_extent = std::max((int)std::ceil(extent * reduced_size_ratio), min_reduced_extent);
+            reduced_extent = std::max(reduced_extent, 2 * block_size);
+            reduced_extent = (reduced_extent + block_size - 1) / block_size * block_size;
+            
+            if (reduced_extent >= extent)
+                continue;
+                
+            reduced_domain = isl_set_upper_bound_si(reduced_domain, isl_dim_set, i, iters[i].low_bound + reduced_extent - 1);
+        }
+        
+        comp->set_iteration_domain(reduced_domain);
+    }
+    
+    // Schedules are built from the iteration domains
+    fct->reset_schedules();
+    
+    return domains;
+}
+
+void evaluate_by_execution::restore_iteration_domains(syntax_tree const& ast, std::vector<isl_set*> const& domains)
+{
+    for (int i = 0; i < domains.size(); ++i)
+    {
+        isl_set_free(ast.computations_list[i]->get_iteration_domain());
+        ast.computations_list[i]->set_iteration_domain(domains[i]);
+    }
+}
+
+std::vector<float> evaluate_by_execution::compile_and_run_batch(std::vector<syntax_tree*> const& asts)
+{
+    bool has_compute_at = false;
+    for (syntax_tree *ast : asts)
+        if (ast_has_optimization(*ast, optimization_type::COMPUTE_AT))
+            has_compute_at = true;
+            
+    if (nb_workers <= 1 && compile_timeout <= 0 && !has_compute_at)
+        return evaluation_function::evaluate_batch(asts);
+        
+    std::vector<float> evals(asts.size(), FLT_MAX);
+    std::vector<bool> compiled(asts.size(), false);
+    
+    // Schedules that timed out before are not compiled again
+    std::vector<int> asts_to_compile;
+    for (int i = 0; i < asts.size(); ++i)
+        if (use_reduced_sizes || !get_timed_out_evaluation(*asts[i], evals[i]))
+            asts_to_compile.push_back(i);
+    
+    // Map each running compilation process to the index of its schedule
+    std::map<pid_t, int> running;
+    std::map<pid_t, std::chrono::steady_clock::time_point> start_times;
+    int next_index = 0;
+    
+    while (next_index < asts_to_compile.size() || !running.empty())
+    {
+        // Launch new compilations while there are free workers.
+        // fork() gives each compilation its own copy of the function,
+        // so the schedules applied by a worker don't affect the others.
+        while (next_index < asts_to_compile.size() && running.size() < std::max(nb_workers, 1))
+        {
+            int next_ast = asts_to_compile[next_index];
+            std::string cand_obj_filename = obj_filename + "_" + std::to_string(next_ast);
+            pid_t pid = fork();
+            
+            if (pid == 0)
+            {
+                // The compiler launched by the worker must be killed with it
+                setpgid(0, 0);
+                
+                evaluation_phases sched_phases;
+                bool success = compile_schedule(*asts[next_ast], cand_obj_filename, sched_phases);
+                
+                // Give the time of the compilation phases to the parent process
+                FILE *phases_file = fopen((cand_obj_filename + ".phases").c_str(), "wb");
+                if (phases_file != nullptr)
+                {
+                    fwrite(&sched_phases, sizeof(sched_phases), 1, phases_file);
+                    fclose(phases_file);
+                }
+                
+                _exit(success ? 0 : 1);
+            }
+            
+            // fork() failed, compile in this process.
+            // compute_at can't be applied here, as it would modify the function.
+            if (pid < 0 && ast_has_optimization(*asts[next_ast], optimization_type::COMPUTE_AT))
+                compiled[next_ast] = false;
+                
+            else if (pid < 0)
+            {
+                evaluation_phases sched_phases;
+                
+                auto begin = std::chrono::steady_clock::now();
+                compiled[next_ast] = compile_schedule(*asts[next_ast], cand_obj_filename, sched_phases);
+                fct->reset_schedules();
+                
+                compile_time += get_time_since(begin);
+                nb_compilations++;
+                
+                phases[asts[next_ast]->get_fingerprint()] += sched_phases;
+            }
+            
+            else
+            {
+                running[pid] = next_ast;
+                start_times[pid] = std::chrono::steady_clock::now();
+            }
+                
+            next_index++;
+        }
+        
+        // Wait for a worker to finish
+        bool worker_done = false;
+        for (auto it = running.begin(); it != running.end(); )
+        {
+            int status = 0;
+            if (waitpid(it->first, &status, WNOHANG) == 0)
+            {
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_times[it->first]).count();
+                
+                if (compile_timeout <= 0 || elapsed < compile_timeout)
+                {
+                    ++it;
+                    continue;
+                }
+                
+                // The compilation takes too long : kill it, and never compile this schedule again
+                kill(-it->first, SIGKILL);
+                waitpid(it->first, &status, 0);
+                status = -1;
+                
+                timing_stats timeout_timing;
+                timeout_timing.timed_out = true;
+                timings[asts[it->second]->get_fingerprint()] = timeout_timing;
+                
+                nb_compile_timeouts++;
+            }
+            
+            compiled[it->second] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            
+            compile_time += get_time_since(start_times[it->first]);
+            nb_compilations++;
+            
+            // A killed worker didn't write its phases, count its time as scheduling time
+            std::string phases_filename = obj_filename + "_" + std::to_string(it->second) + ".phases";
+            FILE *phases_file = fopen(phases_filename.c_str(), "rb");
+            evaluation_phases sched_phases;
+            
+            if (phases_file == nullptr || fread(&sched_phases, sizeof(sched_phases), 1, phases_file) != 1)
+            {
+                sched_phases = evaluation_phases();
+                sched_phases.scheduling = get_time_since(start_times[it->first]);
+            }
+            
+            if (phases_file != nullptr)
+                fclose(phases_file);
+                
+            std::remove(phases_filename.c_str());
+            phases[asts[it->second]->get_fingerprint()] += sched_phases;
+            
+            it = running.erase(it);
+            worker_done = true;
+        }
+        
+        if (!worker_done && !running.empty())
+            usleep(1000);
+    }
+    
+    // Execute the compiled schedules one at a time
+    for (int i = 0; i < asts.size(); ++i)
+    {
+        std::string cand_obj_filename = obj_filename + "_" + std::to_string(i);
+        
+        if (compiled[i])
+        {
+            auto exec_begin = std::chrono::steady_clock::now();
+            evals[i] = run_schedule(cand_obj_filename);
+            phases[asts[i]->get_fingerprint()].execution += get_time_since(exec_begin);
+            
+            if (!use_reduced_sizes)
+                timings[asts[i]->get_fingerprint()] = last_timing;
+        }
+            
+        std::remove(cand_obj_filename.c_str());
+        std::remove((cand_obj_filename + ".so").c_str());
+    }
+    
+    return evals;
+}
+
+bool evaluate_by_execution::compile_schedule(syntax_tree& ast, std::string const& obj_name, evaluation_phases& sched_phases)
+{
+    auto phase_start = std::chrono::steady_clock::now();
+    
+    std::vector<isl_set*> full_domains;
+    if (use_reduced_sizes)
+        full_domains = shrink_iteration_domains(ast);
+        
     // Apply all the optimizations
     apply_optimizations(ast);
-    parallelize_outermost_levels(ast.computations_list);
+    apply_compute_at(ast);
+    
+    // If the search didn't choose a loop level to parallelize, parallelize the outermost one
+    if (!ast_has_optimization(ast, optimization_type::PARALLELIZE))
+        parallelize_outermost_levels(ast.computations_list);
+    
+    // Compile the program to an object file.
+    // Schedules often differ by a few loop nests, only regenerate those. The previous
+    // setting is restored after, so that the code generation of the user is not affected.
+    bool incremental_codegen = fct->is_incremental_codegen_set();
+    fct->set_incremental_codegen(true);
     
-    // Compile the program to an object file
     fct->lift_dist_comps();
     fct->gen_time_space_domain();
     fct->gen_isl_ast();
     fct->gen_halide_stmt();
     
+    fct->set_incremental_codegen(incremental_codegen);
+    
+    sched_phases.scheduling = get_time_since(phase_start);
+    phase_start = std::chrono::steady_clock::now();
+    
+    // The runner calls the program through its "_argv" entry point,
+    // which Halide only generates along with the metadata.
+    Halide::Internal::LoweredFunc::LinkageType linkage = Halide::Internal::LoweredFunc::External;
+    if (runner != nullptr)
+        linkage = Halide::Internal::LoweredFunc::ExternalPlusMetadata;
+    
     Halide::Module m = lower_halide_pipeline(fct->get_name(), halide_target, halide_arguments,
-                                             Halide::Internal::LoweredFunc::External,
-                                             fct->get_halide_stmt());
+                                             linkage, fct->get_halide_stmt());
                                              
-    m.compile(Halide::Outputs().object(obj_filename));
+    sched_phases.halide_lowering = get_time_since(phase_start);
+    phase_start = std::chrono::steady_clock::now();
+    
+    // Schedules already compiled (e.g. by a previous search) are found in the object cache
+    object_cache::compile(m, obj_name);
+    
+    sched_phases.llvm_compile = get_time_since(phase_start);
+    phase_start = std::chrono::steady_clock::now();
     
     // Turn the object file to a shared library
-    std::string gcc_cmd = "g++ -shared -o " + obj_filename + ".so " + obj_filename;
+    std::string gcc_cmd = "g++ -shared -o " + obj_name + ".so " + obj_name;
     int status = system(gcc_cmd.c_str());
     
-    // Execute the wrapper and get execution time
-    double exec_time = 0.f;
-    FILE *pipe = popen(wrapper_cmd.c_str(), "r");
+    sched_phases.link = get_time_since(phase_start);
     
-    fscanf(pipe, "%lf", &exec_time);
-    pclose(pipe);
+    if (use_reduced_sizes)
+        restore_iteration_domains(ast, full_domains);
     
-    // Remove all the optimizations
-    fct->reset_schedules();
+    return status == 0;
+}
+
+float evaluate_by_execution::run_schedule(std::string const& obj_name)
+{
+    auto begin = std::chrono::steady_clock::now();
+    float sched_exec_time = FLT_MAX;
+    last_timing = timing_stats();
     
-    return exec_time;
+    // The time limit of an execution, in milliseconds
+    float& best_time = use_reduced_sizes ? best_reduced_exec_time : best_exec_time;
+    double time_limit = 0;
+    
+    if (timeout_factor > 0 && best_time != FLT_MAX)
+        time_limit = timeout_factor * best_time;
+    
+    if (runner != nullptr)
+        sched_exec_time = runner->run(obj_name + ".so", last_timing, time_limit);
+        
+    // The wrapper loads obj_filename.so, so move the schedule there
+    else if (obj_name == obj_filename || rename((obj_name + ".so").c_str(), (obj_filename + ".so").c_str()) == 0)
+    {
+        // Execute the wrapper and get execution time.
+        // The wrapper executes the program several times.
+        double wrapper_time;
+        double timeout = 0;
+        
+        if (time_limit > 0)
+            timeout = time_limit * (DEFAULT_NB_WARMUP + DEFAULT_NB_EXEC) / 1000 + TIMEOUT_SLACK;
+        
+        if (run_command(wrapper_cmd, timeout, wrapper_time))
+        {
+            sched_exec_time = wrapper_time;
+            
+            last_timing.mean = last_timing.median = sched_exec_time;
+            last_timing.ci_low = last_timing.ci_high = sched_exec_time;
+            last_timing.nb_runs = 1;
+        }
+        
+        else
+        {
+            sched_exec_time = time_limit;
+            last_timing.timed_out = true;
+            last_timing.mean = last_timing.median = time_limit;
+        }
+    }
+    
+    if (last_timing.timed_out)
+        nb_exec_timeouts++;
+        
+    else if (sched_exec_time < best_time)
+        best_time = sched_exec_time;
+    
+    exec_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    nb_executions++;
+    
+    return sched_exec_time;
+}
+
+/**
+ * Evaluate the given buffer size, using the values of the parameters fixed by context.
+ * Return false if the size is not an integer expression of fixed parameters.
+ */
+static bool get_size_value(tiramisu::expr const& size, isl_set *context, int64_t& value)
+{
+    switch (size.get_expr_type())
+    {
+        case e_val:
+            if (size.get_data_type() == p_float32 || size.get_data_type() == p_float64)
+                return false;
+                
+            value = size.get_int_val();
+            return true;
+            
+        case e_var:
+        {
+            if (context == nullptr)
+                return false;
+                
+            int param_pos = isl_set_find_dim_by_name(context, isl_dim_param, size.get_name().c_str());
+            if (param_pos < 0)
+                return false;
+                
+            isl_val *param_value = isl_set_plain_get_val_if_fixed(context, isl_dim_param, param_pos);
+            bool is_fixed = isl_val_is_int(param_value);
+            
+            if (is_fixed)
+                value = isl_val_get_num_si(param_value);
+                
+            isl_val_free(param_value);
+            return is_fixed;
+        }
+            
+        case e_op:
+        {
+            if (size.get_op_type() == o_cast)
+                return get_size_value(size.get_operand(0), context, value);
+                
+            int64_t lhs, rhs;
+            if (size.get_n_arg() != 2 || 
+                !get_size_value(size.get_operand(0), context, lhs) || 
+                !get_size_value(size.get_operand(1), context, rhs))
+                return false;
+                
+            switch (size.get_op_type())
+            {
+                case o_add: value = lhs + rhs; return true;
+                case o_sub: value = lhs - rhs; return true;
+                case o_mul: value = lhs * rhs; return true;
+                case o_max: value = std::max(lhs, rhs); return true;
+                case o_min: value = std::min(lhs, rhs); return true;
+                case o_div:
+                    if (rhs == 0)
+                        return false;
+                        
+                    value = lhs / rhs;
+                    return true;
+                    
+                default:
+                    return false;
+            }
+        }
+            
+        default:
+            return false;
+    }
+}
+
+std::vector<std::vector<int>> evaluate_by_execution::get_argument_sizes() const
+{
+    std::vector<std::vector<int>> sizes;
+    isl_set *context = fct->get_program_context();
+    
+    for (tiramisu::buffer *buf : fct->get_arguments())
+    {
+        std::vector<int> buf_sizes;
+        
+        for (tiramisu::expr const& dim_size : buf->get_dim_sizes())
+        {
+            int64_t value = 0;
+            if (!get_size_value(dim_size, context, value))
+                ERROR("The benchmark runner can't allocate the buffer " + buf->get_name() + 
+                      " : the size " + dim_size.to_str() + " has no fixed value. " +
+                      "Fix its parameters in the context of the function, or don't use the benchmark runner.", true);
+                      
+            buf_sizes.push_back(value);
+        }
+        
+        sizes.push_back(buf_sizes);
+    }
+    
+    isl_set_free(context);
+    return sizes;
+}
+
+void evaluate_by_execution::use_benchmark_runner(int nb_exec, int nb_warmup)
+{
+    delete runner;
+    runner = new benchmark_runner(fct->get_name(), fct->get_arguments(), get_argument_sizes(), nb_exec, nb_warmup);
+}
+
+bool evaluate_by_execution::get_timing_stats(syntax_tree const& ast, timing_stats& stats) const
+{
+    auto it = timings.find(ast.get_fingerprint());
+    if (it == timings.end())
+        return false;
+        
+    stats = it->second;
+    return true;
+}
+
+float evaluate_by_execution::get_confidence_interval(syntax_tree const& ast) const
+{
+    timing_stats stats;
+    if (!get_timing_stats(ast, stats))
+        return 0;
+        
+    return stats.get_ci_half_width();
+}
+
+bool evaluate_by_execution::take_evaluation_phases(syntax_tree const& ast, evaluation_phases& sched_phases)
+{
+    auto it = phases.find(ast.get_fingerprint());
+    if (it == phases.end())
+        return false;
+        
+    sched_phases = it->second;
+    phases.erase(it);
+    
+    return true;
 }
 
 evaluate_by_learning_model::evaluate_by_learning_model(std::string const& cmd_path, std::vector<std::string> const& cmd_args)
-    : evaluation_function()
+    : evaluation_function(), cmd_path(cmd_path), cmd_args(cmd_args)
+{
+    start_model();
+}
+
+void evaluate_by_learning_model::start_model()
 {
     // Create the pipe
     pid_t pid = 0;
@@ -113,30 +841,122 @@ evaluate_by_learning_model::evaluate_by_learning_model(std::string const& cmd_pa
     
     model_write = fdopen(outpipe_fd[1], "w");
     model_read = fdopen(inpipe_fd[0], "r");
+    model_pid = pid;
 }
 
-float evaluate_by_learning_model::evaluate(syntax_tree& ast)
+void evaluate_by_learning_model::stop_model()
+{
+    if (model_pid <= 0)
+        return ;
+        
+    fclose(model_write);
+    fclose(model_read);
+    
+    kill(model_pid, SIGKILL);
+    waitpid(model_pid, nullptr, 0);
+    
+    model_pid = -1;
+    model_write = nullptr;
+    model_read = nullptr;
+    
+    // The new model process doesn't have the program
+    sent_program_json.clear();
+}
+
+/**
+ * Append a 32-bit unsigned integer to a binary message.
+ */
+static void append_uint32(std::string& msg, uint32_t val)
+{
+    msg.append((char const*)&val, sizeof(val));
+}
+
+void evaluate_by_learning_model::send_program(syntax_tree const& ast)
 {
-    // Get JSON representations for the program, and for the schedule
     std::string prog_json = get_program_json(ast);
-    std::string sched_json = get_schedule_json(ast);
+    if (prog_json == sent_program_json)
+        return ;
+        
+    std::string msg;
+    
+    msg.reserve(1 + sizeof(uint32_t) + prog_json.size());
+    msg.push_back('P');
+    append_uint32(msg, prog_json.size());
+    msg += prog_json;
     
-    // Write the program JSON and the schedule JSON to model_write
-    fputs(prog_json.c_str(), model_write);
-    fputs(sched_json.c_str(), model_write);
+    fwrite(msg.data(), 1, msg.size(), model_write);
+    
+    sent_program_json = prog_json;
+}
+
+float evaluate_by_learning_model::evaluate(syntax_tree& ast)
+{
+    std::vector<syntax_tree*> asts = {&ast};
+    return evaluate_batch(asts)[0];
+}
+
+std::vector<float> evaluate_by_learning_model::evaluate_batch(std::vector<syntax_tree*> const& asts)
+{
+    std::vector<float> evals(asts.size(), 0.f);
+    if (asts.empty())
+        return evals;
+        
+    // The program is the same for all the ASTs, send it only if the model doesn't have it
+    send_program(*asts[0]);
+    
+    // Put all the schedules in one message
+    std::vector<std::string> scheds_json;
+    size_t msg_size = 1 + sizeof(uint32_t);
+    
+    for (syntax_tree *ast : asts)
+    {
+        scheds_json.push_back(get_schedule_json(*ast));
+        msg_size += sizeof(uint32_t) + scheds_json.back().size();
+    }
+    
+    std::string msg;
+    msg.reserve(msg_size);
+    
+    msg.push_back('B');
+    append_uint32(msg, asts.size());
+    
+    for (std::string const& sched_json : scheds_json)
+    {
+        append_uint32(msg, sched_json.size());
+        msg += sched_json;
+    }
+    
+    fwrite(msg.data(), 1, msg.size(), model_write);
     fflush(model_write);
     
-    // Read the evaluation from model_read.
-    float speedup = 0.f;
-    fscanf(model_read, "%f", &speedup);
+    // Read the evaluations from model_read.
+    // If the model didn't answer, all the schedules get a speedup of 0.
+    uint32_t nb_evals = 0;
+    std::vector<float> speedups(asts.size(), 0.f);
+    
+    bool answered = fread(&nb_evals, sizeof(nb_evals), 1, model_read) == 1 && nb_evals == asts.size() &&
+                    fread(speedups.data(), sizeof(float), nb_evals, model_read) == nb_evals;
     
-    return -speedup;
+    // The rest of the answer can't be trusted, and would be read as the answer to the next batch.
+    // Restart the model so that the next batch starts from a clean stream.
+    if (!answered)
+    {
+        std::fill(speedups.begin(), speedups.end(), 0.f);
+        
+        stop_model();
+        start_model();
+    }
+        
+    for (int i = 0; i < asts.size(); ++i)
+        evals[i] = -speedups[i];
+    
+    return evals;
 }
 
 std::string evaluate_by_learning_model::get_program_json(syntax_tree const& ast)
 {
     // Get JSON for iterators from ast.iterators_json
-    std::string iterators_json = "\"iterators\" : {" + ast.iterators_json + "}";
+    std::string iterators_json = "\"iterators\" : {" + *ast.iterators_json + "}";
     
     // Use represent_computations_from_nodes to get JSON for computations
     std::string computations_json = "\"computations\" : {";
@@ -155,17 +975,17 @@ std::string evaluate_by_learning_model::get_program_json(syntax_tree const& ast)
 void evaluate_by_learning_model::represent_computations_from_nodes(ast_node *node, std::string& computations_json, int& comp_absolute_order)
 {
     // Build the JSON for the computations stored in "node".
-    for (computation_info const& comp_info : node->computations)
+    for (auto const& comp_info : node->computations)
     {
         std::string comp_json = "\"absolute_order\" : " + std::to_string(comp_absolute_order) + ","; 
         comp_absolute_order++;
         
         comp_json += "\"iterators\" : [";
         
-        for (int i = 0; i < comp_info.iters.size(); ++i)
+        for (int i = 0; i < comp_info->iters.size(); ++i)
         {
-            comp_json += "\"" + comp_info.iters[i].name + "\"";
-            if (i != comp_info.iters.size() - 1)
+            comp_json += "\"" + comp_info->iters[i].name + "\"";
+            if (i != comp_info->iters.size() - 1)
                 comp_json += ",";
         }
         
@@ -173,37 +993,37 @@ void evaluate_by_learning_model::represent_computations_from_nodes(ast_node *nod
         
         comp_json += "\"real_dimensions\" : [";
         
-        for (int i = 0; i < comp_info.buffer_nb_dims; ++i)
+        for (int i = 0; i < comp_info->buffer_nb_dims; ++i)
         {
-            comp_json += "\"" + comp_info.iters[i].name + "\"";
-            if (i != comp_info.buffer_nb_dims - 1)
+            comp_json += "\"" + comp_info->iters[i].name + "\"";
+            if (i != comp_info->buffer_nb_dims - 1)
                 comp_json += ",";
         }
         
         comp_json += "],";
         
         comp_json += "\"comp_is_reduction\" : ";
-        if (comp_info.is_reduction)
+        if (comp_info->is_reduction)
             comp_json += "true,";
         else
             comp_json += "false,";
             
-        comp_json += "\"number_of_additions\" : " + std::to_string(comp_info.nb_additions) + ",";
-        comp_json += "\"number_of_subtraction\" : " + std::to_string(comp_info.nb_substractions) + ",";
-        comp_json += "\"number_of_multiplication\" : " + std::to_string(comp_info.nb_multiplications) + ",";
-        comp_json += "\"number_of_division\" : " + std::to_string(comp_info.nb_divisions) + ",";
+        comp_json += "\"number_of_additions\" : " + std::to_string(comp_info->nb_additions) + ",";
+        comp_json += "\"number_of_subtraction\" : " + std::to_string(comp_info->nb_substractions) + ",";
+        comp_json += "\"number_of_multiplication\" : " + std::to_string(comp_info->nb_multiplications) + ",";
+        comp_json += "\"number_of_division\" : " + std::to_string(comp_info->nb_divisions) + ",";
         
         // Build JSON for the accesses of this computation
         comp_json += "\"accesses\" : [";
 
-        for (int i = 0; i < comp_info.accesses.accesses_list.size(); ++i)
+        for (int i = 0; i < comp_info->accesses.accesses_list.size(); ++i)
         {
-            dnn_access_matrix const& matrix  = comp_info.accesses.accesses_list[i];
+            dnn_access_matrix const& matrix  = comp_info->accesses.accesses_list[i];
             
             comp_json += "{";
             
             comp_json += "\"access_is_reduction\" : ";
-            if (i == 0 && comp_info.is_reduction)
+            if (i == 0 && comp_info->is_reduction)
                 comp_json += "true,";
             else
                 comp_json += "false,";
@@ -230,13 +1050,13 @@ void evaluate_by_learning_model::represent_computations_from_nodes(ast_node *nod
             
             comp_json += "}";
             
-            if (i != comp_info.accesses.accesses_list.size() - 1)
+            if (i != comp_info->accesses.accesses_list.size() - 1)
                 comp_json += ",";
         }
         
         comp_json += "]";
     
-        computations_json += "\"" + comp_info.comp_ptr->get_name() + "\" : {" + comp_json + "},";
+        computations_json += "\"" + comp_info->comp_ptr->get_name() + "\" : {" + comp_json + "},";
     }
     
     // Recursively get JSON for the rest of computations
@@ -309,7 +1129,7 @@ std::string evaluate_by_learning_model::get_schedule_json(syntax_tree const& ast
     for (tiramisu::computation *comp : ast.computations_list)
     {
         std::string comp_sched_json;
-        iterators_list = dnn_iterator::get_iterators_from_computation(*comp);
+        iterators_list = dnn_iterator::get_iterators_from_computation(*comp, ast.params);
         
         // JSON for interchange
         comp_sched_json += "\"interchange_dims\" : [";
@@ -378,6 +1198,41 @@ std::string evaluate_by_learning_model::get_schedule_json(syntax_tree const& ast
             comp_sched_json += "null";
         }
         
+        // JSON for parallelization and vectorization : the names of the tagged loop levels
+        // that enclose the computation.
+        ast_node *parallelized_node = nullptr, *vectorized_node = nullptr;
+        
+        auto comp_node_it = ast.computations_mapping.find(comp);
+        if (comp_node_it != ast.computations_mapping.end())
+        {
+            for (ast_node *node = comp_node_it->second; node != nullptr; node = node->parent)
+            {
+                if (node->parallelized && parallelized_node == nullptr)
+                    parallelized_node = node;
+                    
+                if (node->vectorized && vectorized_node == nullptr)
+                    vectorized_node = node;
+            }
+        }
+        
+        comp_sched_json += ",\"parallelized_dim\" : ";
+        if (parallelized_node != nullptr)
+            comp_sched_json += "\"" + parallelized_node->name + "\"";
+        else
+            comp_sched_json += "null";
+            
+        comp_sched_json += ",\"vectorized_dim\" : ";
+        if (vectorized_node != nullptr)
+            comp_sched_json += "\"" + vectorized_node->name + "\"";
+        else
+            comp_sched_json += "null";
+            
+        comp_sched_json += ",\"vectorization_factor\" : ";
+        if (vectorized_node != nullptr)
+            comp_sched_json += "\"" + std::to_string(vectorized_node->get_extent()) + "\"";
+        else
+            comp_sched_json += "null";
+        
         sched_json += "\"" + comp->get_name() + "\" : {" + comp_sched_json + "},";
     }
     
@@ -439,7 +1294,7 @@ void evaluate_by_learning_model::represent_iterators_from_nodes(ast_node *node,
     
     for (int i = 0; i < node->computations.size(); ++i)
     {
-        iter_json += "\"" + node->computations[i].comp_ptr->get_name() + "\",";
+        iter_json += "\"" + node->computations[i]->comp_ptr->get_name() + "\",";
         has_computations = true;
     }
     
@@ -451,7 +1306,7 @@ void evaluate_by_learning_model::represent_iterators_from_nodes(ast_node *node,
         ast_node *dummy_child = node->children[i];
         for (int j = 0; j < dummy_child->computations.size(); ++j)
         {
-            iter_json += "\"" + dummy_child->computations[j].comp_ptr->get_name() + "\",";
+            iter_json += "\"" + dummy_child->computations[j]->comp_ptr->get_name() + "\",";
             has_computations = true;
         }
     }
@@ -485,8 +1340,8 @@ std::string evaluate_by_learning_model::get_tree_structure_json(ast_node *node)
     json += "\"computations_list\" : [";
     
     std::vector<std::string> comps_list;
-    for (computation_info const& comp_info : node->computations)
-        comps_list.push_back(comp_info.comp_ptr->get_name());
+    for (auto const& comp_info : node->computations)
+        comps_list.push_back(comp_info->comp_ptr->get_name());
         
     for (ast_node *child : node->children)
     {
@@ -494,7 +1349,7 @@ std::string evaluate_by_learning_model::get_tree_structure_json(ast_node *node)
             continue;
             
         for (int j = 0; j < child->computations.size(); ++j)
-            comps_list.push_back(child->computations[j].comp_ptr->get_name());
+            comps_list.push_back(child->computations[j]->comp_ptr->get_name());
     }
     
     for (std::string comp_name : comps_list)
@@ -526,4 +1381,97 @@ std::string evaluate_by_learning_model::get_tree_structure_json(ast_node *node)
     return json;
 }
 
+// ---------------------------------------------------------------------------- //
+
+evaluate_over_sizes::evaluate_over_sizes(evaluation_function *eval_func, tiramisu::function *fct, 
+                                         std::vector<parameters_values> const& sizes, std::vector<double> const& weights)
+    : eval_func(eval_func), weights(weights)
+{
+    if (this->weights.size() != sizes.size())
+        this->weights = std::vector<double>(sizes.size(), 1.0);
+        
+    for (parameters_values const& params : sizes)
+        sized_asts.push_back(new syntax_tree(fct, params));
+        
+    initial_evaluations = eval_func->evaluate_batch(sized_asts);
+}
+
+evaluate_over_sizes::~evaluate_over_sizes()
+{
+    for (syntax_tree *ast : sized_asts)
+        delete ast;
+}
+
+float evaluate_over_sizes::evaluate(syntax_tree& ast)
+{
+    std::vector<syntax_tree*> asts = {&ast};
+    return evaluate_batch(asts)[0];
+}
+
+std::vector<float> evaluate_over_sizes::evaluate_batch(std::vector<syntax_tree*> const& asts)
+{
+    std::vector<float> evals(asts.size(), 0.f);
+    
+    double total_weight = 0;
+    for (double weight : weights)
+        total_weight += weight;
+        
+    if (total_weight <= 0)
+        return evals;
+        
+    for (int i = 0; i < sized_asts.size(); ++i)
+    {
+        // Apply each schedule to the AST of this size
+        std::vector<syntax_tree*> replayed_asts;
+        
+        for (syntax_tree *ast : asts)
+        {
+            std::vector<optimization_info> optims = ast->previous_optims;
+            optims.insert(optims.end(), ast->new_optims.begin(), ast->new_optims.end());
+            
+            syntax_tree *replayed_ast = sized_asts[i]->copy_ast();
+            replayed_ast->replay_optimizations(optims);
+            
+            replayed_asts.push_back(replayed_ast);
+        }
+        
+        std::vector<float> size_evals = eval_func->evaluate_batch(replayed_asts);
+        
+        float norm = std::abs(initial_evaluations[i]);
+        if (norm == 0)
+            norm = 1;
+            
+        for (int j = 0; j < asts.size(); ++j)
+        {
+            evals[j] += weights[i] / total_weight * size_evals[j] / norm;
+            delete replayed_asts[j];
+        }
+    }
+    
+    return evals;
+}
+
+std::vector<float> evaluate_over_sizes::evaluate_per_size(syntax_tree const& ast)
+{
+    std::vector<optimization_info> optims = ast.previous_optims;
+    optims.insert(optims.end(), ast.new_optims.begin(), ast.new_optims.end());
+    
+    std::vector<float> evals;
+    
+    for (int i = 0; i < sized_asts.size(); ++i)
+    {
+        syntax_tree *replayed_ast = sized_asts[i]->copy_ast();
+        replayed_ast->replay_optimizations(optims);
+        
+        float norm = std::abs(initial_evaluations[i]);
+        if (norm == 0)
+            norm = 1;
+            
+        evals.push_back(eval_func->evaluate(*replayed_ast) / norm);
+        delete replayed_ast;
+    }
+    
+    return evals;
+}
+
 }
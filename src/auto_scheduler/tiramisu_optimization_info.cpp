@@ -2,9 +2,58 @@
 #include <tiramisu/auto_scheduler/ast.h>
 #include <tiramisu/block.h>
 
+#include <unordered_set>
+#include <algorithm>
+#include <cstdlib>
+
 namespace tiramisu::auto_scheduler
 {
 
+std::string get_optimization_str(optimization_info const& optim_info)
+{
+    std::string comps_str;
+    for (tiramisu::computation *comp : optim_info.comps)
+        comps_str += comp->get_name() + ",";
+        
+    // Only print the attributes used by each type of optimization,
+    // the others are left uninitialized by the schedules generators.
+    switch (optim_info.type)
+    {
+        case optimization_type::UNFUSE:
+            return "U(" + std::to_string(optim_info.l0) + ")";
+            
+        case optimization_type::FUSION:
+            return "F(" + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l1) + ")";
+            
+        case optimization_type::TILING:
+            if (optim_info.nb_l == 2)
+                return "T(" + comps_str + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l1) + "," +
+                       std::to_string(optim_info.l0_fact) + "," + std::to_string(optim_info.l1_fact) + ")";
+                       
+            return "T(" + comps_str + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l1) + "," +
+                   std::to_string(optim_info.l2) + "," + std::to_string(optim_info.l0_fact) + "," +
+                   std::to_string(optim_info.l1_fact) + "," + std::to_string(optim_info.l2_fact) + ")";
+                   
+        case optimization_type::INTERCHANGE:
+            return "I(" + comps_str + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l1) + ")";
+            
+        case optimization_type::UNROLLING:
+            return "R(" + comps_str + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l0_fact) + ")";
+            
+        case optimization_type::PARALLELIZE:
+            return "P(" + comps_str + std::to_string(optim_info.l0) + ")";
+            
+        case optimization_type::VECTORIZE:
+            return "V(" + comps_str + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l0_fact) + ")";
+            
+        case optimization_type::COMPUTE_AT:
+            return "C(" + comps_str + std::to_string(optim_info.l0) + "," + std::to_string(optim_info.l1) + ")";
+            
+        default:
+            return "";
+    }
+}
+
 void parallelize_outermost_levels(std::vector<tiramisu::computation*> const& comps_list)
 {
     for (tiramisu::computation *comp : comps_list)
@@ -24,6 +73,32 @@ void unroll_innermost_levels(std::vector<tiramisu::computation*> const& comps_li
         comps_list[i]->unroll(innermost_indices[i], unroll_fact);
 }
 
+void vectorize_innermost_levels(std::vector<tiramisu::computation*> const& comps_list, int vector_len)
+{
+    std::vector<int> innermost_indices; 
+    
+    // For each computation, get the indice of its innermost loop level.
+    for (tiramisu::computation *comp : comps_list)
+        innermost_indices.push_back(comp->get_loop_levels_number() - 1);
+                
+    // Apply vectorization to innermost loop levels.
+    for (int i = 0; i < innermost_indices.size(); ++i)
+        comps_list[i]->vectorize(innermost_indices[i], vector_len);
+}
+
+bool ast_has_optimization(syntax_tree const& ast, optimization_type optim)
+{
+    for (optimization_info const& optim_info : ast.previous_optims)
+        if (optim_info.type == optim)
+            return true;
+            
+    for (optimization_info const& optim_info : ast.new_optims)
+        if (optim_info.type == optim)
+            return true;
+            
+    return false;
+}
+
 void apply_optimizations(syntax_tree const& ast)
 {
     // Check ast.h for the difference between ast.previous_optims and ast.new_optims
@@ -68,6 +143,26 @@ void apply_optimizations(optimization_info const& optim_info)
             else
                 unroll_innermost_levels(optim_info.comps, optim_info.l0_fact);
             break;
+            
+        case optimization_type::PARALLELIZE:
+            for (tiramisu::computation *comp : optim_info.comps)
+                comp->tag_parallel_level(optim_info.l0);
+            break;
+            
+        case optimization_type::VECTORIZE:
+            // Apply vectorization on the level indicated by l0
+            if (optim_info.l0 != -1)
+                block.vectorize(optim_info.l0, optim_info.l0_fact);
+                
+            // Apply vectorization on all innermost levels
+            else
+                vectorize_innermost_levels(optim_info.comps, optim_info.l0_fact);
+            break;
+            
+        // compute_at adds computations and buffers to the function, which reset_schedules()
+        // doesn't remove. It is only applied when compiling a schedule, by evaluate_by_execution.
+        case optimization_type::COMPUTE_AT:
+            break;
                 
         default:
             break;
@@ -90,7 +185,7 @@ tiramisu::computation* apply_fusions(ast_node *node, tiramisu::computation *last
     
     if (node->computations.size() > 0)
     {
-        next_comp = node->computations[0].comp_ptr;
+        next_comp = node->computations[0]->comp_ptr;
         
         if (last_comp != nullptr)
             next_comp->after(*last_comp, dimension);
@@ -98,7 +193,7 @@ tiramisu::computation* apply_fusions(ast_node *node, tiramisu::computation *last
         last_comp = next_comp;
         for (int i = 1; i < node->computations.size(); ++i)
         {
-            next_comp = node->computations[i].comp_ptr;
+            next_comp = node->computations[i]->comp_ptr;
             next_comp->after(*last_comp, node->depth);
         }
     }
@@ -116,4 +211,208 @@ tiramisu::computation* apply_fusions(ast_node *node, tiramisu::computation *last
     return next_comp;
 }
 
+/**
+ * Return the information about the given computation in the given AST.
+ */
+static computation_info const* get_computation_info(syntax_tree const& ast, tiramisu::computation *comp)
+{
+    for (auto const& comp_info : ast.computations_mapping.at(comp)->computations)
+        if (comp_info->comp_ptr == comp)
+            return comp_info.get();
+            
+    return nullptr;
+}
+
+/**
+ * Return the size of each dimension of the buffer of the producer, when the producer is computed
+ * at the loop level "level" of the consumer. A dimension traversed by the shared loop levels only
+ * needs to hold the values read by the consumer in one iteration of these levels.
+ * Return an empty list if the buffer can't be shrunk.
+ */
+static std::vector<int> get_shrunk_buffer_sizes(computation_info const& producer_info, computation_info const& consumer_info, int level)
+{
+    std::string buf_name = producer_info.comp_ptr->get_buffer()->get_name();
+    int nb_consumer_iters = consumer_info.iters.size();
+    
+    std::vector<int> sizes;
+    bool shrunk = false;
+    
+    for (int d = 0; d < producer_info.iters.size(); ++d)
+    {
+        int extent = producer_info.iters[d].up_bound - producer_info.iters[d].low_bound + 1;
+        if (producer_info.iters[d].low_bound < 0)
+            return {};
+            
+        // Dimensions traversed by the levels below compute_at are computed entirely at each iteration
+        if (d > level || d >= nb_consumer_iters)
+        {
+            sizes.push_back(extent);
+            continue;
+        }
+        
+        // The consumer must read the dimension d with its loop level d, plus a constant offset
+        bool can_shrink = true;
+        int min_offset = 0, max_offset = 0, inner_span = 0;
+        
+        for (dnn_access_matrix const& access : consumer_info.accesses.accesses_list)
+        {
+            if (access.buffer_name != buf_name)
+                continue;
+                
+            if (d >= access.matrix.size())
+                return {};
+                
+            std::vector<int> const& row = access.matrix[d];
+            
+            for (int j = 0; j <= level; ++j)
+                if (row[j] != (j == d ? 1 : 0))
+                    can_shrink = false;
+                    
+            int span = 0;
+            for (int j = level + 1; j < nb_consumer_iters; ++j)
+                span += std::abs(row[j]) * (consumer_info.iters[j].up_bound - consumer_info.iters[j].low_bound);
+                
+            inner_span = std::max(inner_span, span);
+            min_offset = std::min(min_offset, row.back());
+            max_offset = std::max(max_offset, row.back());
+        }
+        
+        int size = 1 + inner_span + max_offset - min_offset;
+        if (can_shrink && size < extent)
+        {
+            sizes.push_back(size);
+            shrunk = true;
+        }
+        
+        else
+            sizes.push_back(extent);
+    }
+    
+    if (!shrunk)
+        return {};
+        
+    return sizes;
+}
+
+/**
+ * Return true if the loop levels 0 to "level" of the consumer, in the AST, are its original
+ * iterators in their original order. get_shrunk_buffer_sizes() is only valid in this case :
+ * if a level was tiled or interchanged, an iteration of the compute_at level doesn't fix
+ * the same dimensions of the consumer.
+ */
+static bool levels_are_original_iterators(syntax_tree const& ast, computation_info const& consumer_info, int level)
+{
+    if (level >= consumer_info.iters.size())
+        return false;
+        
+    ast_node *node = ast.computations_mapping.at(consumer_info.comp_ptr);
+    while (node != nullptr && node->depth > level)
+        node = node->parent;
+        
+    for (; node != nullptr; node = node->parent)
+        if (node->name != consumer_info.iters[node->depth].name)
+            return false;
+            
+    return true;
+}
+
+/**
+ * Return the definition executed first among the given definitions of a computation :
+ * the one after which no other definition is ordered.
+ */
+static tiramisu::computation* get_first_definition(std::vector<tiramisu::computation*> const& definitions)
+{
+    for (tiramisu::computation *def : definitions)
+    {
+        bool is_first = true;
+        
+        for (tiramisu::computation *pred = def->get_predecessor(); pred != nullptr && is_first; pred = pred->get_predecessor())
+            if (std::find(definitions.begin(), definitions.end(), pred) != definitions.end())
+                is_first = false;
+                
+        if (is_first)
+            return def;
+    }
+    
+    return definitions.front();
+}
+
+void apply_compute_at(syntax_tree const& ast)
+{
+    std::vector<optimization_info> optims = ast.previous_optims;
+    optims.insert(optims.end(), ast.new_optims.begin(), ast.new_optims.end());
+    
+    for (optimization_info const& optim_info : optims)
+    {
+        if (optim_info.type != optimization_type::COMPUTE_AT)
+            continue;
+            
+        tiramisu::computation *producer = optim_info.comps[0];
+        tiramisu::computation *consumer = optim_info.comps[1];
+        
+        // The schedule may have split the loop levels above the compute_at level,
+        // so the producer is computed at the deepest loop level it shares with the consumer in the AST.
+        std::unordered_set<ast_node*> consumer_levels;
+        for (ast_node *node = ast.computations_mapping.at(consumer); node != nullptr; node = node->parent)
+            consumer_levels.insert(node);
+            
+        ast_node *shared_node = ast.computations_mapping.at(producer);
+        while (shared_node != nullptr && consumer_levels.find(shared_node) == consumer_levels.end())
+            shared_node = shared_node->parent;
+            
+        if (shared_node == nullptr)
+            continue;
+            
+        int level = shared_node->depth;
+        
+        // Store the producer in a buffer only large enough for one iteration of the compute_at level.
+        // This must be done before compute_at(), so that the redundant computations it creates use the new buffer.
+        computation_info const *producer_info = get_computation_info(ast, producer);
+        computation_info const *consumer_info = get_computation_info(ast, consumer);
+        
+        // The sizes are computed for the level given to compute_at(), which can differ from l0
+        // if the schedule transformed the loop levels of the consumer.
+        std::vector<int> sizes;
+        if (optim_info.l1 != -1 && producer_info != nullptr && consumer_info != nullptr &&
+            levels_are_original_iterators(ast, *consumer_info, level))
+            sizes = get_shrunk_buffer_sizes(*producer_info, *consumer_info, level);
+            
+        if (!sizes.empty())
+        {
+            std::vector<tiramisu::expr> mapping, buffer_sizes;
+            
+            for (int d = 0; d < sizes.size(); ++d)
+            {
+                dnn_iterator const& it = producer_info->iters[d];
+                tiramisu::var it_var(it.name);
+                
+                if (sizes[d] < it.up_bound - it.low_bound + 1)
+                    mapping.push_back(it_var % sizes[d]);
+                else
+                    mapping.push_back(it_var);
+                    
+                buffer_sizes.push_back(tiramisu::expr(sizes[d]));
+            }
+            
+            producer->store_in(mapping, buffer_sizes);
+        }
+        
+        producer->compute_at(*consumer, level);
+        
+        // Allocate the buffer at each iteration of the compute_at level, so that the iterations
+        // of a parallel loop don't share it. The allocation is placed before the first definition
+        // of the producer to be executed (the redundant computation created by compute_at(), if any).
+        if (!sizes.empty())
+        {
+            tiramisu::computation *first_def = get_first_definition(producer->get_updates());
+            tiramisu::computation *allocation = producer->get_buffer()->allocate_at(*consumer, level);
+            
+            if (first_def->get_predecessor() != nullptr)
+                allocation->between(*first_def->get_predecessor(), level, *first_def, level);
+            else
+                allocation->before(*first_def, level);
+        }
+    }
+}
+
 }
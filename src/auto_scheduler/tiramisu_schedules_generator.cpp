@@ -1,9 +1,437 @@
 #include <tiramisu/auto_scheduler/schedules_generator.h>
 #include <tiramisu/auto_scheduler/evaluator.h>
 
+#include <cmath>
+#include <algorithm>
+
 namespace tiramisu::auto_scheduler
 {
 
+/**
+ * Add the information of the computations of the subtree rooted at node to comps_info.
+ */
+static void get_computations_info(ast_node *node, std::vector<computation_info const*>& comps_info)
+{
+    for (auto const& comp_info : node->computations)
+        comps_info.push_back(comp_info.get());
+        
+    for (ast_node *child : node->children)
+        get_computations_info(child, comps_info);
+}
+
+double tiling_factors_generator::get_tile_footprint(computation_info const& comp_info, std::vector<ast_node*> const& levels, 
+                                                    std::vector<int> const& factors, syntax_tree const& ast) const
+{
+    int nb_iters = comp_info.iters.size();
+    
+    // Number of values taken by each iterator of the computation inside a tile.
+    // Iterators are ordered from the outermost loop level to the innermost one : 
+    // the iterators below the tiled levels traverse their whole extent, the ones above take one value.
+    std::vector<int> tile_extents(nb_iters, 1);
+    int innermost_tiled = -1;
+    
+    for (int l = 0; l < levels.size(); ++l)
+    {
+        int iter_index = -1;
+        for (int j = 0; j < nb_iters; ++j)
+            if (comp_info.iters[j].name == levels[l]->name)
+                iter_index = j;
+                
+        // The loop level has been renamed by a previous optimization
+        if (iter_index == -1 && levels[l]->depth < nb_iters)
+            iter_index = levels[l]->depth;
+            
+        if (iter_index == -1)
+            continue;
+            
+        tile_extents[iter_index] = factors[l];
+        innermost_tiled = std::max(innermost_tiled, iter_index);
+    }
+    
+    for (int j = innermost_tiled + 1; j < nb_iters; ++j)
+        tile_extents[j] = comp_info.iters[j].up_bound - comp_info.iters[j].low_bound + 1;
+        
+    // Footprint in bytes of an access, from the span of each dimension of the buffer.
+    // The last dimension is contiguous in memory, and is counted in cache lines.
+    auto get_access_footprint = [&](std::vector<std::vector<int>> const& matrix, int elem_size) {
+        double footprint = 1;
+        
+        for (int r = 0; r < matrix.size(); ++r)
+        {
+            double span = 1;
+            for (int j = 0; j < nb_iters && j < matrix[r].size(); ++j)
+                span += (double)std::abs(matrix[r][j]) * (tile_extents[j] - 1);
+                
+            if (r == matrix.size() - 1)
+                footprint *= std::ceil(span * elem_size / machine.cache_line_size) * machine.cache_line_size;
+            else
+                footprint *= span;
+        }
+        
+        return footprint;
+    };
+    
+    // Accesses to the same buffer overlap (stencils), so each buffer is counted once,
+    // with the largest footprint of its accesses.
+    std::unordered_map<std::string, double> buffers_footprint;
+    
+    std::vector<std::vector<int>> store(comp_info.buffer_nb_dims, std::vector<int>(nb_iters, 0));
+    for (int i = 0; i < comp_info.buffer_nb_dims && i < nb_iters; ++i)
+        store[i][i] = 1;
+        
+    std::string store_buffer = comp_info.comp_ptr->get_buffer() != nullptr ? comp_info.comp_ptr->get_buffer()->get_name() : "";
+    buffers_footprint[store_buffer] = get_access_footprint(store, get_type_size(comp_info.comp_ptr->get_data_type()));
+    
+    auto const& buffers = ast.fct->get_buffers();
+    for (dnn_access_matrix const& access : comp_info.accesses.accesses_list)
+    {
+        primitive_t elem_type = comp_info.comp_ptr->get_data_type();
+        
+        auto it = buffers.find(access.buffer_name);
+        if (it != buffers.end())
+            elem_type = it->second->get_elements_type();
+            
+        double& footprint = buffers_footprint[access.buffer_name];
+        footprint = std::max(footprint, get_access_footprint(access.matrix, get_type_size(elem_type)));
+    }
+    
+    double footprint = 0;
+    for (auto const& buffer_footprint : buffers_footprint)
+        footprint += buffer_footprint.second;
+        
+    return footprint;
+}
+
+std::vector<std::vector<int>> tiling_factors_generator::get_tiling_factors(ast_node *node, int nb_levels, syntax_tree const& ast) const
+{
+    std::vector<ast_node*> levels = {node};
+    while (levels.size() < nb_levels && !levels.back()->children.empty())
+        levels.push_back(levels.back()->children[0]);
+        
+    if (levels.size() < nb_levels)
+        return {};
+        
+    // The factors that can tile each loop level are the divisors of its extent
+    std::vector<std::vector<int>> divisors(nb_levels);
+    for (int l = 0; l < nb_levels; ++l)
+    {
+        for (int fact = min_factor; fact <= levels[l]->get_extent() / 2; ++fact)
+            if (can_split_iterator(levels[l]->get_extent(), fact))
+                divisors[l].push_back(fact);
+                
+        if (divisors[l].empty())
+            return {};
+    }
+    
+    std::vector<computation_info const*> comps_info;
+    get_computations_info(node, comps_info);
+    
+    auto get_footprint = [&](std::vector<int> const& factors) {
+        double footprint = 0;
+        for (computation_info const* comp_info : comps_info)
+            footprint += get_tile_footprint(*comp_info, levels, factors, ast);
+            
+        return footprint;
+    };
+    
+    // The cross product of all the divisors is too large for large extents (e.g. 1024^3),
+    // so only a few candidates of each level are combined : the powers of two, and the
+    // largest factors that fit in each cache when the other levels take their smallest factor.
+    std::vector<std::vector<int>> candidates(nb_levels);
+    for (int l = 0; l < nb_levels; ++l)
+    {
+        std::vector<int> fitting_factors;
+        
+        for (int cache_size : {machine.l1_size, machine.l2_size})
+        {
+            std::vector<int> factors(nb_levels);
+            for (int l2 = 0; l2 < nb_levels; ++l2)
+                factors[l2] = divisors[l2].front();
+                
+            int fitting_factor = -1;
+            for (int fact : divisors[l])
+            {
+                factors[l] = fact;
+                if (get_footprint(factors) > cache_size)
+                    break;
+                    
+                fitting_factor = fact;
+            }
+            
+            if (fitting_factor != -1 && std::find(fitting_factors.begin(), fitting_factors.end(), fitting_factor) == fitting_factors.end())
+                fitting_factors.push_back(fitting_factor);
+        }
+        
+        // The powers of two, from the largest one that fits in the caches downwards,
+        // then the larger ones
+        int largest_fitting = fitting_factors.empty() ? divisors[l].front() : fitting_factors.back();
+        std::vector<int> powers_of_two;
+        
+        for (int fact : divisors[l])
+            if ((fact & (fact - 1)) == 0)
+                powers_of_two.push_back(fact);
+                
+        std::stable_sort(powers_of_two.begin(), powers_of_two.end(), [&](int a, int b) {
+            if ((a <= largest_fitting) != (b <= largest_fitting))
+                return a <= largest_fitting;
+                
+            return a <= largest_fitting ? a > b : a < b;
+        });
+        
+        candidates[l] = fitting_factors;
+        for (int fact : powers_of_two)
+        {
+            if (candidates[l].size() >= std::max(max_factors_per_level, 1))
+                break;
+                
+            if (std::find(candidates[l].begin(), candidates[l].end(), fact) == candidates[l].end())
+                candidates[l].push_back(fact);
+        }
+        
+        if (candidates[l].size() > std::max(max_factors_per_level, 1))
+            candidates[l].resize(std::max(max_factors_per_level, 1));
+            
+        if (candidates[l].empty())
+            candidates[l].push_back(divisors[l].front());
+            
+        std::sort(candidates[l].begin(), candidates[l].end());
+    }
+    
+    // Compute the footprint of each combination of factors
+    std::vector<std::pair<double, std::vector<int>>> tiles;
+    std::vector<int> indices(nb_levels, 0);
+    
+    while (true)
+    {
+        std::vector<int> factors(nb_levels);
+        for (int l = 0; l < nb_levels; ++l)
+            factors[l] = candidates[l][indices[l]];
+            
+        tiles.push_back(std::make_pair(get_footprint(factors), factors));
+        
+        // Go to the next combination
+        int l = nb_levels - 1;
+        while (l >= 0 && ++indices[l] == candidates[l].size())
+        {
+            indices[l] = 0;
+            l--;
+        }
+        
+        if (l < 0)
+            break;
+    }
+    
+    // From the largest footprint to the smallest. For a same footprint,
+    // prefer a large innermost factor, as the innermost level accesses memory contiguously.
+    typedef std::pair<double, std::vector<int>> tile_info;
+    
+    std::stable_sort(tiles.begin(), tiles.end(), [](tile_info const& a, tile_info const& b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+            
+        return a.second.back() > b.second.back();
+    });
+    
+    // For each cache level, keep the largest tiles that fit in the cache
+    std::vector<std::vector<int>> tiling_factors;
+    for (int cache_size : {machine.l1_size, machine.l2_size})
+    {
+        int nb_selected = 0;
+        
+        for (auto const& tile : tiles)
+        {
+            if (nb_selected >= nb_factors_per_cache)
+                break;
+                
+            if (tile.first > cache_size)
+                continue;
+                
+            if (std::find(tiling_factors.begin(), tiling_factors.end(), tile.second) == tiling_factors.end())
+            {
+                tiling_factors.push_back(tile.second);
+                nb_selected++;
+            }
+        }
+    }
+    
+    // No tile fits in the caches, propose the smallest one
+    if (tiling_factors.empty())
+        tiling_factors.push_back(tiles.back().second);
+        
+    return tiling_factors;
+}
+
+void schedules_generator::analyze_dependences(tiramisu::function *fct)
+{
+    if (analyzed_fct == fct)
+        return ;
+        
+    // The dependences are computed on the original schedule
+    fct->reset_schedules();
+    fct->performe_full_dependecy_analysis();
+    fct->reset_schedules();
+    
+    analyzed_fct = fct;
+}
+
+void schedules_generator::apply_schedule_for_legality_check(syntax_tree const& ast)
+{
+    tiramisu::function *fct = ast.fct;
+    analyze_dependences(fct);
+    
+    fct->reset_schedules();
+    apply_optimizations(ast);
+    
+    fct->gen_ordering_schedules();
+    fct->align_schedules();
+}
+
+bool schedules_generator::schedule_is_legal(syntax_tree const& ast)
+{
+    analyze_dependences(ast.fct);
+    
+    // Apply the last optimization on a copy of the AST,
+    // as fusions are applied from the structure of the AST.
+    syntax_tree transformed_ast;
+    ast_node *new_node = ast.copy_and_return_node(transformed_ast, ast.new_optims.back().node);
+    
+    transformed_ast.new_optims.back().node = new_node;
+    transformed_ast.transform_ast();
+    
+    ast.fct->reset_schedules();
+    apply_optimizations(transformed_ast);
+    
+    bool legal;
+    optimization_info const& last_optim = transformed_ast.new_optims.back();
+    
+    if (last_optim.type == optimization_type::COMPUTE_AT)
+        legal = compute_at_is_legal(transformed_ast, last_optim.comps[0], last_optim.comps[1]);
+    else
+        legal = ast.fct->check_legality_for_function();
+        
+    ast.fct->reset_schedules();
+    
+    return legal;
+}
+
+bool schedules_generator::compute_at_is_legal(syntax_tree const& ast, tiramisu::computation *producer, tiramisu::computation *consumer)
+{
+    ast.fct->gen_ordering_schedules();
+    ast.fct->align_schedules();
+    
+    std::vector<tiramisu::computation*> const& comps = ast.get_computations();
+    
+    for (tiramisu::computation *comp : comps)
+    {
+        if (!comp->applied_schedule_is_legal())
+            return false;
+            
+        for (tiramisu::computation *second : comps)
+        {
+            if (second == comp || (comp == producer && second == consumer))
+                continue;
+                
+            if (!comp->applied_schedule_is_legal(second))
+                return false;
+        }
+    }
+    
+    return true;
+}
+
+void schedules_generator::remove_illegal_schedules(std::vector<syntax_tree*>& states)
+{
+    if (!check_legality)
+        return ;
+        
+    std::vector<syntax_tree*> legal_states;
+    
+    for (syntax_tree *state : states)
+    {
+        optimization_type optim = state->new_optims.back().type;
+        
+        if (optim != optimization_type::FUSION && optim != optimization_type::UNFUSE &&
+            optim != optimization_type::TILING && optim != optimization_type::INTERCHANGE &&
+            optim != optimization_type::COMPUTE_AT)
+        {
+            legal_states.push_back(state);
+            continue;
+        }
+        
+        if (schedule_is_legal(*state))
+            legal_states.push_back(state);
+            
+        else
+        {
+            delete state;
+            nb_pruned_schedules++;
+        }
+    }
+    
+    states = legal_states;
+}
+
+bool schedules_generator::loop_level_is_legal(std::vector<tiramisu::computation*> const& comps, int level, optimization_type optim)
+{
+    for (tiramisu::computation *comp : comps)
+    {
+        int comp_level = level;
+        if (comp_level == -1)
+            comp_level = comp->get_loop_levels_number() - 1;
+            
+        std::vector<std::string> loop_names = comp->get_loop_level_names();
+        if (comp_level < 0 || comp_level >= loop_names.size())
+            return false;
+            
+        tiramisu::var loop_var(loop_names[comp_level]);
+        
+        if (optim == optimization_type::VECTORIZE && !comp->vectorization_is_legal(loop_var))
+            return false;
+            
+        if (optim == optimization_type::PARALLELIZE && !comp->parallelization_is_legal(loop_var))
+            return false;
+    }
+    
+    return true;
+}
+
+std::vector<std::vector<int>> schedules_generator::get_tiling_factors(ast_node *node, int nb_levels, syntax_tree const& ast) const
+{
+    if (tiling_factors_gen != nullptr)
+        return tiling_factors_gen->get_tiling_factors(node, nb_levels, ast);
+        
+    // Every combination of factors of tiling_factors_list that split the loop levels
+    std::vector<std::vector<int>> tiling_factors = {{}};
+    ast_node *level = node;
+    
+    for (int l = 0; l < nb_levels; ++l)
+    {
+        std::vector<std::vector<int>> new_tiling_factors;
+        
+        for (std::vector<int> const& factors : tiling_factors)
+            for (int fact : tiling_factors_list)
+            {
+                if (!can_split_iterator(level->get_extent(), fact))
+                    continue;
+                    
+                new_tiling_factors.push_back(factors);
+                new_tiling_factors.back().push_back(fact);
+            }
+            
+        tiling_factors = new_tiling_factors;
+        
+        if (l < nb_levels - 1)
+        {
+            if (level->children.empty())
+                return {};
+                
+            level = level->children[0];
+        }
+    }
+    
+    return tiling_factors;
+}
+
 std::vector<syntax_tree*> exhaustive_generator::generate_schedules(syntax_tree const& ast, optimization_type optim)
 {
     std::vector<syntax_tree*> states;
@@ -31,11 +459,34 @@ std::vector<syntax_tree*> exhaustive_generator::generate_schedules(syntax_tree c
                 generate_unrollings(root, states, ast);
                     
             break;
+            
+        case optimization_type::PARALLELIZE:
+            apply_schedule_for_legality_check(ast);
+            
+            for (ast_node *root : ast.roots)
+                generate_parallelizations(root, states, ast);
+                
+            ast.fct->reset_schedules();
+            break;
+            
+        case optimization_type::VECTORIZE:
+            apply_schedule_for_legality_check(ast);
+            
+            for (ast_node *root : ast.roots)
+                generate_vectorizations(root, states, ast);
+                
+            ast.fct->reset_schedules();
+            break;
+            
+        case optimization_type::COMPUTE_AT:
+            generate_compute_ats(states, ast);
+            break;
 
         default:
             break;
     }
     
+    remove_illegal_schedules(states);
     return states;
 }
 
@@ -66,6 +517,11 @@ void exhaustive_generator::generate_fusions(std::vector<ast_node*> const& tree_l
                 optim_info.nb_l = 2;
                 optim_info.l0 = i;
                 optim_info.l1 = j;
+                optim_info.l2 = tree_level[i]->depth;
+                
+                tree_level[i]->get_all_computations(optim_info.comps);
+                tree_level[j]->get_all_computations(optim_info.comps);
+                
                 new_ast->new_optims.push_back(optim_info);
                 
                 states.push_back(new_ast);
@@ -81,73 +537,36 @@ void exhaustive_generator::generate_tilings(ast_node *node, std::vector<syntax_t
 {
     int branch_depth = node->get_loop_levels_chain_depth();
     
-    // Generate tiling with dimension 2
-    if (node->depth + 1 < branch_depth)
+    // Generate tiling with dimension 2, and then with dimension 3
+    for (int nb_levels = 2; nb_levels <= 3 && node->depth + nb_levels - 1 < branch_depth; ++nb_levels)
     {
-        for (int tiling_size1 : tiling_factors_list)
+        for (std::vector<int> const& factors : get_tiling_factors(node, nb_levels, ast))
         {
-            if (!can_split_iterator(node->get_extent(), tiling_size1))
-                continue;
+            // Copy the AST, and add tiling to the list of optimizations
+            syntax_tree *new_ast = new syntax_tree();
+            ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
                 
-            ast_node *node2 = node->children[0];
-            for (int tiling_size2 : tiling_factors_list)
+            optimization_info optim_info;
+            optim_info.type = optimization_type::TILING;
+            optim_info.node = new_node;
+            
+            optim_info.nb_l = nb_levels;
+            optim_info.l0 = node->depth;
+            optim_info.l1 = node->depth + 1;
+            
+            optim_info.l0_fact = factors[0];
+            optim_info.l1_fact = factors[1];
+            
+            if (nb_levels == 3)
             {
-                if (!can_split_iterator(node2->get_extent(), tiling_size2))
-                    continue;
-                    
-                // Copy the AST, and add tiling to the list of optimizations
-                syntax_tree *new_ast = new syntax_tree();
-                ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
-                    
-                optimization_info optim_info;
-                optim_info.type = optimization_type::TILING;
-                optim_info.node = new_node;
-                
-                optim_info.nb_l = 2;
-                optim_info.l0 = node->depth;
-                optim_info.l1 = node->depth + 1;
-                
-                optim_info.l0_fact = tiling_size1;
-                optim_info.l1_fact = tiling_size2;
-                
-                new_node->get_all_computations(optim_info.comps);
-                
-                new_ast->new_optims.push_back(optim_info);
-                states.push_back(new_ast);
-                
-                // Generate tiling with dimension 3
-                if (node->depth + 2 < branch_depth)
-                {
-                    ast_node *node3 = node2->children[0];
-                    for (int tiling_size3 : tiling_factors_list)
-                    {
-                        if (!can_split_iterator(node3->get_extent(), tiling_size3))
-                            continue;
-                            
-                        // Copy the AST, and add tiling to the list of optimizations
-                        syntax_tree* new_ast = new syntax_tree();
-                        ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
-                            
-                        optimization_info optim_info;
-                        optim_info.type = optimization_type::TILING;
-                        optim_info.node = new_node;
-                        
-                        optim_info.nb_l = 3;
-                        optim_info.l0 = node->depth;
-                        optim_info.l1 = node->depth + 1;
-                        optim_info.l2 = node->depth + 2;
-                        
-                        optim_info.l0_fact = tiling_size1;
-                        optim_info.l1_fact = tiling_size2;
-                        optim_info.l2_fact = tiling_size3;
-                        
-                        new_node->get_all_computations(optim_info.comps);
-                        
-                        new_ast->new_optims.push_back(optim_info);
-                        states.push_back(new_ast);
-                    }
-                }
+                optim_info.l2 = node->depth + 2;
+                optim_info.l2_fact = factors[2];
             }
+            
+            new_node->get_all_computations(optim_info.comps);
+            
+            new_ast->new_optims.push_back(optim_info);
+            states.push_back(new_ast);
         }
     }
     
@@ -157,7 +576,7 @@ void exhaustive_generator::generate_tilings(ast_node *node, std::vector<syntax_t
 
 void exhaustive_generator::generate_interchanges(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast)
 {
-    if (!node->unrolled && node->get_extent() > 1)
+    if (!node->unrolled && !node->vectorized && node->get_extent() > 1)
     {
         int branch_depth = node->get_loop_levels_chain_depth();
         
@@ -187,7 +606,7 @@ void exhaustive_generator::generate_interchanges(ast_node *node, std::vector<syn
 
 void exhaustive_generator::generate_unrollings(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast)
 {
-    if (!node->unrolled && node->get_extent() > 1)
+    if (!node->unrolled && !node->vectorized && node->get_extent() > 1)
     {
         for (int unrolling_factor : unrolling_factors_list)
         {
@@ -217,6 +636,193 @@ void exhaustive_generator::generate_unrollings(ast_node *node, std::vector<synta
         generate_unrollings(child, states, ast);
 }
 
+void exhaustive_generator::generate_parallelizations(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast)
+{
+    // Nested parallelism is not generated
+    if (node->parallelized)
+        return ;
+        
+    if (!node->unrolled && !node->vectorized && node->get_extent() > 1)
+    {
+        std::vector<tiramisu::computation*> comps;
+        node->get_all_computations(comps);
+        
+        if (loop_level_is_legal(comps, node->depth, optimization_type::PARALLELIZE))
+        {
+            // Copy the AST, and add parallelization to the list of optimizations
+            syntax_tree* new_ast = new syntax_tree();
+            ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
+            
+            optimization_info optim_info;
+            optim_info.type = optimization_type::PARALLELIZE;
+            optim_info.node = new_node;
+                
+            optim_info.nb_l = 1;
+            optim_info.l0 = node->depth;
+            new_node->get_all_computations(optim_info.comps);
+                
+            new_ast->new_optims.push_back(optim_info);
+            states.push_back(new_ast);
+        }
+    }
+    
+    for (ast_node *child : node->children)
+        generate_parallelizations(child, states, ast);
+}
+
+void exhaustive_generator::generate_vectorizations(ast_node *node, std::vector<syntax_tree*>& states, syntax_tree const& ast)
+{
+    // Only innermost loop levels are vectorized
+    if (node->children.empty() && !node->unrolled && !node->vectorized && node->get_extent() > 1)
+    {
+        std::vector<tiramisu::computation*> comps;
+        node->get_all_computations(comps);
+        
+        bool legality_checked = false;
+        
+        for (int vector_len : vectorization_factors_list)
+        {
+            if (!can_split_iterator(node->get_extent(), vector_len))
+                continue;
+                
+            // The legality doesn't depend on the vector length, check it once
+            if (!legality_checked)
+            {
+                if (!loop_level_is_legal(comps, node->depth, optimization_type::VECTORIZE))
+                    break;
+                    
+                legality_checked = true;
+            }
+                
+            // Copy the AST, and add vectorization to the list of optimizations
+            syntax_tree* new_ast = new syntax_tree();
+            ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
+
+            optimization_info optim_info;
+            optim_info.type = optimization_type::VECTORIZE;
+            optim_info.node = new_node;
+                
+            optim_info.nb_l = 1;
+            optim_info.l0 = node->depth;
+            optim_info.l0_fact = vector_len;
+            new_node->get_all_computations(optim_info.comps);
+                
+            new_ast->new_optims.push_back(optim_info);
+            states.push_back(new_ast);
+        }
+    }
+    
+    for (ast_node *child : node->children)
+        generate_vectorizations(child, states, ast);
+}
+
+void exhaustive_generator::generate_compute_ats(std::vector<syntax_tree*>& states, syntax_tree const& ast)
+{
+    std::vector<computation_info const*> comps_info;
+    for (ast_node *root : ast.roots)
+        get_computations_info(root, comps_info);
+        
+    for (int p = 0; p < ast.roots.size(); ++p)
+    {
+        std::vector<tiramisu::computation*> producer_comps;
+        ast.roots[p]->get_all_computations(producer_comps);
+        
+        if (producer_comps.size() != 1)
+            continue;
+            
+        tiramisu::computation *producer = producer_comps[0];
+        tiramisu::buffer *producer_buf = producer->get_buffer();
+        
+        // The values of the producer must not be needed outside of the function
+        if (producer_buf == nullptr || producer_buf->get_argument_type() != tiramisu::a_temporary)
+            continue;
+            
+        computation_info const *producer_info = nullptr;
+        tiramisu::computation *consumer = nullptr;
+        bool single_consumer = true;
+        
+        // Look for the computations that read or write the buffer of the producer
+        for (computation_info const *comp_info : comps_info)
+        {
+            if (comp_info->comp_ptr == producer)
+            {
+                producer_info = comp_info;
+                continue;
+            }
+            
+            if (comp_info->comp_ptr->get_buffer() == producer_buf)
+                single_consumer = false;
+                
+            for (dnn_access_matrix const& access : comp_info->accesses.accesses_list)
+                if (access.buffer_name == producer_buf->get_name())
+                {
+                    if (consumer != nullptr && consumer != comp_info->comp_ptr)
+                        single_consumer = false;
+                        
+                    consumer = comp_info->comp_ptr;
+                }
+        }
+        
+        if (!single_consumer || consumer == nullptr || producer_info == nullptr || producer_info->is_reduction)
+            continue;
+            
+        // Only the dependences from the producer to the consumer through the buffer of the producer
+        // are satisfied by compute_at() itself (see compute_at_is_legal()), so the producer
+        // must not read the buffer written by the consumer.
+        tiramisu::buffer *consumer_buf = consumer->get_buffer();
+        bool reads_consumer_buf = false;
+        
+        for (dnn_access_matrix const& access : producer_info->accesses.accesses_list)
+            if (consumer_buf != nullptr && access.buffer_name == consumer_buf->get_name())
+                reads_consumer_buf = true;
+                
+        if (reads_consumer_buf)
+            continue;
+            
+        // The consumer must be in a later loop nest
+        ast_node *producer_node = ast.computations_mapping.at(producer);
+        ast_node *consumer_node = ast.computations_mapping.at(consumer);
+        
+        auto consumer_root = std::find(ast.roots.begin(), ast.roots.end(), consumer_node->get_root_node());
+        if (consumer_root - ast.roots.begin() <= p)
+            continue;
+            
+        // The loop levels of the consumer, from the outermost to the innermost
+        std::vector<ast_node*> consumer_levels;
+        for (ast_node *node = consumer_node; node != nullptr; node = node->parent)
+            consumer_levels.insert(consumer_levels.begin(), node);
+            
+        // The buffer can only be shrunk if the producer stores each point of its iteration domain
+        bool can_shrink = producer_info->buffer_nb_dims == producer_info->iters.size();
+        
+        // tiramisu::computation::compute_at() needs a loop level greater than 0.
+        // The producer must be computed above the level of the consumer, and have enough loop levels.
+        for (int level = 1; level < consumer_levels.size() - 1 && level <= producer_node->depth; ++level)
+        {
+            for (int storage_level : {-1, level})
+            {
+                if (storage_level != -1 && !can_shrink)
+                    continue;
+                    
+                syntax_tree *new_ast = new syntax_tree();
+                ast_node *new_node = ast.copy_and_return_node(*new_ast, consumer_levels[level]);
+                
+                optimization_info optim_info;
+                optim_info.type = optimization_type::COMPUTE_AT;
+                optim_info.node = new_node;
+                optim_info.comps = {producer, consumer};
+                
+                optim_info.nb_l = 1;
+                optim_info.l0 = level;
+                optim_info.l1 = storage_level;
+                
+                new_ast->new_optims.push_back(optim_info);
+                states.push_back(new_ast);
+            }
+        }
+    }
+}
+
 std::vector<syntax_tree*> ml_model_schedules_generator::generate_schedules(syntax_tree const& ast, optimization_type optim)
 {
     // This method generates schedules applied on shared loops, so it does not
@@ -229,6 +835,8 @@ std::vector<syntax_tree*> ml_model_schedules_generator::generate_schedules(synta
     
     std::vector<int> shared_levels_extents;
     std::vector<int> innermost_extents;
+    std::vector<ast_node*> innermost_nodes;
+    std::vector<tiramisu::computation*> innermost_comps;
     int nb_shared_iterators;
     
     // Generate the specified optimization
@@ -274,18 +882,12 @@ std::vector<syntax_tree*> ml_model_schedules_generator::generate_schedules(synta
             
             for (int i = 0; i < nb_shared_iterators - 1; ++i)
             {
-                for (int tiling_size1 : tiling_factors_list)
+                // Tiling with 3 dimensions can only be applied if there are 3 shared levels left
+                for (int nb_levels = 2; nb_levels <= 3 && i + nb_levels - 1 < nb_shared_iterators; ++nb_levels)
                 {
-                    // Check if tiling_size1 splits perfectly this iterator
-                    if (!can_split_iterator(shared_levels_extents[i], tiling_size1))
-                        continue;
-                        
-                    for (int tiling_size2 : tiling_factors_list)
+                    for (std::vector<int> const& factors : get_tiling_factors(node, nb_levels, ast))
                     {
-                        if (!can_split_iterator(shared_levels_extents[i + 1], tiling_size2))
-                            continue;
-                            
-                        // Copy the AST and add tiling with 2 dimensions to the list of optimizations
+                        // Copy the AST and add tiling to the list of optimizations
                         syntax_tree* new_ast = new syntax_tree();
                         ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
                         
@@ -293,48 +895,22 @@ std::vector<syntax_tree*> ml_model_schedules_generator::generate_schedules(synta
                         optim_info.type = optimization_type::TILING;
                         optim_info.node = new_node;
                             
-                        optim_info.nb_l = 2;
+                        optim_info.nb_l = nb_levels;
                         optim_info.l0 = i;
                         optim_info.l1 = i + 1;
                         
-                        optim_info.l0_fact = tiling_size1;
-                        optim_info.l1_fact = tiling_size2;
+                        optim_info.l0_fact = factors[0];
+                        optim_info.l1_fact = factors[1];
+                        
+                        if (nb_levels == 3)
+                        {
+                            optim_info.l2 = i + 2;
+                            optim_info.l2_fact = factors[2];
+                        }
                             
                         optim_info.comps = new_ast->computations_list;
                         new_ast->new_optims.push_back(optim_info);
                         states.push_back(new_ast);
-                            
-                        // Cannot apply tiling with 3 dimensions,
-                        // continue to apply tiling with 2 dimensions.
-                        if (i + 2 >= nb_shared_iterators)
-                            continue;
-                            
-                        for (int tiling_size3 : tiling_factors_list)
-                        {
-                            if (!can_split_iterator(shared_levels_extents[i + 2], tiling_size3))
-                                continue;
-                                
-                            // Copy the AST and add tiling with 3 dimensions to the list of optimizations
-                            syntax_tree* new_ast = new syntax_tree();
-                            ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
-                            
-                            optimization_info optim_info;
-                            optim_info.type = optimization_type::TILING;
-                            optim_info.node = new_node;
-                                
-                            optim_info.nb_l = 3;
-                            optim_info.l0 = i;
-                            optim_info.l1 = i + 1;
-                            optim_info.l2 = i + 2;
-                            
-                            optim_info.l0_fact = tiling_size1;
-                            optim_info.l1_fact = tiling_size2;
-                            optim_info.l2_fact = tiling_size3;
-                                
-                            optim_info.comps = new_ast->computations_list;
-                            new_ast->new_optims.push_back(optim_info);
-                            states.push_back(new_ast);
-                        }
                     }
                 }
                 
@@ -377,6 +953,11 @@ std::vector<syntax_tree*> ml_model_schedules_generator::generate_schedules(synta
             break;
 
         case optimization_type::UNROLLING:
+            // Vectorized loop levels are not unrolled
+            for (ast_node *innermost_node : ast.get_innermost_nodes())
+                if (innermost_node->vectorized)
+                    return states;
+                    
             innermost_extents = ast.get_innermost_extents();
                
             // Apply all possible unrolling factors to all innermost iterators
@@ -411,11 +992,107 @@ std::vector<syntax_tree*> ml_model_schedules_generator::generate_schedules(synta
                 states.push_back(new_ast);
             }
             break;
+            
+        case optimization_type::PARALLELIZE:
+            // Only one loop level is parallelized
+            if (ast_has_optimization(ast, optimization_type::PARALLELIZE))
+                return states;
+                
+            shared_levels_extents = ast.get_shared_levels_extents();
+            nb_shared_iterators = std::min((int)shared_levels_extents.size(), max_nb_iterators);
+            
+            apply_schedule_for_legality_check(ast);
+            
+            for (int i = 0; i < nb_shared_iterators; ++i)
+            {
+                if (node->unrolled || node->vectorized)
+                    break;
+                    
+                if (shared_levels_extents[i] > 1 && loop_level_is_legal(ast.computations_list, i, optimization_type::PARALLELIZE))
+                {
+                    // Copy the AST and add parallelization to the list of optimizations
+                    syntax_tree* new_ast = new syntax_tree();
+                    ast_node *new_node = ast.copy_and_return_node(*new_ast, node);
+                    
+                    optimization_info optim_info;
+                    optim_info.type = optimization_type::PARALLELIZE;
+                    optim_info.node = new_node;
+                        
+                    optim_info.nb_l = 1;
+                    optim_info.l0 = i;
+                        
+                    optim_info.comps = new_ast->computations_list;
+                    new_ast->new_optims.push_back(optim_info);
+                    states.push_back(new_ast);
+                }
+                
+                if (node->children.size() > 0)
+                    node = node->children[0];
+            }
+            
+            ast.fct->reset_schedules();
+            break;
+            
+        case optimization_type::VECTORIZE:
+            if (ast_has_optimization(ast, optimization_type::VECTORIZE))
+                return states;
+                
+            innermost_nodes = ast.get_innermost_nodes();
+            for (ast_node *innermost_node : innermost_nodes)
+            {
+                if (innermost_node->unrolled)
+                    return states;
+                    
+                for (auto const& comp_info : innermost_node->computations)
+                    innermost_comps.push_back(comp_info->comp_ptr);
+            }
+                
+            innermost_extents = ast.get_innermost_extents();
+            apply_schedule_for_legality_check(ast);
+            
+            // Vectorize all innermost iterators, if it is legal
+            if (loop_level_is_legal(innermost_comps, -1, optimization_type::VECTORIZE))
+            {
+                for (int vector_len : vectorization_factors_list)
+                {
+                    bool use_factor = true;
+                    for (int extent : innermost_extents)
+                    {
+                        if (!can_split_iterator(extent, vector_len))
+                        {
+                            use_factor = false;
+                            break;
+                        }
+                    }
+                    
+                    if (!use_factor)
+                        continue;
+                        
+                    // Copy the AST and add vectorization to the list of optimizations
+                    syntax_tree* new_ast = ast.copy_ast();
+
+                    optimization_info optim_info;
+                    optim_info.type = optimization_type::VECTORIZE;
+                    optim_info.nb_l = 1;
+                    
+                    // When l0 is set to -1, vectorization is applied to all innermost levels
+                    optim_info.l0 = -1;
+                    optim_info.l0_fact = vector_len;
+                        
+                    optim_info.comps = new_ast->get_innermost_computations();
+                    new_ast->new_optims.push_back(optim_info);
+                    states.push_back(new_ast);
+                }
+            }
+            
+            ast.fct->reset_schedules();
+            break;
 
         default:
             break;
     }
     
+    remove_illegal_schedules(states);
     return states;
 }
 
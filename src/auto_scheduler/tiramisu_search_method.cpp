@@ -1,142 +1,1091 @@
 #include <tiramisu/auto_scheduler/search_method.h>
 #include <random>
+#include <cmath>
+#include <unordered_set>
+#include <algorithm>
 
 namespace tiramisu::auto_scheduler
 {
 
+/**
+ * Return the number of seconds elapsed since the given time point.
+ */
+static double get_time_since(std::chrono::steady_clock::time_point const& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<float> search_method::evaluate_schedules(std::vector<syntax_tree*> const& asts)
+{
+    std::vector<float> evals;
+    std::vector<bool> evaluated(asts.size(), true);
+    
+    auto evaluation_start = std::chrono::steady_clock::now();
+    
+    if (eval_cache == nullptr)
+    {
+        evals = eval_func->evaluate_batch(asts);
+        
+        for (syntax_tree *ast : asts)
+            ast->evaluation_ci = eval_func->get_confidence_interval(*ast);
+    }
+    
+    else
+        evals = evaluate_schedules_with_cache(asts, evaluated);
+        
+
+    if (telemetry != nullptr)
+        record_candidates(asts, evals, evaluated, eval_func, get_time_since(evaluation_start));
+        
+    if (checkpoint != nullptr && checkpoint->save_due())
+        save_checkpoint();
+        
+    return evals;
+}
+
+std::vector<float> search_method::evaluate_schedules_with_cache(std::vector<syntax_tree*> const& asts, std::vector<bool>& evaluated)
+{
+    std::vector<float> evals(asts.size());
+    
+    // Keep the ASTs that are not in the cache.
+    // If several ASTs have the same schedule, only the first one is evaluated.
+    std::vector<syntax_tree*> asts_to_eval;
+    std::vector<int> asts_to_eval_index(asts.size(), -1);
+    std::unordered_map<uint64_t, int> fingerprints;
+    
+    for (int i = 0; i < asts.size(); ++i)
+    {
+        evaluated[i] = false;
+        if (eval_cache->find(*asts[i], evals[i], asts[i]->evaluation_ci))
+            continue;
+            
+        uint64_t fingerprint = asts[i]->get_fingerprint();
+        auto it = fingerprints.find(fingerprint);
+        
+        if (it == fingerprints.end())
+        {
+            fingerprints[fingerprint] = asts_to_eval.size();
+            asts_to_eval_index[i] = asts_to_eval.size();
+            asts_to_eval.push_back(asts[i]);
+            evaluated[i] = true;
+        }
+        
+        else
+            asts_to_eval_index[i] = it->second;
+    }
+    
+    if (asts_to_eval.empty())
+        return evals;
+        
+    std::vector<float> new_evals = eval_func->evaluate_batch(asts_to_eval);
+    
+    // Estimated evaluations are cached too, so that a resumed search ranks the schedules
+    // the same way without executing them again on reduced iteration domains.
+    for (int i = 0; i < asts_to_eval.size(); ++i)
+        eval_cache->insert(*asts_to_eval[i], new_evals[i], eval_func->get_confidence_interval(*asts_to_eval[i]),
+                           eval_func->is_estimated(*asts_to_eval[i]));
+        
+    for (int i = 0; i < asts.size(); ++i)
+        if (asts_to_eval_index[i] != -1)
+        {
+            evals[i] = new_evals[asts_to_eval_index[i]];
+            asts[i]->evaluation_ci = eval_func->get_confidence_interval(*asts[i]);
+        }
+            
+    return evals;
+}
+
+void search_method::record_candidates(std::vector<syntax_tree*> const& asts, std::vector<float> const& evals,
+                                      std::vector<bool> const& evaluated, evaluation_function *func, double batch_time)
+{
+    if (asts.empty())
+        return ;
+        
+    int nb_evaluated = std::count(evaluated.begin(), evaluated.end(), true);
+    double transform_time = (generation_time - recorded_generation_time) / asts.size();
+    recorded_generation_time = generation_time;
+    
+    double time = get_elapsed_time();
+    
+    for (int i = 0; i < asts.size(); ++i)
+    {
+        evaluation_phases phases;
+        phases.transform = transform_time;
+        
+        // Execution times come with the time of each compilation phase,
+        // predictions only with the time of the whole batch.
+        evaluation_phases eval_phases;
+        if (evaluated[i] && func->take_evaluation_phases(*asts[i], eval_phases))
+            phases += eval_phases;
+            
+        else if (evaluated[i] && !func->measures_execution())
+            phases.prediction = batch_time / nb_evaluated;
+            
+        float predicted = FLT_MAX, measured = FLT_MAX;
+        bool estimated = func == eval_func ? is_estimated(*asts[i]) : evaluated[i] && func->is_estimated(*asts[i]);
+        if (!func->measures_execution() || estimated)
+            predicted = evals[i];
+            
+        else
+        {
+            measured = evals[i];
+            
+            // The schedule was first evaluated by a model, then executed
+            if (func != eval_func && !eval_func->measures_execution())
+                predicted = asts[i]->evaluation;
+        }
+        
+        float ci = evaluated[i] ? func->get_confidence_interval(*asts[i]) : 0;
+        telemetry->record_candidate(*asts[i], time, predicted, measured, ci, !evaluated[i], phases);
+    }
+}
+
+int search_method::get_nb_compilations() const
+{
+    int nb_compilations = resumed_compilations + eval_func->get_nb_compilations();
+    if (exec_eval != nullptr && exec_eval != eval_func)
+        nb_compilations += exec_eval->get_nb_compilations();
+        
+    return nb_compilations;
+}
+
+int search_method::get_nb_executions() const
+{
+    int nb_executions = resumed_executions + eval_func->get_nb_executions();
+    if (exec_eval != nullptr && exec_eval != eval_func)
+        nb_executions += exec_eval->get_nb_executions();
+        
+    return nb_executions;
+}
+
+bool search_method::budget_exhausted() const
+{
+    if (budget.max_time > 0 && get_elapsed_time() >= budget.max_time)
+        return true;
+        
+    if (budget.max_compilations > 0 && get_nb_compilations() >= budget.max_compilations)
+        return true;
+        
+    if (budget.max_executions > 0 && get_nb_executions() >= budget.max_executions)
+        return true;
+        
+    return false;
+}
+
+void search_method::sort_by_evaluation(std::vector<syntax_tree*>& asts)
+{
+    std::stable_sort(asts.begin(), asts.end(), [](syntax_tree *a, syntax_tree *b) {
+        return a->evaluation < b->evaluation;
+    });
+    
+    // Group the ASTs tied with the best AST of their group
+    std::unordered_map<syntax_tree*, int> groups;
+    syntax_tree *group_best = nullptr;
+    int group = 0;
+    
+    for (syntax_tree *ast : asts)
+    {
+        if (group_best == nullptr || is_better(*group_best, *ast))
+        {
+            group_best = ast;
+            group++;
+        }
+        
+        groups[ast] = group;
+    }
+    
+    std::stable_sort(asts.begin(), asts.end(), [&](syntax_tree *a, syntax_tree *b) {
+        if (groups[a] != groups[b])
+            return groups[a] < groups[b];
+            
+        return a->previous_optims.size() + a->new_optims.size() < b->previous_optims.size() + b->new_optims.size();
+    });
+}
+
+bool search_method::is_estimated(syntax_tree const& ast) const
+{
+    return eval_func->is_estimated(ast) || (eval_cache != nullptr && eval_cache->is_estimated(ast));
+}
+
+std::vector<optimization_type> search_method::get_optimizations_order() const
+{
+    if (scheds_gen == nullptr)
+        return DEFAULT_OPTIMIZATIONS_ORDER;
+        
+    std::vector<optimization_type> optims_order;
+    for (optimization_type optim : DEFAULT_OPTIMIZATIONS_ORDER)
+        if (scheds_gen->supports_optimization(optim))
+            optims_order.push_back(optim);
+            
+    return optims_order;
+}
+
+void search_method::update_best_ast(syntax_tree *ast)
+{
+    // A schedule must be measured to become the best schedule
+    if (is_estimated(*ast))
+        return ;
+        
+    if (best_ast == nullptr ? ast->evaluation < best_evaluation : is_better(*ast, *best_ast))
+    {
+        if (owns_best_ast)
+            delete best_ast;
+            
+        best_evaluation = ast->evaluation;
+        best_ast = ast;
+        owns_best_ast = false;
+    }
+}
+
+void search_method::release_ast(syntax_tree *ast)
+{
+    if (ast == best_ast)
+        owns_best_ast = true;
+    else
+        delete ast;
+}
+
+void search_method::execute_best_schedules(std::vector<syntax_tree*> const& schedules, int topk)
+{
+    if (schedules.empty())
+        return ;
+        
+    if (exec_eval == nullptr)
+    {
+        // The best schedule so far (e.g. restored from a checkpoint) is only replaced by a better one
+        for (syntax_tree *sched : schedules)
+            update_best_ast(sched);
+            
+        if (best_ast == nullptr)
+        {
+            best_evaluation = schedules[0]->evaluation;
+            best_ast = schedules[0];
+        }
+        
+        return ;
+    }
+        
+    auto exec_start = std::chrono::steady_clock::now();
+    
+    // The best schedule so far competes with the given schedules. It is executed first,
+    // so that its execution time is compared to theirs, unless it is one of them.
+    std::vector<syntax_tree*> candidates;
+    int nb_to_execute = topk;
+    
+    if (best_ast != nullptr)
+    {
+        uint64_t best_fingerprint = best_ast->get_fingerprint();
+        bool is_candidate = std::any_of(schedules.begin(), schedules.end(), [&](syntax_tree *sched) {
+            return sched->get_fingerprint() == best_fingerprint;
+        });
+        
+        if (!is_candidate)
+        {
+            candidates.push_back(best_ast);
+            nb_to_execute++;
+        }
+    }
+    
+    candidates.insert(candidates.end(), schedules.begin(), schedules.end());
+    
+    std::unordered_set<uint64_t> executed_schedules;
+    syntax_tree *fastest_sched = nullptr;
+    float fastest_time = FLT_MAX, fastest_ci = 0;
+    
+    for (syntax_tree *sched : candidates)
+    {
+        if (executed_schedules.size() >= nb_to_execute || budget_exhausted())
+            break;
+            
+        if (!executed_schedules.insert(sched->get_fingerprint()).second)
+            continue;
+            
+        float exec_ci;
+        float exec_time = execute_schedule(*sched, exec_ci);
+        
+        if (fastest_sched == nullptr || exec_time + exec_ci < fastest_time - fastest_ci)
+        {
+            fastest_time = exec_time;
+            fastest_ci = exec_ci;
+            fastest_sched = sched;
+        }
+    }
+    
+    final_exec_time += get_time_since(exec_start);
+    
+    // Nothing could be executed (e.g. the budget is exhausted) : keep the best schedule so far
+    if (fastest_sched == nullptr)
+    {
+        if (best_ast == nullptr)
+        {
+            best_evaluation = schedules[0]->evaluation;
+            best_ast = schedules[0];
+        }
+        
+        return ;
+    }
+    
+    if (fastest_sched != best_ast)
+    {
+        if (owns_best_ast)
+            delete best_ast;
+            
+        owns_best_ast = false;
+        best_ast = fastest_sched;
+    }
+    
+    best_evaluation = fastest_time;
+}
+
+float search_method::execute_schedule(syntax_tree& ast, float& exec_ci)
+{
+    float exec_time;
+    exec_ci = 0;
+    
+    if (exec_cache != nullptr && exec_cache->find(ast, exec_time, exec_ci))
+    {
+        if (telemetry != nullptr)
+            record_candidates({&ast}, {exec_time}, {false}, exec_eval, 0);
+            
+        return exec_time;
+    }
+        
+    auto exec_start = std::chrono::steady_clock::now();
+    
+    exec_time = exec_eval->evaluate(ast);
+    exec_ci = exec_eval->get_confidence_interval(ast);
+    
+    if (telemetry != nullptr)
+        record_candidates({&ast}, {exec_time}, {true}, exec_eval, get_time_since(exec_start));
+    
+    if (exec_cache != nullptr)
+        exec_cache->insert(ast, exec_time, exec_ci, exec_eval->is_estimated(ast));
+        
+    return exec_time;
+}
+
+std::vector<float> search_method::execute_schedules(std::vector<syntax_tree*> const& asts)
+{
+    std::vector<float> exec_times(asts.size());
+    std::vector<bool> executed(asts.size(), true);
+    
+    auto exec_start = std::chrono::steady_clock::now();
+    
+    if (exec_cache == nullptr)
+        exec_times = exec_eval->evaluate_batch(asts);
+        
+    else
+    {
+        std::vector<syntax_tree*> asts_to_exec;
+        std::vector<int> asts_to_exec_index;
+        
+        for (int i = 0; i < asts.size(); ++i)
+        {
+            if (exec_cache->find(*asts[i], exec_times[i]))
+            {
+                executed[i] = false;
+                continue;
+            }
+                
+            asts_to_exec.push_back(asts[i]);
+            asts_to_exec_index.push_back(i);
+        }
+        
+        std::vector<float> new_exec_times;
+        if (!asts_to_exec.empty())
+            new_exec_times = exec_eval->evaluate_batch(asts_to_exec);
+        
+        for (int i = 0; i < asts_to_exec.size(); ++i)
+        {
+            exec_cache->insert(*asts_to_exec[i], new_exec_times[i], exec_eval->get_confidence_interval(*asts_to_exec[i]),
+                               exec_eval->is_estimated(*asts_to_exec[i]));
+            exec_times[asts_to_exec_index[i]] = new_exec_times[i];
+        }
+    }
+    
+    if (telemetry != nullptr)
+        record_candidates(asts, exec_times, executed, exec_eval, get_time_since(exec_start));
+    
+    return exec_times;
+}
+
+void search_method::set_checkpoint(search_checkpoint *checkpoint, syntax_tree const& initial_ast)
+{
+    this->checkpoint = checkpoint;
+    exec_cache = checkpoint->get_execution_cache();
+    
+    if (eval_cache == nullptr)
+        eval_cache = checkpoint->get_evaluation_cache();
+        
+    if (!checkpoint->load_state(initial_ast))
+        return ;
+        
+    resumed_time = checkpoint->elapsed_time;
+    resumed_compilations = checkpoint->nb_compilations;
+    resumed_executions = checkpoint->nb_executions;
+    
+    // The best schedule of the previous runs is kept until the search finds a better one
+    syntax_tree *resumed_best_ast = checkpoint->get_best_ast(initial_ast);
+    if (resumed_best_ast != nullptr)
+    {
+        if (owns_best_ast)
+            delete best_ast;
+            
+        best_ast = resumed_best_ast;
+        best_evaluation = resumed_best_ast->evaluation;
+        owns_best_ast = true;
+    }
+}
+
+void search_method::save_checkpoint()
+{
+    if (checkpoint != nullptr)
+        checkpoint->save_state(best_ast, best_evaluation, get_elapsed_time(),
+                               get_nb_compilations(), get_nb_executions());
+}
+
+void search_method::prioritize_children(std::vector<syntax_tree*>& children)
+{
+    if (ranking_func != nullptr && children.size() > 1)
+    {
+        std::vector<float> ranks = ranking_func->evaluate_batch(children);
+        std::vector<int> indices(children.size());
+        
+        for (int i = 0; i < indices.size(); ++i)
+            indices[i] = i;
+            
+        std::stable_sort(indices.begin(), indices.end(), [&](int a, int b) {
+            return ranks[a] < ranks[b];
+        });
+        
+        std::vector<syntax_tree*> sorted_children;
+        for (int i : indices)
+            sorted_children.push_back(children[i]);
+            
+        children = sorted_children;
+    }
+    
+    // If evaluating a child costs a compilation and an execution,
+    // only keep the children that the remaining budget allows to evaluate.
+    if (!eval_func->measures_execution())
+        return ;
+        
+    int nb_remaining = children.size();
+    
+    if (budget.max_compilations > 0)
+        nb_remaining = std::min(nb_remaining, budget.max_compilations - get_nb_compilations());
+        
+    if (budget.max_executions > 0)
+        nb_remaining = std::min(nb_remaining, budget.max_executions - get_nb_executions());
+        
+    // With an evaluation cache, children found in the cache and children with the schedule
+    // of a child already kept are not evaluated, so they don't count against the budget.
+    std::vector<syntax_tree*> kept_children;
+    std::unordered_set<uint64_t> kept_fingerprints;
+    
+    for (syntax_tree *child : children)
+    {
+        bool free_child = eval_cache != nullptr && (eval_cache->contains(*child) ||
+                                                    kept_fingerprints.count(child->get_fingerprint()) > 0);
+                          
+        if (!free_child && nb_remaining <= 0)
+        {
+            delete child;
+            continue;
+        }
+        
+        if (!free_child)
+            nb_remaining--;
+            
+        kept_fingerprints.insert(child->get_fingerprint());
+        kept_children.push_back(child);
+    }
+        
+    children = kept_children;
+}
+
+void search_method::print_budget_report() const
+{
+    std::cout << "Search time : " << get_elapsed_time() << " s";
+    if (budget.max_time > 0)
+        std::cout << " (budget : " << budget.max_time << " s)";
+        
+    std::cout << std::endl << "NB compilations : " << get_nb_compilations();
+    if (budget.max_compilations > 0)
+        std::cout << " (budget : " << budget.max_compilations << ")";
+        
+    std::cout << std::endl << "NB executions : " << get_nb_executions();
+    if (budget.max_executions > 0)
+        std::cout << " (budget : " << budget.max_executions << ")";
+        
+    std::cout << std::endl;
+    
+    std::cout << "Time spent generating schedules : " << generation_time << " s" << std::endl;
+    std::cout << "Time spent evaluating schedules : " << evaluation_time << " s" << std::endl;
+    std::cout << "Time spent executing the best schedules : " << final_exec_time << " s" << std::endl;
+    
+    if (budget_exhausted())
+        std::cout << "The budget was exhausted, the best schedule found so far is returned." << std::endl;
+}
+
 void beam_search::search(syntax_tree& ast)
 {
-    if (ast.nb_explored_optims % NB_OPTIMIZATIONS == 0)
+    // Stop the search, and keep the best schedule found so far
+    if (budget_exhausted())
+        return ;
+        
+    std::vector<optimization_type> optims_order = get_optimizations_order();
+    
+    if (ast.nb_explored_optims % optims_order.size() == 0)
         ast.clear_new_optimizations();
        
     std::vector<syntax_tree*> children;
         
-    // Look for an optimization that can be applied
-    int nb_optims_tried = 0;
-    int nb_explored_optims = ast.nb_explored_optims;
+    // Look for an optimization that can be applied
+    int nb_optims_tried = 0;
+    int nb_explored_optims = ast.nb_explored_optims;
+    
+    auto generation_start = std::chrono::steady_clock::now();
+    
+    while (children.size() == 0 && nb_optims_tried < optims_order.size() && nb_explored_optims < max_depth)
+    {
+        optimization_type optim_type = optims_order[nb_explored_optims % optims_order.size()];
+        children = scheds_gen->generate_schedules(ast, optim_type);
+        
+        nb_explored_optims++;
+        nb_optims_tried++;
+    }
+       
+    // Stop if no more optimizations can be applied
+    if (children.size() == 0)
+        return ;
+       
+    // Evaluate children and sort them from smallest to highest evaluation
+    for (syntax_tree *child : children)
+    {
+        child->nb_explored_optims = nb_explored_optims;
+        child->transform_ast();
+    }
+    
+    generation_time += get_time_since(generation_start);
+    
+    // Evaluate the most promising children first, and only those that the budget allows
+    prioritize_children(children);
+    if (children.empty())
+        return ;
+    
+    // The children are given to the evaluation function all at once,
+    // so that it can evaluate them concurrently.
+    auto evaluation_start = std::chrono::steady_clock::now();
+    std::vector<float> children_evals = evaluate_schedules(children);
+    evaluation_time += get_time_since(evaluation_start);
+    
+    for (int i = 0; i < children.size(); ++i)
+    {
+        syntax_tree *child = children[i];
+        child->evaluation = children_evals[i];
+        
+        child->print_ast();
+        std::cout << "Evaluation : " << child->evaluation << std::endl << std::endl;
+        
+        update_best_ast(child);
+        nb_explored_schedules++;
+    }
+    
+    // Stop if we reached the maximum depth
+    if (nb_explored_optims >= max_depth)
+    {
+        for (syntax_tree *child : children)
+            release_ast(child);
+            
+        return ;
+    }
+        
+    // Add the current AST to the list of children
+    syntax_tree *ast_copy = ast.copy_ast();
+    ast_copy->nb_explored_optims = nb_explored_optims;
+    children.push_back(ast_copy);
+
+    // Sort children from smallest evaluation to largest
+    sort_by_evaluation(children);
+
+    // Search recursively on the best children
+    for (int i = beam_size; i < children.size(); ++i)
+        release_ast(children[i]);
+        
+    children.resize(std::min(beam_size, (int)children.size()));
+
+    // The subtree of a child is not needed anymore once it has been explored
+    for (syntax_tree *child : children)
+    {
+        child->search_depth = ast.search_depth + 1;        
+        search(*child);
+        release_ast(child);
+    }
+}
+
+std::vector<syntax_tree*> mcts::generate_children(syntax_tree& ast, int& nb_explored_optims)
+{
+    std::vector<optimization_type> optims_order = get_optimizations_order();
+    
+    if (ast.nb_explored_optims % optims_order.size() == 0)
+        ast.clear_new_optimizations();
+        
+    std::vector<syntax_tree*> children;
+    
+    // Look for an optimization that can be applied
+    int nb_optims_tried = 0;
+    nb_explored_optims = ast.nb_explored_optims;
+    
+    while (children.size() == 0 && nb_optims_tried < optims_order.size() && nb_explored_optims < max_depth)
+    {
+        optimization_type optim_type = optims_order[nb_explored_optims % optims_order.size()];
+        children = scheds_gen->generate_schedules(ast, optim_type);
+        
+        nb_explored_optims++;
+        nb_optims_tried++;
+    }
+    
+    for (syntax_tree *child : children)
+    {
+        child->nb_explored_optims = nb_explored_optims;
+        child->search_depth = ast.search_depth + 1;
+        child->transform_ast();
+    }
+    
+    return children;
+}
+
+void mcts::update_evaluation_bounds(float evaluation)
+{
+    if (evaluation == FLT_MAX)
+        return ;
+        
+    min_evaluation = std::min(min_evaluation, evaluation);
+    max_evaluation = std::max(max_evaluation, evaluation);
+}
+
+double mcts::get_uct_score(mcts_node const *child) const
+{
+    // Normalize the mean value between 0 (worst) and 1 (best)
+    double q = 0.5;
+    if (max_evaluation > min_evaluation)
+        q = (max_evaluation - child->get_mean_value()) / (max_evaluation - min_evaluation);
+        
+    q = std::max(0.0, std::min(q, 1.0));
+    
+    return q + exploration_constant * std::sqrt(std::log(child->parent->nb_visits) / child->nb_visits);
+}
+
+mcts::mcts_node* mcts::select(mcts_node *root)
+{
+    mcts_node *node = root;
+    
+    while (node->expanded && !node->children.empty())
+    {
+        mcts_node *best_child = nullptr;
+        double best_score = -DBL_MAX;
+        int nb_ties = 0;
+        
+        for (mcts_node *child : node->children)
+        {
+            double score = get_uct_score(child);
+            
+            if (score > best_score)
+            {
+                best_child = child;
+                best_score = score;
+                nb_ties = 1;
+            }
+            
+            // Break ties randomly
+            else if (score == best_score)
+            {
+                nb_ties++;
+                if (std::uniform_int_distribution<int>(0, nb_ties - 1)(rand_generator) == 0)
+                    best_child = child;
+            }
+        }
+        
+        node = best_child;
+    }
+    
+    return node;
+}
+
+void mcts::expand(mcts_node *node)
+{
+    node->expanded = true;
+    
+    auto generation_start = std::chrono::steady_clock::now();
+    
+    int nb_explored_optims;
+    std::vector<syntax_tree*> children = generate_children(*node->ast, nb_explored_optims);
+    
+    generation_time += get_time_since(generation_start);
+    
+    // No more optimizations can be applied : the node is terminal
+    if (children.empty())
+        return ;
+        
+    prioritize_children(children);
     
-    while (children.size() == 0 && nb_optims_tried < NB_OPTIMIZATIONS && nb_explored_optims < max_depth)
+    if (!children.empty())
     {
-        optimization_type optim_type = DEFAULT_OPTIMIZATIONS_ORDER[nb_explored_optims % NB_OPTIMIZATIONS];
-        children = scheds_gen->generate_schedules(ast, optim_type);
+        auto evaluation_start = std::chrono::steady_clock::now();
+        std::vector<float> evals = evaluate_schedules(children);
+        evaluation_time += get_time_since(evaluation_start);
         
-        nb_explored_optims++;
-        nb_optims_tried++;
+        for (int i = 0; i < children.size(); ++i)
+        {
+            children[i]->evaluation = evals[i];
+            update_evaluation_bounds(evals[i]);
+            
+            update_best_ast(children[i]);
+        }
+        
+        nb_explored_schedules += children.size();
     }
-       
-    // Stop if no more optimizations can be applied
-    if (children.size() == 0)
-        return ;
-       
-    // Evaluate children and sort them from smallest to highest evaluation
+    
+    // Add a child where the optimization is not applied.
+    // It has the same schedule as the node, so it is not evaluated again.
+    if (nb_explored_optims < max_depth)
+    {
+        syntax_tree *ast_copy = node->ast->copy_ast();
+        ast_copy->nb_explored_optims = nb_explored_optims;
+        ast_copy->search_depth = node->ast->search_depth + 1;
+        children.push_back(ast_copy);
+    }
+    
+    // The evaluation of a child is its first value
     for (syntax_tree *child : children)
     {
-        child->nb_explored_optims = nb_explored_optims;
-        child->transform_ast();
-            
-        child->evaluation = eval_func->evaluate(*child);
+        mcts_node *child_node = new mcts_node(child, node);
+        child_node->nb_visits = 1;
+        child_node->total_value = child->evaluation;
         
-        child->print_ast();
-        std::cout << "Evaluation : " << child->evaluation << std::endl << std::endl;
+        node->children.push_back(child_node);
+    }
+}
+
+double mcts::rollout(mcts_node *node)
+{
+    float evaluation = node->ast->evaluation;
+    if (rollout_func == nullptr || evaluation == FLT_MAX)
+        return evaluation;
+        
+    // Greedily apply the optimization that rollout_func finds the best,
+    // and skip the optimizations that don't improve the schedule.
+    syntax_tree *current = node->ast->copy_ast();
+    
+    float start_estimation = rollout_func->evaluate(*current);
+    float current_estimation = start_estimation;
+    
+    while (current->nb_explored_optims < max_depth && !budget_exhausted())
+    {
+        int nb_explored_optims;
+        std::vector<syntax_tree*> children = generate_children(*current, nb_explored_optims);
+        
+        if (children.empty())
+            break;
+            
+        std::vector<float> estimations = rollout_func->evaluate_batch(children);
+        int best_child = std::min_element(estimations.begin(), estimations.end()) - estimations.begin();
         
-        if (child->evaluation < best_evaluation)
+        if (estimations[best_child] < current_estimation)
         {
-            best_evaluation = child->evaluation;
-            best_ast = child;
+            std::swap(current, children[best_child]);
+            current_estimation = estimations[best_child];
         }
         
-        nb_explored_schedules++;
+        else
+            current->nb_explored_optims = nb_explored_optims;
+            
+        for (syntax_tree *child : children)
+            delete child;
     }
     
-    // Stop if we reached the maximum depth
-    if (nb_explored_optims >= max_depth)
-        return ;
+    delete current;
+    
+    if (start_estimation <= 0 || current_estimation <= 0)
+        return evaluation;
         
-    // Add the current AST to the list of children
-    syntax_tree *ast_copy = ast.copy_ast();
-    ast_copy->nb_explored_optims = nb_explored_optims;
-    children.push_back(ast_copy);
-
-    // Sort children from smallest evaluation to largest
-    std::sort(children.begin(), children.end(), [](syntax_tree *a, syntax_tree *b) {
-        return a->evaluation < b->evaluation;
-    });
-
-    // Search recursively on the best children
-    for (int i = beam_size; i < children.size(); ++i)
-        delete children[i];
+    // Scale the evaluation of the node by the speedup estimated by the rollout.
+    // Evaluations are either execution times, or negative speedups.
+    double speedup = start_estimation / current_estimation;
+    
+    if (evaluation >= 0)
+        return evaluation / speedup;
         
-    children.resize(std::min(beam_size, (int)children.size()));
+    return evaluation * speedup;
+}
 
-    for (syntax_tree *child : children)
+void mcts::backpropagate(mcts_node *node, double value)
+{
+    if (value < FLT_MAX)
+        update_evaluation_bounds(value);
+        
+    for (; node != nullptr; node = node->parent)
     {
-        child->search_depth = ast.search_depth + 1;        
-        search(*child);
+        node->nb_visits++;
+        node->total_value += value;
     }
 }
 
 void mcts::search(syntax_tree& ast)
 {
-    std::default_random_engine rand_generator;
+    rand_generator.seed(seed);
     
-    std::vector<syntax_tree*> samples;
-    std::vector<syntax_tree*> children;
-    std::vector<double> children_evals;
+    min_evaluation = FLT_MAX;
+    max_evaluation = -FLT_MAX;
+    update_evaluation_bounds(ast.evaluation);
     
-    for (int epoch = 0; epoch < nb_samples; ++epoch)
+    mcts_node *root = new mcts_node(&ast, nullptr);
+    root->nb_visits = 1;
+    root->total_value = ast.evaluation;
+    
+    for (int iteration = 0; iteration < nb_samples && !budget_exhausted(); ++iteration)
     {
-        // Starting from the initial ast, generate optimizations until reaching max_depth
-        syntax_tree *ast_sample = &ast;
-        for (int depth = 0; depth < max_depth; ++depth)
+        mcts_node *node = select(root);
+        
+        if (!node->expanded)
+            expand(node);
+            
+        // A terminal node is evaluated by its own evaluation
+        if (node->children.empty())
         {
-            optimization_type optim_type = DEFAULT_OPTIMIZATIONS_ORDER[depth % NB_OPTIMIZATIONS];
-            children = scheds_gen->generate_schedules(*ast_sample, optim_type);
-                        
-            if (children.empty())
-                continue;
-                
-            children_evals.clear();
+            backpropagate(node, node->ast->evaluation);
+            continue;
+        }
+        
+        mcts_node *child = select(node);
+        backpropagate(child, rollout(child));
+    }
+    
+    // Get the schedules of the tree sorted with respect to evaluations
+    std::vector<mcts_node*> nodes;
+    std::vector<mcts_node*> to_visit = root->children;
+    
+    while (!to_visit.empty())
+    {
+        mcts_node *node = to_visit.back();
+        to_visit.pop_back();
+        
+        nodes.push_back(node);
+        to_visit.insert(to_visit.end(), node->children.begin(), node->children.end());
+    }
+    
+    std::vector<syntax_tree*> schedules;
+    for (mcts_node *node : nodes)
+        schedules.push_back(node->ast);
+        
+    sort_by_evaluation(schedules);
+    
+    // Execute the top-k distinct schedules and return the best
+    execute_best_schedules(schedules, topk);
+    
+    // Free the search tree, the search method becomes the owner of the best AST
+    for (mcts_node *node : nodes)
+    {
+        release_ast(node->ast);
+        delete node;
+    }
+    
+    delete root;
+}
+
+int evolutionary_search::get_random_gene()
+{
+    return std::uniform_int_distribution<int>(0, INT_MAX)(rand_generator);
+}
+
+syntax_tree* evolutionary_search::decode(syntax_tree const& ast, std::vector<int> const& genes)
+{
+    syntax_tree *current = ast.copy_ast();
+    std::vector<optimization_type> optims_order = get_optimizations_order();
+    
+    for (int depth = 0; depth < genes.size(); ++depth)
+    {
+        if (depth % optims_order.size() == 0)
+            current->clear_new_optimizations();
             
-            for (syntax_tree *child : children)
+        optimization_type optim_type = optims_order[depth % optims_order.size()];
+        std::vector<syntax_tree*> children = scheds_gen->generate_schedules(*current, optim_type);
+        
+        // The last choice skips the optimization
+        int choice = genes[depth] % (children.size() + 1);
+        
+        for (int i = 0; i < children.size(); ++i)
+        {
+            if (i != choice)
             {
-                child->transform_ast();
-                    
-                child->evaluation = eval_func->evaluate(*child);
-                children_evals.push_back(child->evaluation);
-                
-                nb_explored_schedules++;
+                delete children[i];
+                continue;
             }
             
-            // Add the current AST to the list of children
-            children.push_back(ast_sample->copy_ast());
-            children_evals.push_back(ast_sample->evaluation);
-            
-            // Sample an AST
-            std::discrete_distribution<int> dist(children_evals.begin(), children_evals.end());
-            ast_sample = children[dist(rand_generator)];
-            
-            samples.push_back(ast_sample);
+            children[i]->transform_ast();
+            delete current;
+            current = children[i];
         }
+        
+        current->nb_explored_optims = depth + 1;
+        current->search_depth = depth + 1;
+    }
+    
+    return current;
+}
+
+void evolutionary_search::evaluate_population(syntax_tree const& ast, std::vector<individual>& population)
+{
+    std::vector<syntax_tree*> asts;
+    std::vector<int> indices;
+    
+    auto generation_start = std::chrono::steady_clock::now();
+    
+    for (int i = 0; i < population.size(); ++i)
+    {
+        if (population[i].ast != nullptr)
+            continue;
+            
+        population[i].ast = decode(ast, population[i].genes);
+        
+        asts.push_back(population[i].ast);
+        indices.push_back(i);
     }
     
-    if (samples.empty())
+    generation_time += get_time_since(generation_start);
+    
+    if (asts.empty())
         return ;
+        
+    // Individuals with the same schedule are evaluated only once
+    auto evaluation_start = std::chrono::steady_clock::now();
+    std::vector<float> evals = evaluate_schedules(asts);
+    evaluation_time += get_time_since(evaluation_start);
     
-    // Sort schedules with respect to evaluations
-    std::sort(samples.begin(), samples.end(), [](syntax_tree *a, syntax_tree *b) {
-        return a->evaluation < b->evaluation;
+    for (int i = 0; i < asts.size(); ++i)
+    {
+        individual& indiv = population[indices[i]];
+        
+        indiv.evaluation = evals[i];
+        indiv.ast->evaluation = evals[i];
+        
+        update_best_schedules(indiv);
+    }
+    
+    nb_explored_schedules += asts.size();
+}
+
+evolutionary_search::individual const& evolutionary_search::select_parent(std::vector<individual> const& population)
+{
+    std::uniform_int_distribution<int> dist(0, population.size() - 1);
+    int best = dist(rand_generator);
+    
+    for (int i = 1; i < tournament_size; ++i)
+    {
+        int candidate = dist(rand_generator);
+        if (population[candidate].evaluation < population[best].evaluation)
+            best = candidate;
+    }
+    
+    return population[best];
+}
+
+void evolutionary_search::update_best_schedules(individual const& indiv)
+{
+    // A schedule must be measured to become one of the best schedules
+    if (is_estimated(*indiv.ast))
+        return ;
+        
+    if (best_schedules.size() >= std::max(topk, 1) && indiv.evaluation >= best_schedules.back()->evaluation)
+        return ;
+        
+    uint64_t fingerprint = indiv.ast->get_fingerprint();
+    for (syntax_tree *sched : best_schedules)
+        if (sched->get_fingerprint() == fingerprint)
+            return ;
+            
+    auto it = std::upper_bound(best_schedules.begin(), best_schedules.end(), indiv.evaluation, [](float evaluation, syntax_tree *sched) {
+        return evaluation < sched->evaluation;
     });
     
-    // Execute top-k schedules and return the best
-    for (int i = 0; i < topk; ++i)
+    best_schedules.insert(it, indiv.ast->copy_ast());
+    
+    if (best_schedules.size() > std::max(topk, 1))
+    {
+        delete best_schedules.back();
+        best_schedules.pop_back();
+    }
+}
+
+void evolutionary_search::search(syntax_tree& ast)
+{
+    rand_generator.seed(seed);
+    
+    int genome_length = std::min(max_depth, (int)get_optimizations_order().size());
+    std::uniform_real_distribution<double> probability(0, 1);
+    
+    // Create the initial population randomly
+    std::vector<individual> population(population_size);
+    for (individual& indiv : population)
+        for (int i = 0; i < genome_length; ++i)
+            indiv.genes.push_back(get_random_gene());
+            
+    for (int generation = 0; generation < nb_generations && !budget_exhausted(); ++generation)
     {
-        float exec_time = exec_eval->evaluate(*samples[i]);
-        if (exec_time < best_evaluation)
+        evaluate_population(ast, population);
+        
+        if (generation == nb_generations - 1 || budget_exhausted())
+            break;
+        
+        std::stable_sort(population.begin(), population.end(), [](individual const& a, individual const& b) {
+            return a.evaluation < b.evaluation;
+        });
+        
+        // Keep the elites, and replace the other individuals by children
+        std::vector<individual> next_population;
+        for (int i = 0; i < nb_elites && i < population.size(); ++i)
+            next_population.push_back(population[i]);
+            
+        while (next_population.size() < population_size)
         {
-            best_evaluation = exec_time;
-            best_ast = samples[i];
+            individual const& parent1 = select_parent(population);
+            individual const& parent2 = select_parent(population);
+            
+            // One-point crossover
+            individual child;
+            child.genes = parent1.genes;
+            
+            if (probability(rand_generator) < crossover_rate)
+            {
+                int crossover_point = std::uniform_int_distribution<int>(0, genome_length)(rand_generator);
+                for (int i = crossover_point; i < genome_length; ++i)
+                    child.genes[i] = parent2.genes[i];
+            }
+            
+            for (int& gene : child.genes)
+                if (probability(rand_generator) < mutation_rate)
+                    gene = get_random_gene();
+                    
+            next_population.push_back(child);
         }
+        
+        for (int i = nb_elites; i < population.size(); ++i)
+            delete population[i].ast;
+            
+        population = next_population;
     }
+    
+    for (individual& indiv : population)
+        delete indiv.ast;
+        
+    // Execute the best schedules and return the best
+    execute_best_schedules(best_schedules, topk);
+    
+    for (syntax_tree *sched : best_schedules)
+        release_ast(sched);
+            
+    best_schedules.clear();
 }
 
 // -------------------------------------------------------------------------- //
@@ -147,25 +1096,27 @@ void beam_search_topk::search(syntax_tree& ast)
     beam_search_subroutine(ast);
     
     // Sort schedules found
-    std::sort(schedules.begin(), schedules.end(), [](syntax_tree *a, syntax_tree *b) {
-        return a->evaluation < b->evaluation;
-    });
+    sort_by_evaluation(schedules);
     
     // Execute top-k schedules to find the best
-    for (int i = 0; i < topk; ++i)
-    {
-        float exec_time = exec_eval->evaluate(*schedules[i]);
-        if (exec_time < best_evaluation)
-        {
-            best_evaluation = exec_time;
-            best_ast = schedules[i];
-        }
-    }
+    execute_best_schedules(schedules, topk);
+    
+    // Only keep the best schedule
+    for (syntax_tree *sched : schedules)
+        release_ast(sched);
+        
+    schedules.clear();
 }
     
 void beam_search_topk::beam_search_subroutine(syntax_tree& ast)
 {
-    if (ast.nb_explored_optims % NB_OPTIMIZATIONS == 0)
+    // Stop the search, and keep the best schedule found so far
+    if (budget_exhausted())
+        return ;
+        
+    std::vector<optimization_type> optims_order = get_optimizations_order();
+    
+    if (ast.nb_explored_optims % optims_order.size() == 0)
         ast.clear_new_optimizations();
        
     std::vector<syntax_tree*> children;
@@ -174,9 +1125,11 @@ void beam_search_topk::beam_search_subroutine(syntax_tree& ast)
     int nb_optims_tried = 0;
     int nb_explored_optims = ast.nb_explored_optims;
     
-    while (children.size() == 0 && nb_optims_tried < NB_OPTIMIZATIONS && nb_explored_optims < max_depth)
+    auto generation_start = std::chrono::steady_clock::now();
+    
+    while (children.size() == 0 && nb_optims_tried < optims_order.size() && nb_explored_optims < max_depth)
     {
-        optimization_type optim_type = DEFAULT_OPTIMIZATIONS_ORDER[nb_explored_optims % NB_OPTIMIZATIONS];
+        optimization_type optim_type = optims_order[nb_explored_optims % optims_order.size()];
         children = scheds_gen->generate_schedules(ast, optim_type);
         
         nb_explored_optims++;
@@ -192,11 +1145,23 @@ void beam_search_topk::beam_search_subroutine(syntax_tree& ast)
     {
         child->nb_explored_optims = nb_explored_optims;
         child->transform_ast();
-            
-        child->evaluation = eval_func->evaluate(*child);
-        
-        nb_explored_schedules++;
     }
+    
+    generation_time += get_time_since(generation_start);
+    
+    // Evaluate the most promising children first, and only those that the budget allows
+    prioritize_children(children);
+    if (children.empty())
+        return ;
+    
+    auto evaluation_start = std::chrono::steady_clock::now();
+    std::vector<float> children_evals = evaluate_schedules(children);
+    evaluation_time += get_time_since(evaluation_start);
+    
+    for (int i = 0; i < children.size(); ++i)
+        children[i]->evaluation = children_evals[i];
+        
+    nb_explored_schedules += children.size();
         
     // Add the current AST to the list of children
     syntax_tree *ast_copy = ast.copy_ast();
@@ -204,33 +1169,39 @@ void beam_search_topk::beam_search_subroutine(syntax_tree& ast)
     children.push_back(ast_copy);
 
     // Sort children from smallest evaluation to largest
-    std::sort(children.begin(), children.end(), [](syntax_tree *a, syntax_tree *b) {
-        return a->evaluation < b->evaluation;
-    });
+    sort_by_evaluation(children);
     
-    for (int i = 0; i < beam_size; ++i)
+    // The best children are kept in schedules, the other ones are not needed anymore
+    for (int i = 0; i < beam_size && i < children.size(); ++i)
         schedules.push_back(children[i]);
+        
+    for (int i = beam_size; i < children.size(); ++i)
+        delete children[i];
+        
+    children.resize(std::min(beam_size, (int)children.size()));
     
     // Stop if we reached the maximum depth
     if (nb_explored_optims >= max_depth)
         return ;
 
     // Search recursively on the best children
-    for (int i = beam_size; i < children.size(); ++i)
-        delete children[i];
-        
-    children.resize(std::min(beam_size, (int)children.size()));
 
     for (syntax_tree *child : children)
     {
         child->search_depth = ast.search_depth + 1;        
-        search(*child);
+        beam_search_subroutine(*child);
     }
 }
 
 void beam_search_accuracy_evaluator::search(syntax_tree& ast)
 {
-    if (ast.nb_explored_optims % NB_OPTIMIZATIONS == 0)
+    // Stop the search, and keep the best schedule found so far
+    if (budget_exhausted())
+        return ;
+        
+    std::vector<optimization_type> optims_order = get_optimizations_order();
+    
+    if (ast.nb_explored_optims % optims_order.size() == 0)
         ast.clear_new_optimizations();
        
     std::vector<syntax_tree*> children;
@@ -239,9 +1210,11 @@ void beam_search_accuracy_evaluator::search(syntax_tree& ast)
     int nb_optims_tried = 0;
     int nb_explored_optims = ast.nb_explored_optims;
     
-    while (children.size() == 0 && nb_optims_tried < NB_OPTIMIZATIONS && nb_explored_optims < max_depth)
+    auto generation_start = std::chrono::steady_clock::now();
+    
+    while (children.size() == 0 && nb_optims_tried < optims_order.size() && nb_explored_optims < max_depth)
     {
-        optimization_type optim_type = DEFAULT_OPTIMIZATIONS_ORDER[nb_explored_optims % NB_OPTIMIZATIONS];
+        optimization_type optim_type = optims_order[nb_explored_optims % optims_order.size()];
         children = scheds_gen->generate_schedules(ast, optim_type);
         
         nb_explored_optims++;
@@ -257,25 +1230,44 @@ void beam_search_accuracy_evaluator::search(syntax_tree& ast)
     {
         child->nb_explored_optims = nb_explored_optims;
         child->transform_ast();
-            
-        child->evaluation = eval_func->evaluate(*child);
+    }
+    
+    generation_time += get_time_since(generation_start);
+    
+    // Evaluate the most promising children first, and only those that the budget allows
+    prioritize_children(children);
+    if (children.empty())
+        return ;
+    
+    // We evaluate both by the model and by execution
+    auto evaluation_start = std::chrono::steady_clock::now();
+    std::vector<float> children_evals = evaluate_schedules(children);
+    
+    for (int i = 0; i < children.size(); ++i)
+        children[i]->evaluation = children_evals[i];
         
-        // We evaluate both by the model and by execution
-        model_evals_list.push_back(child->evaluation);
-        exec_evals_list.push_back(exec_eval->evaluate(*child));
+    std::vector<float> children_exec_times = execute_schedules(children);
+    evaluation_time += get_time_since(evaluation_start);
+    
+    for (int i = 0; i < children.size(); ++i)
+    {
+        syntax_tree *child = children[i];
         
-        if (child->evaluation < best_evaluation)
-        {
-            best_evaluation = child->evaluation;
-            best_ast = child;
-        }
+        model_evals_list.push_back(child->evaluation);
+        exec_evals_list.push_back(children_exec_times[i]);
         
+        update_best_ast(child);
         nb_explored_schedules++;
     }
     
     // Stop if we reached the maximum depth
     if (nb_explored_optims >= max_depth)
+    {
+        for (syntax_tree *child : children)
+            release_ast(child);
+            
         return ;
+    }
         
     // Add the current AST to the list of children
     syntax_tree *ast_copy = ast.copy_ast();
@@ -283,21 +1275,114 @@ void beam_search_accuracy_evaluator::search(syntax_tree& ast)
     children.push_back(ast_copy);
 
     // Sort children from smallest evaluation to largest
-    std::sort(children.begin(), children.end(), [](syntax_tree *a, syntax_tree *b) {
-        return a->evaluation < b->evaluation;
-    });
+    sort_by_evaluation(children);
 
     // Search recursively on the best children
     for (int i = beam_size; i < children.size(); ++i)
-        delete children[i];
+        release_ast(children[i]);
         
     children.resize(std::min(beam_size, (int)children.size()));
 
+    // The subtree of a child is not needed anymore once it has been explored
     for (syntax_tree *child : children)
     {
         child->search_depth = ast.search_depth + 1;        
         search(*child);
+        release_ast(child);
+    }
+}
+
+/**
+ * Return the rank of each value of the given list (ties get their average rank).
+ */
+static std::vector<double> get_ranks(std::vector<float> const& values)
+{
+    std::vector<int> indices(values.size());
+    for (int i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+        
+    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
+        return values[a] < values[b];
+    });
+    
+    std::vector<double> ranks(values.size());
+    for (int i = 0; i < indices.size(); )
+    {
+        int j = i;
+        while (j < indices.size() && values[indices[j]] == values[indices[i]])
+            j++;
+            
+        for (int k = i; k < j; ++k)
+            ranks[indices[k]] = (i + j - 1) / 2.0;
+            
+        i = j;
+    }
+    
+    return ranks;
+}
+
+void beam_search_accuracy_evaluator::print_accuracy_report() const
+{
+    std::vector<float> model_evals, exec_evals;
+    
+    for (int i = 0; i < model_evals_list.size(); ++i)
+    {
+        if (exec_evals_list[i] == FLT_MAX)
+            continue;
+            
+        model_evals.push_back(model_evals_list[i]);
+        exec_evals.push_back(exec_evals_list[i]);
+    }
+    
+    int nb_schedules = model_evals.size();
+    std::cout << "Number of schedules : " << nb_schedules << std::endl;
+    
+    if (nb_schedules < 2)
+        return ;
+        
+    // Spearman's rank correlation
+    std::vector<double> model_ranks = get_ranks(model_evals);
+    std::vector<double> exec_ranks = get_ranks(exec_evals);
+    
+    double mean_rank = (nb_schedules - 1) / 2.0;
+    double cov = 0, model_var = 0, exec_var = 0;
+    
+    for (int i = 0; i < nb_schedules; ++i)
+    {
+        cov += (model_ranks[i] - mean_rank) * (exec_ranks[i] - mean_rank);
+        model_var += (model_ranks[i] - mean_rank) * (model_ranks[i] - mean_rank);
+        exec_var += (exec_ranks[i] - mean_rank) * (exec_ranks[i] - mean_rank);
     }
+    
+    double spearman = 0;
+    if (model_var > 0 && exec_var > 0)
+        spearman = cov / std::sqrt(model_var * exec_var);
+        
+    // Pairwise ranking accuracy
+    long nb_pairs = 0, nb_correct_pairs = 0;
+    
+    for (int i = 0; i < nb_schedules; ++i)
+        for (int j = i + 1; j < nb_schedules; ++j)
+        {
+            if (exec_evals[i] == exec_evals[j])
+                continue;
+                
+            nb_pairs++;
+            if ((model_evals[i] < model_evals[j]) == (exec_evals[i] < exec_evals[j]))
+                nb_correct_pairs++;
+        }
+        
+    // Execution time of the schedule chosen by the model
+    int model_best = std::min_element(model_evals.begin(), model_evals.end()) - model_evals.begin();
+    float exec_best = *std::min_element(exec_evals.begin(), exec_evals.end());
+    
+    std::cout << "Spearman rank correlation : " << spearman << std::endl;
+    
+    if (nb_pairs > 0)
+        std::cout << "Pairwise ranking accuracy : " << 100.0 * nb_correct_pairs / nb_pairs << " %" << std::endl;
+        
+    std::cout << "Execution time of the best schedule according to the model : " << exec_evals[model_best]
+              << " (best execution time : " << exec_best << ")" << std::endl;
 }
 
 }
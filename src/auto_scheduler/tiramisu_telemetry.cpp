@@ -0,0 +1,119 @@
+#include <tiramisu/auto_scheduler/telemetry.h>
+#include <tiramisu/profiler.h>
+
+#include <iostream>
+#include <iomanip>
+
+namespace tiramisu::auto_scheduler
+{
+
+/**
+ * Return the given value as a JSON number, or null if it is not known.
+ */
+static std::string get_json_value(float value)
+{
+    if (value == FLT_MAX)
+        return "null";
+
+    return std::to_string(value);
+}
+
+search_telemetry::search_telemetry(std::string const& trace_path, bool append)
+{
+    trace_file = fopen(trace_path.c_str(), append ? "a" : "w");
+    if (trace_file == nullptr)
+        std::cerr << "Can't open the telemetry file " << trace_path << std::endl;
+}
+
+search_telemetry::~search_telemetry()
+{
+    if (trace_file != nullptr)
+        fclose(trace_file);
+}
+
+void search_telemetry::record_candidate(syntax_tree const& ast, double time, float predicted, float measured,
+                                        float ci, bool cached, evaluation_phases const& phases)
+{
+    nb_candidates++;
+    if (cached)
+        nb_cached_candidates++;
+
+    total_phases += phases;
+
+    if (measured < best_measured)
+    {
+        best_measured = measured;
+        best_measured_curve.push_back(std::make_pair(time, measured));
+    }
+
+    if (predicted < best_predicted)
+    {
+        best_predicted = predicted;
+        best_predicted_curve.push_back(std::make_pair(time, predicted));
+    }
+
+    if (trace_file == nullptr)
+        return ;
+
+    std::string optims_json;
+    for (optimization_info const& optim_info : ast.get_schedule())
+    {
+        if (!optims_json.empty())
+            optims_json += ", ";
+
+        optims_json += get_json_string(get_optimization_str(optim_info));
+    }
+
+    fprintf(trace_file, "{\"time\": %lf, \"schedule\": %s, \"optimizations\": [%s], "
+                        "\"predicted\": %s, \"measured\": %s, \"ci\": %f, \"cached\": %s, "
+                        "\"phases\": {\"transform\": %lf, \"prediction\": %lf, \"scheduling\": %lf, "
+                        "\"halide_lowering\": %lf, \"llvm_compile\": %lf, \"link\": %lf, \"execution\": %lf}}\n",
+            time, get_json_string(ast.get_schedule_str()).c_str(), optims_json.c_str(),
+            get_json_value(predicted).c_str(), get_json_value(measured).c_str(), ci, cached ? "true" : "false",
+            phases.transform, phases.prediction, phases.scheduling,
+            phases.halide_lowering, phases.llvm_compile, phases.link, phases.execution);
+
+    // Keep the trace usable if the search is interrupted
+    fflush(trace_file);
+}
+
+void search_telemetry::print_summary() const
+{
+    std::cout << "NB candidates recorded : " << nb_candidates
+              << " (" << nb_cached_candidates << " found in a cache)" << std::endl;
+
+    double total_time = total_phases.get_total();
+    std::vector<std::pair<std::string, double>> phase_times = {
+        {"AST transformation", total_phases.transform},
+        {"Prediction", total_phases.prediction},
+        {"Tiramisu scheduling", total_phases.scheduling},
+        {"Halide lowering", total_phases.halide_lowering},
+        {"LLVM compilation", total_phases.llvm_compile},
+        {"Linking", total_phases.link},
+        {"Execution", total_phases.execution}
+    };
+
+    std::cout << "Time spent by each phase :" << std::endl;
+    for (auto const& phase_time : phase_times)
+    {
+        std::cout << "  " << std::left << std::setw(20) << phase_time.first << " : "
+                  << phase_time.second << " s";
+
+        if (total_time > 0)
+            std::cout << " (" << std::fixed << std::setprecision(1) << 100 * phase_time.second / total_time << " %)"
+                      << std::defaultfloat << std::setprecision(6);
+
+        std::cout << std::endl;
+    }
+
+    // Show the measured values if there are some, they are the ones that matter
+    std::vector<std::pair<double, float>> const& best_curve = best_measured_curve.empty() ? best_predicted_curve : best_measured_curve;
+    if (best_curve.empty())
+        return ;
+
+    std::cout << "Best " << (best_measured_curve.empty() ? "predicted" : "measured") << " value against wall-clock time :" << std::endl;
+    for (auto const& point : best_curve)
+        std::cout << "  " << point.first << " s : " << point.second << std::endl;
+}
+
+}
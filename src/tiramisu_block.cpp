@@ -207,5 +207,11 @@ void block::vectorize(var L, int v, var L_outer, var L_inner) {
     }
 }
 
+void block::vectorize(int L, int v) {
+    for (auto &child : this->children) {
+        child->vectorize(L, v);
+    }
+}
+
 
 }  // namespace tiramisu
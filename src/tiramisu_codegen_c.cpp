@@ -20,7 +20,16 @@ void tiramisu::function::gen_c_code() const
     isl_printer *p;
     p = isl_printer_to_file(this->get_isl_ctx(), stdout);
     p = isl_printer_set_output_format(p, ISL_FORMAT_C);
-    p = isl_printer_print_ast_node(p, this->get_isl_ast());
+
+    if (this->is_incremental_codegen_set())
+    {
+        // Print the root-level loop nests one after the other
+        for (auto const &fingerprint : this->codegen_groups)
+            p = isl_printer_print_ast_node(p, this->codegen_groups_cache.at(fingerprint).ast);
+    }
+    else
+        p = isl_printer_print_ast_node(p, this->get_isl_ast());
+
     isl_printer_free(p);
     tiramisu::str_dump("\n\n");
 }
@@ -19,6 +19,7 @@
 #include <tiramisu/type.h>
 #include <tiramisu/expr.h>
 #include <tiramisu/utils.h>
+#include <tiramisu/profiler.h>
 
 #include <string>
 #include <array>
@@ -714,6 +715,11 @@ cuda_ast::statement_ptr cuda_ast::generator::cuda_stmt_handle_isl_if(isl_ast_nod
         DEBUG_FCT_NAME(3);
         DEBUG_INDENT(4);
 
+        compile_time_scope phase_scope("gen_cuda_stmt");
+
+        if (this->is_incremental_codegen_set())
+            ERROR("gen_cuda_stmt() does not support incremental code generation, see set_incremental_codegen().", true);
+
         DEBUG(3, this->gen_c_code());
 
         cuda_ast::generator generator{*this};
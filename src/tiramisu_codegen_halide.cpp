@@ -13,6 +13,8 @@
 #include <tiramisu/core.h>
 #include <tiramisu/type.h>
 #include <tiramisu/expr.h>
+#include <tiramisu/profiler.h>
+#include <tiramisu/object_cache.h>
 
 #include <string>
 #include "../include/tiramisu/expr.h"
@@ -1312,6 +1314,8 @@ isl_ast_node *generator::stmt_code_generator(isl_ast_node *node, isl_ast_build *
 
     for (auto comp: filtered_comp_vec)
     {
+        compile_time_scope comp_scope(comp->get_name(), "computation");
+
         // Mark "comp" as the computation associated with this node.
         isl_id *annotation_id = isl_id_alloc(func->get_isl_ctx(), "", (void *)comp);
         node = isl_ast_node_set_annotation(node, annotation_id);
@@ -2280,6 +2284,8 @@ tiramisu::generator::halide_stmt_from_isl_node(const tiramisu::function &fct, is
             DEBUG(3, tiramisu::str_dump("Computation name: "); tiramisu::str_dump(computation_name));
             isl_id_free(id);
 
+            compile_time_scope comp_scope(computation_name, "computation");
+
             // Check if any loop around this statement should be
             // parallelized, vectorized or mapped to GPU.
             for (int l = 0; l < level; l++)
@@ -2426,6 +2432,8 @@ void function::gen_halide_stmt()
     DEBUG_FCT_NAME(3);
     DEBUG_INDENT(4);
 
+    compile_time_scope phase_scope("gen_halide_stmt");
+
     DEBUG(3, this->gen_c_code());
 
     Halide::Internal::set_always_upcast();
@@ -2436,8 +2444,37 @@ void function::gen_halide_stmt()
     std::vector<std::pair<std::string, std::string>> generated_stmts;
     Halide::Internal::Stmt stmt;
 
-    // Generate the statement that represents the whole function
-    stmt = tiramisu::generator::halide_stmt_from_isl_node(*this, this->get_isl_ast(), 0, generated_stmts, false);
+    if (this->is_incremental_codegen_set())
+    {
+        // Generate the loop nests that were not generated before, and
+        // reuse the others.
+        for (int i = this->codegen_groups.size() - 1; i >= 0; i--)
+        {
+            codegen_group &group = this->codegen_groups_cache.at(this->codegen_groups[i]);
+
+            if (!group.stmt.defined())
+            {
+                std::vector<std::pair<std::string, std::string>> group_generated_stmts;
+                group.stmt = tiramisu::generator::halide_stmt_from_isl_node(*this, group.ast, 0, group_generated_stmts, false);
+            }
+
+            if (!group.stmt.defined())
+                continue;
+
+            if (stmt.defined())
+                stmt = Halide::Internal::Block::make(group.stmt, stmt);
+            else
+                stmt = group.stmt;
+        }
+
+        if (!stmt.defined())
+            stmt = Halide::Internal::Evaluate::make(0);
+    }
+    else
+    {
+        // Generate the statement that represents the whole function
+        stmt = tiramisu::generator::halide_stmt_from_isl_node(*this, this->get_isl_ast(), 0, generated_stmts, false);
+    }
 
     DEBUG(3, tiramisu::str_dump("The following Halide statement was generated:\n"); std::cout << stmt << std::endl);
 
@@ -3931,6 +3968,8 @@ Halide::Expr generator::halide_expr_from_tiramisu_expr(const tiramisu::function
 void function::gen_halide_obj(const std::string &obj_file_name, Halide::Target::OS os,
                               Halide::Target::Arch arch, int bits, const tiramisu::hardware_architecture_t hw_architecture) const
 {
+    compile_time_scope phase_scope("gen_halide_obj");
+
     // TODO(tiramisu): For GPU schedule, we need to set the features, e.g.
     // Halide::Target::OpenCL, etc.
     // Note: "make test" fails on Travis machines when AVX2 is used.
@@ -3964,12 +4003,17 @@ void function::gen_halide_obj(const std::string &obj_file_name, Halide::Target::
                                              Halide::Internal::LoweredFunc::External,
                                              this->get_halide_stmt());
 
-    m.compile(Halide::Outputs().object(obj_file_name));
+    // Copy the object file from the cache if the module was compiled before
+    compile_time_scope step_scope("llvm_compile");
+    object_cache::compile(m, obj_file_name);
+
+    step_scope.next("c_header");
     m.compile(Halide::Outputs().c_header(obj_file_name + ".h"));
     if (hw_architecture == tiramisu::hardware_architecture_t::arch_flexnlp)
         m.compile(Halide::Outputs().c_source(obj_file_name + "_generated.c"));
 
     if (nvcc_compiler) {
+        step_scope.next("nvcc_compile");
         nvcc_compiler->compile(obj_file_name);
     }
 }
@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include <tiramisu/debug.h>
+#include <tiramisu/profiler.h>
 #include <Halide.h>
 
 using namespace Halide;
@@ -32,6 +33,8 @@ Module lower_halide_pipeline(const string &pipeline_name,
                              const Internal::LoweredFunc::LinkageType linkage_type,
                              Stmt s)
 {
+    compile_time_scope phase_scope("lower_halide_pipeline");
+
     Module result_module(pipeline_name, t);
 
     // TODO(tiramisu): Compute the env (function DAG). This is needed for
@@ -45,10 +48,12 @@ Module lower_halide_pipeline(const string &pipeline_name,
     }
 
     DEBUG(3, tiramisu::str_dump("Performing sliding window optimization...\n"));
+    compile_time_scope pass_scope("sliding_window", "halide_pass");
     s = sliding_window(s, env);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after sliding window:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Removing code that depends on undef values...\n"));
+    pass_scope.next("remove_undef");
     s = remove_undef(s);
     DEBUG(4, tiramisu::str_dump(
               stmt_to_string("Lowering after removing code that depends on undef values:\n", s)));
@@ -57,18 +62,22 @@ Module lower_halide_pipeline(const string &pipeline_name,
     // after this point. This lets later passes assume syntactic
     // equivalence means semantic equivalence.
     DEBUG(3, tiramisu::str_dump("Uniquifying variable names...\n"));
+    pass_scope.next("uniquify_variable_names");
     s = uniquify_variable_names(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after uniquifying variable names:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Simplifying...\n")); // without removing dead lets, because storage flattening needs the strides
+    pass_scope.next("simplify");
     s = simplify(s, false);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after simplification:\n", s)));
     
     DEBUG(3, tiramisu::str_dump("Performing storage folding optimization...\n"));
+    pass_scope.next("storage_folding");
     s = storage_folding(s, env);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after storage folding:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Simplifying...\n")); // without removing dead lets, because storage flattening needs the strides
+    pass_scope.next("simplify");
     s = simplify(s, false);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after simplification:\n", s)));
 
@@ -77,6 +86,7 @@ Module lower_halide_pipeline(const string &pipeline_name,
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after injecting prefetches:\n", s)));
 */
     DEBUG(3, tiramisu::str_dump("Destructuring tuple-valued realizations...\n"));
+    pass_scope.next("split_tuples");
     s = split_tuples(s, env);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after destructuring tuple-valued realizations:\n", s)));
     DEBUG(3, tiramisu::str_dump("\n\n"));
@@ -84,6 +94,7 @@ Module lower_halide_pipeline(const string &pipeline_name,
     // TODO(tiramisu): This pass is important to figure out all the buffer symbols.
     // Maybe we should put it somewhere else instead of here.
     DEBUG(3, tiramisu::str_dump("Unpacking buffer arguments...\n"));
+    pass_scope.next("unpack_buffers");
     s = unpack_buffers(s);
     DEBUG(0, tiramisu::str_dump(stmt_to_string("Lowering after unpacking buffer arguments:\n", s)));
 
@@ -92,10 +103,12 @@ Module lower_halide_pipeline(const string &pipeline_name,
         t.has_feature(Target::OpenGL) ||
         (t.arch != Target::Hexagon && (t.features_any_of({Target::HVX_64, Target::HVX_128})))) {
         DEBUG(3, tiramisu::str_dump("Selecting a GPU API for GPU loops...\n"));
+        pass_scope.next("select_gpu_api");
         s = select_gpu_api(s, t);
         DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after selecting a GPU API:\n", s)));
 
         DEBUG(3, tiramisu::str_dump("Injecting host <-> dev buffer copies...\n"));
+        pass_scope.next("inject_host_dev_buffer_copies");
         s = inject_host_dev_buffer_copies(s, t);
         DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after injecting host <-> dev buffer copies:\n",
                                     s)));
@@ -104,6 +117,7 @@ Module lower_halide_pipeline(const string &pipeline_name,
     if (t.has_feature(Target::OpenGL))
     {
         DEBUG(3, tiramisu::str_dump("Injecting OpenGL texture intrinsics...\n"));
+        pass_scope.next("inject_opengl_intrinsics");
         s = inject_opengl_intrinsics(s);
         DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after OpenGL intrinsics:\n", s)));
     }
@@ -112,14 +126,18 @@ Module lower_halide_pipeline(const string &pipeline_name,
             t.has_feature(Target::OpenGLCompute))
     {
         DEBUG(3, tiramisu::str_dump("Injecting per-block gpu synchronization...\n"));
+        pass_scope.next("fuse_gpu_thread_loops");
         s = fuse_gpu_thread_loops(s);
         DEBUG(4, tiramisu::str_dump(
                   stmt_to_string("Lowering after injecting per-block gpu synchronization:\n", s)));
     }
 
     DEBUG(3, tiramisu::str_dump("Simplifying...\n"));
+    pass_scope.next("simplify");
     s = simplify(s);
+    pass_scope.next("unify_duplicate_lets");
     s = unify_duplicate_lets(s);
+    pass_scope.next("remove_trivial_for_loops");
     s = remove_trivial_for_loops(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after second simplifcation:\n", s)));
 
@@ -131,26 +149,35 @@ Module lower_halide_pipeline(const string &pipeline_name,
 
 
     DEBUG(3, tiramisu::str_dump("Reduce prefetch dimension...\n"));
+    pass_scope.next("reduce_prefetch_dimension");
     s = reduce_prefetch_dimension(s, t);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after reduce prefetch dimension:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Unrolling...\n"));
+    pass_scope.next("unroll_loops");
     s = unroll_loops(s);
+    pass_scope.next("simplify");
     s = simplify(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after unrolling:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Vectorizing...\n"));
+    pass_scope.next("vectorize_loops");
     s = vectorize_loops(s, t);
+    pass_scope.next("simplify");
     s = simplify(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after vectorizing:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Detecting vector interleavings...\n"));
+    pass_scope.next("rewrite_interleavings");
     s = rewrite_interleavings(s);
+    pass_scope.next("simplify");
     s = simplify(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after rewriting vector interleavings:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Partitioning loops to simplify boundary conditions...\n"));
+    pass_scope.next("partition_loops");
     s = partition_loops(s);
+    pass_scope.next("simplify");
     s = simplify(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after partitioning loops:\n", s)));
 
@@ -159,32 +186,40 @@ Module lower_halide_pipeline(const string &pipeline_name,
     //DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after loop trimming:\n", s)));
 
     DEBUG(3, tiramisu::str_dump("Injecting early frees...\n"));
+    pass_scope.next("inject_early_frees");
     s = inject_early_frees(s);
     DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after injecting early frees:\n", s)));
 
     if (t.has_feature(Target::FuzzFloatStores))
     {
         DEBUG(3, tiramisu::str_dump("Fuzzing floating point stores...\n"));
+        pass_scope.next("fuzz_float_stores");
         s = fuzz_float_stores(s);
         DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after fuzzing floating point stores:\n", s)));
     }
 
     DEBUG(3, tiramisu::str_dump("Simplifying...\n"));
+    pass_scope.next("common_subexpression_elimination");
     s = common_subexpression_elimination(s);
 
     if (t.has_feature(Target::OpenGL))
     {
         DEBUG(3, tiramisu::str_dump("Detecting varying attributes...\n"));
+        pass_scope.next("find_linear_expressions");
         s = find_linear_expressions(s);
         DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after detecting varying attributes:\n", s)));
 
         DEBUG(3, tiramisu::str_dump("Moving varying attribute expressions out of the shader...\n"));
+        pass_scope.next("setup_gpu_vertex_buffer");
         s = setup_gpu_vertex_buffer(s);
         DEBUG(4, tiramisu::str_dump(stmt_to_string("Lowering after removing varying attributes:\n", s)));
     }
 
+    pass_scope.next("remove_dead_allocations");
     s = remove_dead_allocations(s);
+    pass_scope.next("remove_trivial_for_loops");
     s = remove_trivial_for_loops(s);
+    pass_scope.next("simplify");
     s = simplify(s);
     // s = loop_invariant_code_motion(s);
     if (ENABLE_DEBUG)
@@ -223,8 +258,10 @@ Module lower_halide_pipeline(const string &pipeline_name,
             }
         }
     };
+    pass_scope.next("strengthen_refs");
     s = StrengthenRefs().mutate(s);
 
+    pass_scope.next("make_module");
     LoweredFunc main_func(pipeline_name, public_args, s, linkage_type);
 
     result_module.append(main_func);
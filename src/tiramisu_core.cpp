@@ -28,6 +28,9 @@ static int next_dim_name = 0;
 bool global::auto_data_mapping = false;
 primitive_t global::loop_iterator_type = p_int32;
 function *global::implicit_fct;
+bool global::compile_time_profiling = false;
+std::string global::compile_time_trace_path;
+std::string global::object_cache_directory;
 std::unordered_map<std::string, var> var::declared_vars;
 const var computation::root = var("root");
 
@@ -94,11 +97,11 @@ void codegen(const std::vector<tiramisu::buffer *> &arguments, const std::string
 }
 
 
-void codegen_select_schedule_number(int schedule_number,
+void codegen_select_schedule_number(std::string const& path_name, int schedule_number,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt )
                       {
                             function *fct = global::get_implicit_function();
-                             fct->codegen_select_schedule_number(schedule_number,arguments, obj_filename, gen_cuda_stmt);
+                             fct->codegen_select_schedule_number(path_name, schedule_number, arguments, obj_filename, gen_cuda_stmt);
                       }
 
 void codegen_write_potential_schedules(std::string& path_name,
@@ -2160,6 +2163,29 @@ void tiramisu::computation::vectorize(tiramisu::var L0_var, int v, tiramisu::var
     DEBUG_INDENT(-4);
 }
 
+void tiramisu::computation::vectorize(int L0, int v)
+{
+    DEBUG_FCT_NAME(3);
+    DEBUG_INDENT(4);
+    
+    bool split_happened = this->separateAndSplit(L0, v);
+
+    if (split_happened)
+    {
+        // Tag the inner loop after splitting to be vectorized. That loop
+        // is supposed to have a constant extent.
+        this->get_update(0).tag_vector_level(L0 + 1, v);
+    }
+    else
+    {
+        this->get_update(0).tag_vector_level(L0, v);
+    }
+
+    this->get_function()->align_schedules();
+    
+    DEBUG_INDENT(-4);
+}
+
 tiramisu::computation& computation::get_last_update()
 {
     return this->get_update(this->get_updates().size()-1);
@@ -7773,6 +7799,23 @@ void tiramisu::computation::gen_time_space_domain()
 
     DEBUG(3, tiramisu::str_dump("Iteration domain:", isl_set_to_str(this->get_iteration_domain())));
 
+    isl_set *context = this->get_function()->get_program_context();
+
+    // With incremental code generation, keep the time-processor domain
+    // if it was computed from the same schedule, domain and context.
+    if (this->get_function()->is_incremental_codegen_set() && (time_processor_domain != NULL) &&
+        (time_processor_domain_schedule != NULL) &&
+        (isl_map_plain_is_equal(this->get_schedule(), time_processor_domain_schedule) == isl_bool_true) &&
+        (isl_set_plain_is_equal(this->get_iteration_domain(), time_processor_domain_iteration_domain) == isl_bool_true) &&
+        (((context == NULL) && (time_processor_domain_context == NULL)) ||
+         ((context != NULL) && (time_processor_domain_context != NULL) &&
+          (isl_set_plain_is_equal(context, time_processor_domain_context) == isl_bool_true))))
+    {
+        DEBUG(3, tiramisu::str_dump("The schedule did not change, keeping the time-space domain."));
+        DEBUG_INDENT(-4);
+        return;
+    }
+
     isl_set *iter = isl_set_copy(this->get_iteration_domain());
     iter = this->intersect_set_with_context(iter);
 
@@ -7785,6 +7828,23 @@ void tiramisu::computation::gen_time_space_domain()
     DEBUG(3, tiramisu::str_dump("Schedule:", isl_map_to_str(this->get_schedule())));
     DEBUG(3, tiramisu::str_dump("Generated time-space domain:", isl_set_to_str(time_processor_domain)));
 
+    // Without incremental code generation, forget the previous copies, so that they
+    // are not compared to the schedule if incremental code generation is enabled again.
+    isl_map_free(time_processor_domain_schedule);
+    isl_set_free(time_processor_domain_iteration_domain);
+    isl_set_free(time_processor_domain_context);
+
+    time_processor_domain_schedule = NULL;
+    time_processor_domain_iteration_domain = NULL;
+    time_processor_domain_context = NULL;
+
+    if (this->get_function()->is_incremental_codegen_set())
+    {
+        time_processor_domain_schedule = isl_map_copy(this->get_schedule());
+        time_processor_domain_iteration_domain = isl_set_copy(this->get_iteration_domain());
+        time_processor_domain_context = isl_set_copy(context);
+    }
+
     DEBUG_INDENT(-4);
 }
 
@@ -11,8 +11,12 @@
 
 #include <tiramisu/debug.h>
 #include <tiramisu/core.h>
+#include <tiramisu/profiler.h>
 
 #include <fstream>
+#include <sstream>
+#include <set>
+#include <algorithm>
 
 #include <iostream>
 
@@ -26,6 +30,11 @@ namespace tiramisu
 isl_ast_node *for_code_generator_after_for(
         isl_ast_node *node, isl_ast_build *build, void *user);
 
+/**
+  * Maximal number of root-level loop nests kept by incremental code generation.
+  */
+#define MAX_CACHED_CODEGEN_GROUPS 512
+
 isl_map *isl_map_align_range_dims(isl_map *map, int max_dim)
 {
     DEBUG_FCT_NAME(10);
@@ -1433,20 +1442,54 @@ void function::gen_isl_ast()
     DEBUG_FCT_NAME(3);
     DEBUG_INDENT(4);
 
+    compile_time_scope phase_scope("gen_isl_ast");
+
     // Check that time_processor representation has already been computed,
     assert(this->get_trimmed_time_processor_domain() != NULL);
     assert(this->get_aligned_identity_schedules() != NULL);
 
-    isl_ctx *ctx = this->get_isl_ctx();
-    assert(ctx != NULL);
-    isl_ast_build *ast_build;
-
     // Rename updates so that they have different names because
     // the code generator expects each unique name to have
     // an expression, different computations that have the same
     // name cannot have different expressions.
     this->rename_computations();
 
+    if (this->is_incremental_codegen_set())
+    {
+        this->gen_isl_ast_incrementally();
+
+        DEBUG_INDENT(-4);
+        return;
+    }
+
+    // Intersect the iteration domain with the domain of the schedule.
+    isl_union_map *umap =
+        isl_union_map_intersect_domain(
+            isl_union_map_copy(this->get_aligned_identity_schedules()),
+            isl_union_set_copy(this->get_trimmed_time_processor_domain()));
+
+    DEBUG(3, tiramisu::str_dump("Schedule:", isl_union_map_to_str(this->get_schedule())));
+    DEBUG(3, tiramisu::str_dump("Iteration domain:",
+                                isl_union_set_to_str(this->get_iteration_domain())));
+    DEBUG(3, tiramisu::str_dump("Trimmed Time-Processor domain:",
+                                isl_union_set_to_str(this->get_trimmed_time_processor_domain())));
+    DEBUG(3, tiramisu::str_dump("Trimmed Time-Processor aligned identity schedule:",
+                                isl_union_map_to_str(this->get_aligned_identity_schedules())));
+    DEBUG(3, tiramisu::str_dump("Identity schedule intersect trimmed Time-Processor domain:",
+                                isl_union_map_to_str(umap)));
+    DEBUG(3, tiramisu::str_dump("\n"));
+
+    this->ast = this->gen_isl_ast_from_schedule(umap);
+
+    DEBUG_INDENT(-4);
+}
+
+isl_ast_node *function::gen_isl_ast_from_schedule(isl_union_map *umap)
+{
+    isl_ctx *ctx = this->get_isl_ctx();
+    assert(ctx != NULL);
+    isl_ast_build *ast_build;
+
     if (this->get_program_context() == NULL)
     {
         ast_build = isl_ast_build_alloc(ctx);
@@ -1487,26 +1530,268 @@ void function::gen_isl_ast()
         ast_build = isl_ast_build_set_iterators(ast_build, iterators);
     }
 
-    // Intersect the iteration domain with the domain of the schedule.
-    isl_union_map *umap =
-        isl_union_map_intersect_domain(
-            isl_union_map_copy(this->get_aligned_identity_schedules()),
-            isl_union_set_copy(this->get_trimmed_time_processor_domain()));
+    isl_ast_node *node = isl_ast_build_node_from_schedule_map(ast_build, umap);
 
-    DEBUG(3, tiramisu::str_dump("Schedule:", isl_union_map_to_str(this->get_schedule())));
-    DEBUG(3, tiramisu::str_dump("Iteration domain:",
-                                isl_union_set_to_str(this->get_iteration_domain())));
-    DEBUG(3, tiramisu::str_dump("Trimmed Time-Processor domain:",
-                                isl_union_set_to_str(this->get_trimmed_time_processor_domain())));
-    DEBUG(3, tiramisu::str_dump("Trimmed Time-Processor aligned identity schedule:",
-                                isl_union_map_to_str(this->get_aligned_identity_schedules())));
-    DEBUG(3, tiramisu::str_dump("Identity schedule intersect trimmed Time-Processor domain:",
-                                isl_union_map_to_str(umap)));
-    DEBUG(3, tiramisu::str_dump("\n"));
+    isl_ast_build_free(ast_build);
+
+    return node;
+}
 
-    this->ast = isl_ast_build_node_from_schedule_map(ast_build, umap);
+/**
+  * Return the string \p str allocated by isl, and free it.
+  */
+static std::string get_isl_str(char *str)
+{
+    if (str == NULL)
+        return "";
 
-    isl_ast_build_free(ast_build);
+    std::string result(str);
+    free(str);
+
+    return result;
+}
+
+std::string function::get_codegen_base_fingerprint() const
+{
+    std::string fingerprint;
+
+    if (this->get_program_context() != NULL)
+        fingerprint += get_isl_str(isl_set_to_str(this->get_program_context()));
+    fingerprint += ";";
+
+    for (auto const &iterator_name : this->get_iterator_names())
+        fingerprint += iterator_name + ",";
+    fingerprint += ";" + std::to_string(global::get_loop_iterator_data_type()) + ";";
+
+    for (auto const &invariant : this->get_invariants())
+        fingerprint += invariant.get_name() + "=" + invariant.get_expr().to_str() + ";";
+
+    for (auto const &b : this->get_buffers())
+    {
+        tiramisu::buffer *buf = b.second;
+
+        fingerprint += buf->get_name() + ":" + std::to_string(buf->get_elements_type()) + ":" +
+                       std::to_string(buf->get_argument_type()) + ":" + std::to_string(buf->get_auto_allocate()) + ":" +
+                       std::to_string((int)buf->location);
+
+        for (auto const &size : buf->get_dim_sizes())
+            fingerprint += ":" + size.to_str();
+
+        fingerprint += ";";
+    }
+
+    // A computation accesses the buffers of the computations it reads
+    // through their access relations.
+    for (auto const &comp : this->get_computations())
+    {
+        fingerprint += comp->get_name() + "->";
+        if (comp->get_access_relation() != NULL)
+            fingerprint += get_isl_str(isl_map_to_str(comp->get_access_relation()));
+        fingerprint += ";";
+    }
+
+    return fingerprint;
+}
+
+std::string function::get_codegen_fingerprint(computation *comp) const
+{
+    std::string name = comp->get_name();
+    std::string fingerprint = name + ":" + comp->get_expr().to_str() + ":" + comp->get_predicate().to_str() + ":";
+
+    for (auto const &arg : comp->library_call_args)
+        fingerprint += arg.to_str() + ",";
+
+    isl_set *tp_domain = comp->get_trimmed_time_processor_domain();
+    fingerprint += ":" + get_isl_str(isl_set_to_str(tp_domain));
+    isl_set_free(tp_domain);
+
+    for (auto const &dim : this->parallel_dimensions)
+        if (dim.first == name)
+            fingerprint += ":parallel " + std::to_string(dim.second);
+
+    for (auto const &dim : this->vector_dimensions)
+        if (std::get<0>(dim) == name)
+            fingerprint += ":vector " + std::to_string(std::get<1>(dim)) + " " + std::to_string(std::get<2>(dim));
+
+    for (auto const &dim : this->unroll_dimensions)
+        if (std::get<0>(dim) == name)
+            fingerprint += ":unroll " + std::to_string(std::get<1>(dim)) + " " + std::to_string(std::get<2>(dim));
+
+    for (auto const &dim : this->distributed_dimensions)
+        if (dim.first == name)
+            fingerprint += ":distributed " + std::to_string(dim.second);
+
+    for (auto const &dim : this->gpu_block_dimensions)
+        if (dim.first == name)
+            fingerprint += ":gpu_block " + std::to_string(std::get<0>(dim.second)) + " " +
+                           std::to_string(std::get<1>(dim.second)) + " " + std::to_string(std::get<2>(dim.second));
+
+    for (auto const &dim : this->gpu_thread_dimensions)
+        if (dim.first == name)
+            fingerprint += ":gpu_thread " + std::to_string(std::get<0>(dim.second)) + " " +
+                           std::to_string(std::get<1>(dim.second)) + " " + std::to_string(std::get<2>(dim.second));
+
+    return fingerprint + ";";
+}
+
+std::vector<std::vector<computation *>> function::get_root_level_groups() const
+{
+    std::vector<computation *> scheduled_comps;
+    for (auto const &comp : this->body)
+        if (comp->should_schedule_this_computation())
+            scheduled_comps.push_back(comp);
+
+    // GPU mappings are generated from the AST of the whole function
+    bool can_split = this->gpu_block_dimensions.empty() && this->gpu_thread_dimensions.empty();
+    std::map<long, std::vector<computation *>> groups;
+
+    for (auto const &comp : scheduled_comps)
+    {
+        if (!can_split)
+            break;
+
+        // The code generator puts these computations around the whole
+        // root-level block, not in a single loop nest.
+        tiramisu::op_t op_type = comp->get_expr().get_op_type();
+        if (comp->is_let_stmt() || op_type == o_allocate || op_type == o_free || op_type == o_memcpy)
+        {
+            can_split = false;
+            break;
+        }
+
+        isl_set *tp_domain = comp->get_trimmed_time_processor_domain();
+        isl_val *root_order = NULL;
+
+        if (isl_set_dim(tp_domain, isl_dim_set) > 0)
+            root_order = isl_set_plain_get_val_if_fixed(tp_domain, isl_dim_set, 0);
+
+        if ((root_order == NULL) || (isl_val_is_int(root_order) != isl_bool_true))
+            can_split = false;
+        else
+            groups[isl_val_get_num_si(root_order)].push_back(comp);
+
+        isl_val_free(root_order);
+        isl_set_free(tp_domain);
+    }
+
+    std::vector<std::vector<computation *>> result;
+
+    if (!can_split)
+    {
+        if (!scheduled_comps.empty())
+            result.push_back(scheduled_comps);
+
+        return result;
+    }
+
+    for (auto const &group : groups)
+        result.push_back(group.second);
+
+    return result;
+}
+
+void function::gen_isl_ast_incrementally()
+{
+    DEBUG_FCT_NAME(3);
+    DEBUG_INDENT(4);
+
+    // The loop nests generated for other buffers, invariants or
+    // access relations can't be reused.
+    std::string base_fingerprint = this->get_codegen_base_fingerprint();
+    if (base_fingerprint != this->codegen_groups_cache_base)
+    {
+        for (auto &cached_group : this->codegen_groups_cache)
+            isl_ast_node_free(cached_group.second.ast);
+
+        this->codegen_groups_cache.clear();
+        this->codegen_groups_cache_base = base_fingerprint;
+    }
+
+    this->codegen_groups.clear();
+
+    if (this->ast != NULL)
+    {
+        isl_ast_node_free(this->ast);
+        this->ast = NULL;
+    }
+
+    for (auto const &group : this->get_root_level_groups())
+    {
+        std::string fingerprint;
+        for (auto const &comp : group)
+            fingerprint += this->get_codegen_fingerprint(comp);
+
+        this->codegen_groups.push_back(fingerprint);
+
+        // A loop nest can only be reused once its Halide statement is generated,
+        // since generating it uses the accesses computed while building its AST.
+        auto cached_group = this->codegen_groups_cache.find(fingerprint);
+        if (cached_group != this->codegen_groups_cache.end())
+        {
+            if (cached_group->second.stmt.defined())
+            {
+                DEBUG(3, tiramisu::str_dump("Reusing the loop nest of the computation " + group[0]->get_name()));
+                continue;
+            }
+
+            isl_ast_node_free(cached_group->second.ast);
+            this->codegen_groups_cache.erase(cached_group);
+        }
+
+        DEBUG(3, tiramisu::str_dump("Generating the loop nest of the computation " + group[0]->get_name()));
+
+        std::vector<isl_map *> identity_schedules;
+        int max_dim = 0;
+
+        for (auto const &comp : group)
+        {
+            isl_map *sched = comp->gen_identity_schedule_for_time_space_domain();
+            assert((sched != NULL) && "Identity schedule could not be computed");
+            max_dim = std::max(max_dim, (int)isl_map_dim(sched, isl_dim_out));
+            identity_schedules.push_back(sched);
+        }
+
+        // Intersect the iteration domain of the loop nest with its schedule.
+        isl_union_map *umap = NULL;
+        isl_union_set *tp_domain = NULL;
+
+        for (int i = 0; i < group.size(); i++)
+        {
+            isl_union_map *sched = isl_union_map_from_map(isl_map_align_range_dims(identity_schedules[i], max_dim));
+            isl_union_set *comp_tp_domain = isl_union_set_from_set(group[i]->get_trimmed_time_processor_domain());
+
+            umap = (umap == NULL) ? sched : isl_union_map_union(umap, sched);
+            tp_domain = (tp_domain == NULL) ? comp_tp_domain : isl_union_set_union(tp_domain, comp_tp_domain);
+        }
+
+        umap = isl_union_map_intersect_domain(umap, tp_domain);
+
+        DEBUG(3, tiramisu::str_dump("Identity schedule intersect trimmed Time-Processor domain:",
+                                    isl_union_map_to_str(umap)));
+
+        codegen_group new_group;
+        new_group.ast = this->gen_isl_ast_from_schedule(umap);
+        this->codegen_groups_cache[fingerprint] = new_group;
+    }
+
+    // Only keep the loop nests of the last schedules
+    if (this->codegen_groups_cache.size() > MAX_CACHED_CODEGEN_GROUPS)
+    {
+        std::unordered_set<std::string> used_groups(this->codegen_groups.begin(), this->codegen_groups.end());
+
+        for (auto it = this->codegen_groups_cache.begin(); it != this->codegen_groups_cache.end(); )
+        {
+            if (used_groups.find(it->first) == used_groups.end())
+            {
+                isl_ast_node_free(it->second.ast);
+                it = this->codegen_groups_cache.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    DEBUG(3, tiramisu::str_dump("Number of root-level loop nests: " + std::to_string(this->codegen_groups.size())));
 
     DEBUG_INDENT(-4);
 }
@@ -2224,6 +2509,8 @@ isl_union_map *tiramisu::function::get_trimmed_schedule() const
 }
 
 void tiramisu::function::lift_dist_comps() {
+    compile_time_scope phase_scope("lift_dist_comps");
+
     for (std::vector<tiramisu::computation *>::iterator comp = body.begin(); comp != body.end(); comp++) {
         if ((*comp)->is_send() || (*comp)->is_recv() || (*comp)->is_wait() || (*comp)->is_send_recv()) {
             xfer_prop chan = static_cast<tiramisu::communicator *>(*comp)->get_xfer_props();
@@ -2350,13 +2637,19 @@ void function::gen_time_space_domain()
     DEBUG_FCT_NAME(3);
     DEBUG_INDENT(4);
 
+    compile_time_scope phase_scope("gen_time_space_domain");
+    compile_time_scope step_scope("gen_ordering_schedules");
+
     // Generate the ordering based on calls to .after() and .before().
     this->gen_ordering_schedules();
 
+    step_scope.next("align_schedules");
     this->align_schedules();
 
+    step_scope.next("computations_time_space_domain");
     for (auto &comp : this->get_computations())
     {
+        compile_time_scope comp_scope(comp->get_name(), "computation");
         comp->gen_time_space_domain();
     }
 
@@ -2590,6 +2883,8 @@ void tiramisu::function::gen_halide_bug_workaround_computations(){
 
 void tiramisu::function::codegen(const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt)
 {
+    compile_time_profiler::start(this->get_name());
+
     if (gen_cuda_stmt)
     {
         if(!this->mapping.empty())
@@ -2610,31 +2905,345 @@ void tiramisu::function::codegen(const std::vector<tiramisu::buffer *> &argument
     }
     this->gen_halide_stmt();
     this->gen_halide_obj(obj_filename);
+
+    compile_time_profiler::stop();
 }
 
 
-void tiramisu::function::codegen_select_schedule_number(int schedule_number,
+void tiramisu::function::codegen_select_schedule_number(std::string const& path_name, int schedule_number,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt )
-                      {
-                          
-                      }
+{
+    if (!this->load_schedule(path_name, schedule_number))
+        ERROR("Can't load schedule " + std::to_string(schedule_number) + " from " + path_name + ".", true);
+
+    this->codegen(arguments, obj_filename, gen_cuda_stmt);
+}
+
 void tiramisu::function::codegen_write_potential_schedules(std::string& path_name,
                       const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const bool gen_cuda_stmt )
-                      {// test write 2schudles
+{
+    if (this->save_schedule(path_name) < 0)
+        ERROR("Can't write the schedule to " + path_name + ".", true);
+
+    this->codegen(arguments, obj_filename, gen_cuda_stmt);
+}
+
+int tiramisu::function::save_schedule(std::string const& path_name)
+{
+    // Count the schedules already saved in the file
+    int schedule_number = 0;
+    std::string line;
+
+    std::ifstream in(path_name);
+    while (std::getline(in, line))
+        if (line.compare(0, 9, "schedule ") == 0)
+            schedule_number++;
+
+    in.close();
+
+    // Apply the ordering given by .after() and .then(), so that the
+    // schedule maps contain the whole schedule.
+    this->gen_ordering_schedules();
+    this->align_schedules();
+
+    std::ofstream out(path_name, std::ios::app);
+    if (!out)
+        return -1;
+
+    out << "schedule " << schedule_number << std::endl;
+
+    // Temporary buffers with a constant size, that the schedule may have created (e.g. with store_in())
+    std::set<std::string> saved_buffers;
+    for (auto const& buf_it : this->get_buffers())
+    {
+        tiramisu::buffer *buf = buf_it.second;
+        if (buf->get_argument_type() != a_temporary)
+            continue;
+
+        std::vector<tiramisu::expr> const& dim_sizes = buf->get_dim_sizes();
+        if (!std::all_of(dim_sizes.begin(), dim_sizes.end(), [](tiramisu::expr const& e) { return e.is_constant(); }))
+            continue;
+
+        out << "buffer " << buf->get_name() << " " << (int) buf->get_elements_type();
+        for (tiramisu::expr const& dim_size : dim_sizes)
+            out << " " << dim_size.get_int_val();
+
+        out << std::endl;
+        saved_buffers.insert(buf->get_name());
+    }
+
+    // The computations added by the schedule (definitions added by separate(), duplicates added by
+    // compute_at(), allocations added by allocate_at()) are saved with what is needed to add them again.
+    std::set<std::string> saved_names;
+    for (computation *comp : this->body)
+    {
+        char *map_str = isl_map_to_str(comp->get_schedule());
+
+        if (comp->get_expr().get_expr_type() == e_op && comp->get_expr().get_op_type() == o_allocate)
+        {
+            // The iteration domain of an allocation has one dimension per loop level down to the allocation level
+            std::string consumer_name = comp->get_name().substr(std::string("_allocation_").size());
+            int level = isl_set_dim(comp->get_iteration_domain(), isl_dim_set) - 1;
+
+            out << "allocation " << comp->get_expr().get_name() << " " << consumer_name << " " << level << " " << map_str << std::endl;
+        }
+
+        else if (!comp->is_first_definition())
+            out << "definition " << comp->get_name() << " " << map_str << std::endl;
+
+        else if (saved_names.count(comp->get_name()) > 0)
+            out << "duplicate " << comp->get_name() << " " << map_str << std::endl;
+
+        else
+            out << "computation " << comp->get_name() << " " << map_str << std::endl;
+
+        free(map_str);
+
+        // The access relations to the saved buffers, as the schedule may have changed them
+        if (saved_names.insert(comp->get_name()).second && comp->get_access_relation() != NULL)
+        {
+            const char *buffer_name = isl_map_get_tuple_name(comp->get_access_relation(), isl_dim_out);
+            if (buffer_name != NULL && saved_buffers.count(buffer_name) > 0)
+            {
+                char *access_str = isl_map_to_str(comp->get_access_relation());
+                out << "access " << comp->get_name() << " " << access_str << std::endl;
+                free(access_str);
+            }
+        }
+    }
+
+    for (auto const& dim : this->parallel_dimensions)
+        out << "parallel " << dim.first << " " << dim.second << std::endl;
+
+    for (auto const& dim : this->vector_dimensions)
+        out << "vector " << std::get<0>(dim) << " " << std::get<1>(dim) << " " << std::get<2>(dim) << std::endl;
+
+    for (auto const& dim : this->unroll_dimensions)
+        out << "unroll " << std::get<0>(dim) << " " << std::get<1>(dim) << " " << std::get<2>(dim) << std::endl;
+
+    for (auto const& dim : this->distributed_dimensions)
+        out << "distributed " << dim.first << " " << dim.second << std::endl;
+
+    for (auto const& dim : this->gpu_block_dimensions)
+        out << "gpu_block " << dim.first << " " << std::get<0>(dim.second) << " "
+            << std::get<1>(dim.second) << " " << std::get<2>(dim.second) << std::endl;
+
+    for (auto const& dim : this->gpu_thread_dimensions)
+        out << "gpu_thread " << dim.first << " " << std::get<0>(dim.second) << " "
+            << std::get<1>(dim.second) << " " << std::get<2>(dim.second) << std::endl;
+
+    out << "end" << std::endl;
+    out.close();
+
+    return schedule_number;
+}
+
+bool tiramisu::function::load_schedule(std::string const& path_name, int schedule_number)
+{
+    std::ifstream in(path_name);
+    if (!in)
+        return false;
+
+    // Look for the beginning of the schedule
+    std::string line;
+    std::string header = "schedule " + std::to_string(schedule_number);
+    bool found = false;
+
+    while (!found && std::getline(in, line))
+        found = (line == header);
+
+    if (!found)
+        return false;
+
+    // A computation of the schedule : its kind (computation, definition, duplicate or allocation),
+    // its name, and for an allocation, the allocated buffer and the level of the consumer.
+    struct saved_computation
+    {
+        std::string kind, name, buffer_name;
+        int level = -1;
+    };
+
+    std::vector<saved_computation> saved_comps;
+    std::vector<std::string> schedule_maps;
+    std::vector<std::pair<std::string, std::string>> accesses;
+    std::vector<std::tuple<std::string, int, std::vector<int>>> buffers;
+    std::vector<std::pair<std::string, int>> parallel_dims, distributed_dims;
+    std::vector<std::tuple<std::string, int, int>> vector_dims, unroll_dims;
+    std::vector<std::pair<std::string, std::tuple<int, int, int>>> gpu_block_dims, gpu_thread_dims;
+
+    while (std::getline(in, line) && line != "end")
+    {
+        std::istringstream line_stream(line);
+        std::string kind, comp_name;
+        int l0 = -1, l1 = -1, l2 = -1;
+
+        line_stream >> kind >> comp_name;
+
+        if (kind == "computation" || kind == "definition" || kind == "duplicate" || kind == "allocation")
+        {
+            saved_computation saved_comp;
+            saved_comp.kind = kind;
+            saved_comp.name = comp_name;
+
+            // The name of an allocation is given by its consumer
+            if (kind == "allocation")
+            {
+                std::string consumer_name;
+                if (!(line_stream >> consumer_name >> saved_comp.level))
+                    return false;
+
+                saved_comp.buffer_name = comp_name;
+                saved_comp.name = "_allocation_" + consumer_name;
+            }
+
+            // Computations are saved in the order of the body of the function. The ones that
+            // don't exist yet were added by the schedule, they are added again below.
+            int pos = saved_comps.size();
+            if (pos < this->body.size() ? this->body[pos]->get_name() != saved_comp.name : kind == "computation")
+                return false;
+
+            std::string map_str;
+            std::getline(line_stream, map_str);
+
+            saved_comps.push_back(saved_comp);
+            schedule_maps.push_back(map_str);
+        }
+
+        else if (kind == "buffer" && line_stream >> l0)
+        {
+            std::vector<int> sizes;
+            while (line_stream >> l1)
+                sizes.push_back(l1);
+
+            buffers.push_back(std::make_tuple(comp_name, l0, sizes));
+        }
+
+        else if (kind == "access")
+        {
+            std::string access_str;
+            std::getline(line_stream, access_str);
+            accesses.push_back(std::make_pair(comp_name, access_str));
+        }
+
+        else if (kind == "parallel" && line_stream >> l0)
+            parallel_dims.push_back(std::make_pair(comp_name, l0));
+
+        else if (kind == "distributed" && line_stream >> l0)
+            distributed_dims.push_back(std::make_pair(comp_name, l0));
+
+        else if (kind == "vector" && line_stream >> l0 >> l1)
+            vector_dims.push_back(std::make_tuple(comp_name, l0, l1));
+
+        else if (kind == "unroll" && line_stream >> l0 >> l1)
+            unroll_dims.push_back(std::make_tuple(comp_name, l0, l1));
+
+        else if (kind == "gpu_block" && line_stream >> l0 >> l1 >> l2)
+            gpu_block_dims.push_back(std::make_pair(comp_name, std::make_tuple(l0, l1, l2)));
+
+        else if (kind == "gpu_thread" && line_stream >> l0 >> l1 >> l2)
+            gpu_thread_dims.push_back(std::make_pair(comp_name, std::make_tuple(l0, l1, l2)));
+
+        else
+            return false;
+    }
+
+    if (line != "end" || schedule_maps.size() < this->body.size())
+        return false;
+
+    // Add the buffers created by the schedule
+    for (auto const& saved_buffer : buffers)
+    {
+        if (this->get_buffers().count(std::get<0>(saved_buffer)) > 0)
+            continue;
+
+        std::vector<tiramisu::expr> dim_sizes;
+        for (int size : std::get<2>(saved_buffer))
+            dim_sizes.push_back(tiramisu::expr(size));
 
-                          this->save_computation_default_schedules();
-                            this->gen_ordering_schedules();
-                            this->align_schedules();
+        new tiramisu::buffer(std::get<0>(saved_buffer), dim_sizes, (tiramisu::primitive_t) std::get<1>(saved_buffer),
+                             a_temporary, this);
+    }
+
+    // Add the computations created by the schedule, as the commands that created them did.
+    // Their schedule is replaced by the saved one below.
+    for (int i = this->body.size(); i < saved_comps.size(); ++i)
+    {
+        saved_computation const& saved_comp = saved_comps[i];
+
+        if (saved_comp.kind == "allocation")
+        {
+            std::string consumer_name = saved_comp.name.substr(std::string("_allocation_").size());
+            std::vector<computation*> consumers = this->get_computation_by_name(consumer_name);
+            auto buffer_it = this->get_buffers().find(saved_comp.buffer_name);
+
+            if (consumers.empty() || buffer_it == this->get_buffers().end())
+                return false;
+
+            buffer_it->second->allocate_at(*consumers[0], saved_comp.level);
+        }
+
+        else
+        {
+            std::vector<computation*> definitions = this->get_computation_by_name(saved_comp.name);
+            if (definitions.empty())
+                return false;
+
+            computation *first_def = definitions[0];
+
+            if (saved_comp.kind == "definition")
+            {
+                first_def->add_definitions(isl_set_to_str(first_def->get_iteration_domain()), first_def->get_expr(),
+                                           first_def->should_schedule_this_computation(),
+                                           first_def->get_data_type(), this);
+
+                if (first_def->get_access_relation() != NULL)
+                    first_def->get_last_update().set_access(isl_map_copy(first_def->get_access_relation()));
+            }
+
+            else
+            {
+                computation *duplicate = first_def->duplicate("", "");
+                first_def->updates.push_back(duplicate);
+            }
+        }
+
+        if (this->body.size() != i + 1 || this->body[i]->get_name() != saved_comp.name)
+            return false;
+    }
 
-                            std::ofstream out(path_name);
+    for (auto const& access : accesses)
+    {
+        std::vector<computation*> definitions = this->get_computation_by_name(access.first);
+        if (definitions.empty())
+            return false;
 
-                            //out << "chedule1\n";
-                            //out <<(isl_union_map_to_str(this->get_schedule())) ;
-                           
+        definitions[0]->set_access(access.second);
+    }
 
-                            out.close();
+    // The schedule is valid, replace the current one
+    for (int i = 0; i < this->body.size(); ++i)
+        this->body[i]->set_low_level_schedule(schedule_maps[i]);
 
-                      }
+    this->parallel_dimensions = parallel_dims;
+    this->distributed_dimensions = distributed_dims;
+    this->vector_dimensions = vector_dims;
+    this->unroll_dimensions = unroll_dims;
+    this->gpu_block_dimensions = gpu_block_dims;
+    this->gpu_thread_dimensions = gpu_thread_dims;
+
+    return true;
+}
+
+void tiramisu::function::set_incremental_codegen(bool incremental)
+{
+    // The cached loop nests stay valid, as they are identified by their fingerprints
+    this->incremental_codegen = incremental;
+}
+
+bool tiramisu::function::is_incremental_codegen_set() const
+{
+    return this->incremental_codegen;
+}
 
 void tiramisu::function::save_computations_levels(){
     for (auto const &graph1 :this->sched_graph){
@@ -2668,6 +3277,8 @@ void tiramisu::function::restore_computations_levels(){
 #define USE_HALIDE_BUFFERS_BUG_WORKAROUND true
 void tiramisu::function::codegen(const std::vector<tiramisu::buffer *> &arguments, const std::string obj_filename, const tiramisu::hardware_architecture_t gen_architecture_flag)
 {
+    compile_time_profiler::start(this->get_name());
+
     this->set_arguments(arguments);
     if (gen_architecture_flag == tiramisu::hardware_architecture_t::arch_nvidia_gpu ||
         gen_architecture_flag == tiramisu::hardware_architecture_t::arch_flexnlp)
@@ -2697,6 +3308,8 @@ void tiramisu::function::codegen(const std::vector<tiramisu::buffer *> &argument
     }
     this->gen_halide_stmt();
     this->gen_halide_obj(obj_filename, gen_architecture_flag);
+
+    compile_time_profiler::stop();
 }
 
 
@@ -0,0 +1,314 @@
+#include <tiramisu/jit.h>
+#include <tiramisu/core.h>
+#include <tiramisu/debug.h>
+#include <tiramisu/object_cache.h>
+#include <tiramisu/profiler.h>
+
+#include <cassert>
+#include <string>
+
+namespace tiramisu
+{
+
+/**
+  * Maximal number of modules compiled by function::jit_compile() kept by a function.
+  * The least recently used module is evicted first.
+  */
+#define MAX_CACHED_JIT_FUNCTIONS 64
+
+jit_function::jit_function()
+    : argv_function(nullptr)
+{
+}
+
+jit_function::jit_function(Halide::Module const& m, std::string const& name, std::vector<Halide::Argument> const& arguments)
+    : argv_function(nullptr), arguments(arguments), name(name)
+{
+    for (auto const &f : m.functions())
+    {
+        if (f.name != name)
+            continue;
+
+        this->module = Halide::Internal::JITModule(m, f);
+        this->argv_function = this->module.argv_function();
+        break;
+    }
+
+    if (this->argv_function == nullptr)
+        ERROR("Can't compile the function " + name + " with the JIT.", true);
+}
+
+bool jit_function::defined() const
+{
+    return this->argv_function != nullptr;
+}
+
+std::string const& jit_function::get_name() const
+{
+    return this->name;
+}
+
+std::vector<Halide::Argument> const& jit_function::get_arguments() const
+{
+    return this->arguments;
+}
+
+int jit_function::run(std::vector<Halide::Buffer<>> const& buffers) const
+{
+    if (!this->defined())
+    {
+        ERROR("The function is not compiled, call function::jit_compile() first.", false);
+        return -1;
+    }
+
+    if (buffers.size() != this->arguments.size())
+    {
+        ERROR("The function " + this->name + " takes " + std::to_string(this->arguments.size()) +
+              " buffers, but " + std::to_string(buffers.size()) + " were given.", false);
+        return -1;
+    }
+
+    std::vector<const void *> args;
+
+    for (int i = 0; i < buffers.size(); i++)
+    {
+        if ((buffers[i].dimensions() != this->arguments[i].dimensions) ||
+            (buffers[i].type() != this->arguments[i].type))
+        {
+            ERROR("The buffer given for the argument " + this->arguments[i].name + " of the function " +
+                  this->name + " doesn't have the right type or number of dimensions.", false);
+            return -1;
+        }
+
+        args.push_back(buffers[i].raw_buffer());
+    }
+
+    return this->argv_function(args.data());
+}
+
+jit_function function::jit_compile(const std::vector<tiramisu::buffer *> &arguments)
+{
+    this->set_arguments(arguments);
+
+    return this->jit_compile();
+}
+
+jit_function function::jit_compile()
+{
+    compile_time_profiler::start(this->get_name());
+
+    this->lift_dist_comps();
+    this->gen_time_space_domain();
+    this->gen_isl_ast();
+    this->gen_halide_stmt();
+
+    {
+        compile_time_scope phase_scope("jit_compile");
+
+        Halide::Target target = Halide::get_jit_target_from_environment().with_feature(Halide::Target::LargeBuffers);
+
+        std::vector<Halide::Argument> fct_arguments;
+
+        for (const auto &buf : this->function_arguments)
+        {
+            Halide::Argument buffer_arg(
+                    buf->get_name(),
+                    halide_argtype_from_tiramisu_argtype(buf->get_argument_type()),
+                    halide_type_from_tiramisu_type(buf->get_elements_type()),
+                    buf->get_n_dims());
+
+            fct_arguments.push_back(buffer_arg);
+        }
+
+        // The argv entry point is only generated along with the metadata
+        Halide::Module m = lower_halide_pipeline(this->get_name(), target, fct_arguments,
+                                                 Halide::Internal::LoweredFunc::ExternalPlusMetadata,
+                                                 this->get_halide_stmt());
+
+        std::string key = object_cache::get_key(m);
+
+        auto cached_function = this->jit_functions_cache.begin();
+        while (cached_function != this->jit_functions_cache.end() && cached_function->first != key)
+            cached_function++;
+
+        if (cached_function != this->jit_functions_cache.end())
+        {
+            DEBUG(3, tiramisu::str_dump("The module of the function was already compiled."));
+
+            // Move it to the front of the LRU list
+            this->jit_functions_cache.splice(this->jit_functions_cache.begin(),
+                                             this->jit_functions_cache, cached_function);
+            this->last_jit_function = cached_function->second;
+        }
+        else
+        {
+            compile_time_scope step_scope("llvm_compile");
+            this->last_jit_function = jit_function(m, this->get_name(), fct_arguments);
+
+            // Evict the least recently used module
+            if (this->jit_functions_cache.size() >= MAX_CACHED_JIT_FUNCTIONS)
+                this->jit_functions_cache.pop_back();
+
+            this->jit_functions_cache.emplace_front(key, this->last_jit_function);
+        }
+    }
+
+    compile_time_profiler::stop();
+
+    return this->last_jit_function;
+}
+
+int function::run(std::vector<Halide::Buffer<>> const& buffers)
+{
+    if (!this->last_jit_function.defined())
+        this->jit_compile();
+
+    return this->last_jit_function.run(buffers);
+}
+
+jit_function function::jit_compile_specialized(const std::vector<std::pair<std::string, int64_t>> &parameter_values)
+{
+    isl_set *generic_context = (this->context_set == NULL) ? NULL : isl_set_copy(this->context_set);
+    jit_function generic_function = this->last_jit_function;
+
+    std::string parameters, constraints;
+    for (const auto &value : parameter_values)
+    {
+        if (!parameters.empty())
+        {
+            parameters += ", ";
+            constraints += " and ";
+        }
+
+        parameters += value.first;
+        constraints += value.first + " = " + std::to_string(value.second);
+    }
+
+    if (!parameter_values.empty())
+        this->add_context_constraints("[" + parameters + "]->{: " + constraints + "}");
+
+    jit_function specialized_function = this->jit_compile();
+
+    isl_set_free(this->context_set);
+    this->context_set = generic_context;
+    this->last_jit_function = generic_function;
+
+    return specialized_function;
+}
+
+jit_specializer::jit_specializer(tiramisu::function *fct, std::vector<tiramisu::buffer *> const& arguments,
+                                 std::vector<shape_parameter> const& parameters, int capacity)
+    : fct(fct), parameters(parameters), capacity(capacity), compiling(false), nb_specialized_runs(0)
+{
+    assert(fct != NULL);
+
+    this->generic_function = fct->jit_compile(arguments);
+}
+
+jit_specializer::~jit_specializer()
+{
+    this->wait();
+}
+
+std::vector<int64_t> jit_specializer::get_shape(std::vector<Halide::Buffer<>> const& buffers) const
+{
+    std::vector<int64_t> shape;
+
+    for (const auto &parameter : this->parameters)
+    {
+        if ((parameter.argument < 0) || (parameter.argument >= buffers.size()))
+            return {};
+
+        Halide::Buffer<> const& buf = buffers[parameter.argument];
+
+        // Halide buffers go from the innermost dimension to the outermost one
+        int halide_dimension = buf.dimensions() - 1 - parameter.dimension;
+        if ((halide_dimension < 0) || (halide_dimension >= buf.dimensions()))
+            return {};
+
+        shape.push_back(buf.extent(halide_dimension));
+    }
+
+    return shape;
+}
+
+void jit_specializer::compile_specialized_function(std::vector<int64_t> shape)
+{
+    std::vector<std::pair<std::string, int64_t>> parameter_values;
+    for (int i = 0; i < this->parameters.size(); i++)
+        parameter_values.push_back(std::make_pair(this->parameters[i].name, shape[i]));
+
+    jit_function specialized_function = this->fct->jit_compile_specialized(parameter_values);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->specialized_functions.push_front(std::make_pair(shape, specialized_function));
+    while (this->specialized_functions.size() > this->capacity)
+        this->specialized_functions.pop_back();
+
+    this->compiling = false;
+}
+
+int jit_specializer::run(std::vector<Halide::Buffer<>> const& buffers)
+{
+    std::vector<int64_t> shape = this->get_shape(buffers);
+
+    // The generic function also reports invalid buffers
+    if (shape.size() != this->parameters.size() || this->parameters.empty())
+        return this->generic_function.run(buffers);
+
+    jit_function function_to_run = this->generic_function;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        auto specialized_function = this->specialized_functions.begin();
+        while (specialized_function != this->specialized_functions.end() && specialized_function->first != shape)
+            specialized_function++;
+
+        if (specialized_function != this->specialized_functions.end())
+        {
+            // Move it to the front of the LRU list
+            this->specialized_functions.splice(this->specialized_functions.begin(),
+                                               this->specialized_functions, specialized_function);
+            function_to_run = specialized_function->second;
+            this->nb_specialized_runs++;
+        }
+
+        // Compile a variant for this shape, unless another one is being compiled.
+        // The shape will be compiled by a later call otherwise.
+        else if (!this->compiling && this->capacity > 0)
+        {
+            // The previous compilation is done, its thread only has to be joined
+            if (this->compile_thread.joinable())
+                this->compile_thread.join();
+
+            this->compiling = true;
+            this->compile_thread = std::thread(&jit_specializer::compile_specialized_function, this, shape);
+        }
+    }
+
+    return function_to_run.run(buffers);
+}
+
+void jit_specializer::wait()
+{
+    if (this->compile_thread.joinable())
+        this->compile_thread.join();
+}
+
+int jit_specializer::get_nb_specialized_functions()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->specialized_functions.size();
+}
+
+int jit_specializer::get_nb_specialized_runs()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->nb_specialized_runs;
+}
+
+}
@@ -0,0 +1,193 @@
+#include <sys/stat.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <tiramisu/object_cache.h>
+#include <tiramisu/debug.h>
+#include <tiramisu/expr.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace tiramisu
+{
+
+/**
+  * Changing this version invalidates the object files cached before.
+  */
+#define OBJECT_CACHE_VERSION "1"
+
+/**
+  * Set by CMake from llvm-config and from the revision of the Halide sources.
+  */
+#ifndef TIRAMISU_LLVM_VERSION
+#define TIRAMISU_LLVM_VERSION "unknown"
+#endif
+
+#ifndef TIRAMISU_HALIDE_VERSION
+#define TIRAMISU_HALIDE_VERSION "unknown"
+#endif
+
+namespace
+{
+
+/**
+  * Return the 64-bit FNV-1a hash of \p str, as an hexadecimal string.
+  * Unlike std::hash, it doesn't depend on the standard library, so it
+  * can be used to name files shared by several programs.
+  */
+std::string get_hash_str(std::string const& str)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (unsigned char c : str)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    char hash_str[17];
+    snprintf(hash_str, sizeof(hash_str), "%016llx", (unsigned long long)hash);
+
+    return hash_str;
+}
+
+/**
+  * Return an identifier of the build of the binary (shared library or executable)
+  * that contains \p address : its path, size and modification time.
+  * Rebuilding Tiramisu or Halide changes the identifier of their library.
+  */
+std::string get_build_id(void *address)
+{
+    Dl_info info;
+    if (dladdr(address, &info) == 0 || info.dli_fname == nullptr)
+        return "unknown";
+
+    struct stat file_stat;
+    if (stat(info.dli_fname, &file_stat) != 0)
+        return info.dli_fname;
+
+    return std::string(info.dli_fname) + " " + std::to_string((long long)file_stat.st_size) + " "
+           + std::to_string((long long)file_stat.st_mtime);
+}
+
+bool copy_file(std::string const& src_path, std::string const& dst_path)
+{
+    std::ifstream src(src_path, std::ios::binary);
+    if (!src)
+        return false;
+
+    std::ofstream dst(dst_path, std::ios::binary | std::ios::trunc);
+    if (!dst)
+        return false;
+
+    dst << src.rdbuf();
+
+    return (bool)dst;
+}
+
+} // anonymous namespace
+
+bool object_cache::is_enabled()
+{
+    return !global::get_object_cache_directory().empty();
+}
+
+std::string object_cache::get_object_path(std::string const& key)
+{
+    return global::get_object_cache_directory() + "/" + key + ".o";
+}
+
+std::string object_cache::get_key(Halide::Module const& m)
+{
+    std::ostringstream key;
+
+    key << "version " << OBJECT_CACHE_VERSION << std::endl;
+
+    // Another compiler can generate another object file from the same module
+    static const std::string tiramisu_build_id = get_build_id((void *)&get_build_id);
+    static const std::string halide_build_id = get_build_id((void *)&Halide::get_host_target);
+
+    key << "llvm " << TIRAMISU_LLVM_VERSION << std::endl;
+    key << "halide " << TIRAMISU_HALIDE_VERSION << " " << halide_build_id << std::endl;
+    key << "tiramisu " << tiramisu_build_id << std::endl;
+
+    key << "target " << m.target().to_string() << std::endl;
+
+    for (auto const &f : m.functions())
+    {
+        key << "function " << f.name << " " << (int)f.linkage << std::endl;
+
+        for (auto const &arg : f.args)
+            key << "argument " << arg.name << " " << (int)arg.kind << " "
+                << (int)arg.dimensions << " " << arg.type << std::endl;
+    }
+
+    // The lowered statements of the functions and the constant buffers
+    key << m;
+
+    // The length makes collisions of the hash even less likely
+    return get_hash_str(key.str()) + "_" + std::to_string(key.str().size());
+}
+
+bool object_cache::load(std::string const& key, std::string const& obj_file_name)
+{
+    if (!is_enabled())
+        return false;
+
+    std::string object_path = get_object_path(key);
+    if (access(object_path.c_str(), R_OK) != 0)
+        return false;
+
+    if (!copy_file(object_path, obj_file_name))
+        return false;
+
+    DEBUG(3, tiramisu::str_dump("Object file " + obj_file_name + " copied from the cache (" + object_path + ")."));
+
+    return true;
+}
+
+void object_cache::store(std::string const& key, std::string const& obj_file_name)
+{
+    if (!is_enabled())
+        return;
+
+    std::string directory = global::get_object_cache_directory();
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        tiramisu::str_dump("Can't create the object cache directory " + directory + ".\n");
+        return;
+    }
+
+    // Other processes must never see a partially written object file
+    std::string object_path = get_object_path(key);
+    std::string tmp_path = object_path + ".tmp" + std::to_string(getpid());
+
+    if (!copy_file(obj_file_name, tmp_path) || rename(tmp_path.c_str(), object_path.c_str()) != 0)
+    {
+        tiramisu::str_dump("Can't add " + obj_file_name + " to the object cache " + directory + ".\n");
+        remove(tmp_path.c_str());
+    }
+}
+
+bool object_cache::compile(Halide::Module const& m, std::string const& obj_file_name)
+{
+    if (!is_enabled())
+    {
+        m.compile(Halide::Outputs().object(obj_file_name));
+        return false;
+    }
+
+    std::string key = get_key(m);
+    if (load(key, obj_file_name))
+        return true;
+
+    m.compile(Halide::Outputs().object(obj_file_name));
+    store(key, obj_file_name);
+
+    return false;
+}
+
+}
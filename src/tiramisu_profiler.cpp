@@ -0,0 +1,218 @@
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <tiramisu/profiler.h>
+#include <tiramisu/expr.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace tiramisu
+{
+
+std::vector<compile_time_profiler::event> compile_time_profiler::events;
+std::vector<int> compile_time_profiler::open_events;
+bool compile_time_profiler::recording = false;
+std::string compile_time_profiler::session_name;
+std::chrono::steady_clock::time_point compile_time_profiler::session_start;
+
+/**
+  * Number of computations shown in the table, from the slowest one.
+  */
+#define NB_PROFILED_COMPUTATIONS_SHOWN 20
+
+namespace
+{
+
+/**
+  * Return the peak resident set size of the process in kilobytes.
+  */
+long get_peak_rss()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return usage.ru_maxrss;
+}
+
+} // anonymous namespace
+
+std::string get_json_string(std::string const& str)
+{
+    std::string json_str = "\"";
+
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            json_str += std::string("\\") + c;
+
+        else if ((unsigned char)c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            json_str += escaped;
+        }
+
+        else
+            json_str += c;
+    }
+
+    return json_str + "\"";
+}
+
+bool compile_time_profiler::is_enabled()
+{
+    return global::is_compile_time_profiling_set();
+}
+
+void compile_time_profiler::start(std::string const& fct_name)
+{
+    if (!is_enabled())
+        return;
+
+    events.clear();
+    open_events.clear();
+
+    recording = true;
+    session_name = fct_name;
+    session_start = std::chrono::steady_clock::now();
+
+    begin("codegen", "phase");
+}
+
+void compile_time_profiler::stop()
+{
+    if (!recording)
+        return;
+
+    while (!open_events.empty())
+        end();
+
+    recording = false;
+
+    std::string trace_path = global::get_compile_time_trace_path();
+    if (trace_path.empty())
+        trace_path = session_name + "_compile_profile.json";
+
+    print_table();
+    write_trace(trace_path);
+
+    events.clear();
+}
+
+void compile_time_profiler::begin(std::string const& name, std::string const& category)
+{
+    if (!recording)
+        return;
+
+    event e;
+    e.name = name;
+    e.category = category;
+    e.start = std::chrono::duration<double>(std::chrono::steady_clock::now() - session_start).count();
+    e.duration = 0;
+    e.peak_rss_start = get_peak_rss();
+    e.peak_rss_end = e.peak_rss_start;
+    e.depth = open_events.size();
+
+    open_events.push_back(events.size());
+    events.push_back(e);
+}
+
+void compile_time_profiler::end()
+{
+    if (!recording || open_events.empty())
+        return;
+
+    event &e = events[open_events.back()];
+    open_events.pop_back();
+
+    e.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - session_start).count() - e.start;
+    e.peak_rss_end = get_peak_rss();
+}
+
+void compile_time_profiler::print_table()
+{
+    if (events.empty())
+        return;
+
+    double total_time = events[0].duration;
+
+    std::cout << "Compile-time profile of " << session_name << " :" << std::endl;
+    printf("%-48s %12s %8s %14s %14s\n", "Phase", "Time (s)", "%", "Peak RSS (MB)", "RSS growth (MB)");
+
+    // Phases and Halide passes, in the order they were executed
+    for (event const &e : events)
+    {
+        if (e.category == "computation")
+            continue;
+
+        std::string name = std::string(2 * e.depth, ' ') + e.name;
+        printf("%-48s %12.4f %8.1f %14.1f %14.1f\n", name.c_str(), e.duration,
+               total_time > 0 ? 100 * e.duration / total_time : 0,
+               e.peak_rss_end / 1024.0, (e.peak_rss_end - e.peak_rss_start) / 1024.0);
+    }
+
+    // The same computation is processed by several phases
+    std::map<std::string, double> computation_times;
+    for (event const &e : events)
+        if (e.category == "computation")
+            computation_times[e.name] += e.duration;
+
+    if (computation_times.empty())
+        return;
+
+    std::vector<std::pair<std::string, double>> sorted_times(computation_times.begin(), computation_times.end());
+    std::sort(sorted_times.begin(), sorted_times.end(), [](std::pair<std::string, double> const &a, std::pair<std::string, double> const &b) {
+        return a.second > b.second;
+    });
+
+    std::cout << std::endl << "Slowest computations (" << sorted_times.size() << " computations) :" << std::endl;
+    printf("%-48s %12s %8s\n", "Computation", "Time (s)", "%");
+
+    for (int i = 0; i < sorted_times.size() && i < NB_PROFILED_COMPUTATIONS_SHOWN; i++)
+        printf("%-48s %12.4f %8.1f\n", sorted_times[i].first.c_str(), sorted_times[i].second,
+               total_time > 0 ? 100 * sorted_times[i].second / total_time : 0);
+
+    std::flush(std::cout);
+}
+
+void compile_time_profiler::write_trace(std::string const& trace_path)
+{
+    std::ofstream trace_file(trace_path);
+    if (!trace_file)
+    {
+        std::cerr << "Can't write the compile-time trace to " << trace_path << std::endl;
+        return;
+    }
+
+    int pid = getpid();
+    trace_file << "{\"traceEvents\": [" << std::endl;
+
+    // "X" events are complete events, with a start and a duration in microseconds
+    for (int i = 0; i < events.size(); i++)
+    {
+        event const &e = events[i];
+
+        trace_file << "{\"name\": " << get_json_string(e.name) << ", \"cat\": \"" << e.category << "\", "
+                   << "\"ph\": \"X\", \"ts\": " << (long long)(e.start * 1e6) << ", "
+                   << "\"dur\": " << (long long)(e.duration * 1e6) << ", \"pid\": " << pid << ", \"tid\": 0, "
+                   << "\"args\": {\"peak_rss_kb\": " << e.peak_rss_end << ", "
+                   << "\"rss_growth_kb\": " << e.peak_rss_end - e.peak_rss_start << "}}";
+
+        if (i + 1 < events.size())
+            trace_file << ",";
+
+        trace_file << std::endl;
+    }
+
+    trace_file << "], \"displayTimeUnit\": \"ms\", \"otherData\": {\"function\": "
+               << get_json_string(session_name) << "}}" << std::endl;
+
+    std::cout << "Compile-time trace written to " << trace_path << std::endl;
+}
+
+}
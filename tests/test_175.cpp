@@ -0,0 +1,92 @@
+#include <isl/set.h>
+#include <isl/union_map.h>
+#include <isl/union_set.h>
+#include <isl/ast_build.h>
+#include <isl/schedule.h>
+#include <isl/schedule_node.h>
+
+#include <tiramisu/debug.h>
+#include <tiramisu/core.h>
+
+#include <cstdio>
+#include <string.h>
+#include <Halide.h>
+
+#include "wrapper_test_175.h"
+
+using namespace tiramisu;
+
+/**
+ * Test save_schedule() and load_schedule() with a schedule that uses compute_at() :
+ * the schedule of a first function is saved, then loaded in a second function
+ * that defines the same computations, and the second function is generated.
+ */
+
+#define SCHEDULES_FILE "build/test_175_schedules.txt"
+
+/**
+ * Define the computations of the test in the given function.
+ * S1 reads two rows of S0, so compute_at() adds a duplicate of S0.
+ */
+void define_computations(tiramisu::function *fct, int size, int val0, tiramisu::computation **S0, tiramisu::computation **S1)
+{
+    tiramisu::constant *N = new tiramisu::constant("N", tiramisu::expr((int32_t) size), p_int32, true, NULL, 0, fct);
+    tiramisu::var i("i");
+    tiramisu::var j("j");
+
+    *S0 = new tiramisu::computation("[N]->{S0[i,j]: 0<=i<N+1 and 0<=j<N}", tiramisu::expr((uint8_t) val0), true,
+                                    p_uint8, fct);
+    *S1 = new tiramisu::computation("[N]->{S1[i,j]: 0<=i<N and 0<=j<N}", (**S0)(i, j) + (**S0)(i + 1, j), true,
+                                    p_uint8, fct);
+}
+
+void save_schedule(int size, int val0)
+{
+    tiramisu::function function0("test_175_saved");
+    tiramisu::computation *S0, *S1;
+    define_computations(&function0, size, val0, &S0, &S1);
+
+    tiramisu::var i("i");
+    tiramisu::var j("j");
+
+    // S0 is stored in a buffer of two rows, and computed at each iteration of i
+    S0->store_in({i % 2, j}, {2, size});
+    S0->compute_at(*S1, i);
+
+    tiramisu::buffer buf1("buf1", {size, size}, tiramisu::p_uint8, a_output, &function0);
+    S1->store_in(&buf1);
+
+    std::remove(SCHEDULES_FILE);
+    if (function0.save_schedule(SCHEDULES_FILE) != 0)
+        ERROR("Can't save the schedule to " SCHEDULES_FILE ".", true);
+}
+
+void generate_function(std::string name, int size, int val0)
+{
+    tiramisu::function function0(name);
+    tiramisu::computation *S0, *S1;
+    define_computations(&function0, size, val0, &S0, &S1);
+
+    tiramisu::buffer buf1("buf1", {size, size}, tiramisu::p_uint8, a_output, &function0);
+    S1->store_in(&buf1);
+
+    // The duplicate of S0, its buffer and its access are added by load_schedule()
+    if (!function0.load_schedule(SCHEDULES_FILE, 0))
+        ERROR("Can't load the schedule from " SCHEDULES_FILE ".", true);
+
+    function0.set_arguments({&buf1});
+    function0.gen_time_space_domain();
+    function0.gen_isl_ast();
+    function0.gen_halide_stmt();
+    function0.gen_halide_obj("build/generated_fct_test_" + std::string(TEST_NUMBER_STR) + ".o");
+}
+
+int main(int argc, char **argv)
+{
+    tiramisu::global::set_default_tiramisu_options();
+
+    save_schedule(SIZE1, 2);
+    generate_function("tiramisu_generated_code", SIZE1, 2);
+
+    return 0;
+}
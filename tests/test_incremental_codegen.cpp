@@ -0,0 +1,128 @@
+#include <tiramisu/debug.h>
+#include <tiramisu/core.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <Halide.h>
+
+using namespace tiramisu;
+
+/**
+ * Test of incremental code generation (function::set_incremental_codegen()) :
+ * a function with three loop nests is generated twice, the schedule of only one
+ * loop nest changing in between, and the results are compared with those of
+ * the code generated without incremental code generation.
+ */
+
+#define SIZE 10
+
+bool check_buffer(Halide::Buffer<uint8_t> &buf, uint8_t expected)
+{
+    for (int j = 0; j < SIZE; j++)
+        for (int i = 0; i < SIZE; i++)
+            if (buf(i, j) != expected)
+            {
+                std::cerr << "buf(" << i << ", " << j << ") = " << (int) buf(i, j)
+                          << ", expected " << (int) expected << std::endl;
+                return false;
+            }
+
+    return true;
+}
+
+bool compare_buffers(Halide::Buffer<uint8_t> &buf, Halide::Buffer<uint8_t> &reference)
+{
+    for (int j = 0; j < SIZE; j++)
+        for (int i = 0; i < SIZE; i++)
+            if (buf(i, j) != reference(i, j))
+            {
+                std::cerr << "buf(" << i << ", " << j << ") = " << (int) buf(i, j)
+                          << ", the non-incremental code gives " << (int) reference(i, j) << std::endl;
+                return false;
+            }
+
+    return true;
+}
+
+/**
+ * Run the last compiled code of the function, and check the output of each loop nest.
+ */
+bool run_and_check(tiramisu::function &function0, std::vector<Halide::Buffer<uint8_t>> &outputs)
+{
+    outputs = {Halide::Buffer<uint8_t>(SIZE, SIZE), Halide::Buffer<uint8_t>(SIZE, SIZE), Halide::Buffer<uint8_t>(SIZE, SIZE)};
+
+    return (function0.run({outputs[0], outputs[1], outputs[2]}) == 0) &&
+           check_buffer(outputs[0], 3) && check_buffer(outputs[1], 4) && check_buffer(outputs[2], 8);
+}
+
+/**
+ * Schedule the three loop nests one after the other. S2 is either tiled or interchanged.
+ */
+void schedule(tiramisu::function &function0, tiramisu::computation &S0, tiramisu::computation &S1, tiramisu::computation &S2, bool tile_S2)
+{
+    function0.reset_schedules();
+
+    S0.tile(0, 1, 2, 2);
+    S1.interchange(0, 1);
+
+    if (tile_S2)
+        S2.tile(0, 1, 5, 5);
+    else
+        S2.interchange(0, 1);
+
+    S1.after(S0, computation::root_dimension);
+    S2.after(S1, computation::root_dimension);
+}
+
+int main(int argc, char **argv)
+{
+    tiramisu::global::set_default_tiramisu_options();
+
+    tiramisu::function function0("incremental_codegen_three_nests");
+    tiramisu::constant N("N", tiramisu::expr((int32_t) SIZE), p_int32, true, NULL, 0, &function0);
+    tiramisu::var i("i"), j("j");
+
+    tiramisu::computation S0("[N]->{S0[i,j]: 0<=i<N and 0<=j<N}", tiramisu::expr((uint8_t) 3), true, p_uint8, &function0);
+    tiramisu::computation S1("[N]->{S1[i,j]: 0<=i<N and 0<=j<N}", S0(i, j) + tiramisu::expr((uint8_t) 1), true, p_uint8, &function0);
+    tiramisu::computation S2("[N]->{S2[i,j]: 0<=i<N and 0<=j<N}", S1(i, j) * tiramisu::expr((uint8_t) 2), true, p_uint8, &function0);
+
+    tiramisu::buffer buf0("buf0", {SIZE, SIZE}, tiramisu::p_uint8, a_output, &function0);
+    tiramisu::buffer buf1("buf1", {SIZE, SIZE}, tiramisu::p_uint8, a_output, &function0);
+    tiramisu::buffer buf2("buf2", {SIZE, SIZE}, tiramisu::p_uint8, a_output, &function0);
+
+    S0.set_access("{S0[i,j]->buf0[i,j]}");
+    S1.set_access("{S1[i,j]->buf1[i,j]}");
+    S2.set_access("{S2[i,j]->buf2[i,j]}");
+
+    function0.set_arguments({&buf0, &buf1, &buf2});
+    function0.set_incremental_codegen(true);
+
+    bool success = true;
+    std::vector<Halide::Buffer<uint8_t>> outputs, reference_outputs;
+
+    // First generation : all the loop nests are generated
+    schedule(function0, S0, S1, S2, true);
+    success = success && function0.jit_compile().defined() && run_and_check(function0, outputs);
+
+    // Second generation : only the loop nest of S2 changed, the others are reused
+    schedule(function0, S0, S1, S2, false);
+    success = success && function0.jit_compile().defined() && run_and_check(function0, outputs);
+
+    // The same schedule generated without incremental code generation
+    function0.set_incremental_codegen(false);
+    schedule(function0, S0, S1, S2, false);
+    success = success && function0.jit_compile().defined() && run_and_check(function0, reference_outputs);
+
+    for (int k = 0; k < 3 && success; ++k)
+        success = compare_buffers(outputs[k], reference_outputs[k]);
+
+    if (!success)
+    {
+        std::cerr << "test_incremental_codegen failed." << std::endl;
+        return 1;
+    }
+
+    std::cout << "test_incremental_codegen succeeded." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <tiramisu/debug.h>
+#include <tiramisu/core.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <Halide.h>
+
+using namespace tiramisu;
+
+/**
+ * Test of the in-process execution of functions (function::jit_compile(), function::run()
+ * and jit_specializer).
+ */
+
+#define SIZE 10
+
+bool check_buffer(Halide::Buffer<uint8_t> &buf, uint8_t expected)
+{
+    for (int j = 0; j < SIZE; j++)
+        for (int i = 0; i < SIZE; i++)
+            if (buf(i, j) != expected)
+            {
+                std::cerr << "buf(" << i << ", " << j << ") = " << (int) buf(i, j)
+                          << ", expected " << (int) expected << std::endl;
+                return false;
+            }
+
+    return true;
+}
+
+/**
+ * Run a function whose size N is read from an input buffer with a jit_specializer,
+ * N being also the extent of the output buffer.
+ */
+bool test_specializer()
+{
+    tiramisu::function function1("jit_specialized_assign_5");
+    tiramisu::computation N_input("{N_input[0]}", tiramisu::expr(), false, p_int32, &function1);
+    tiramisu::constant N("N", N_input(0), p_int32, true, NULL, 0, &function1);
+    tiramisu::var i("i"), j("j"), i0("i0"), j0("j0"), i1("i1"), j1("j1");
+    tiramisu::computation S0("[N]->{S0[i,j]: 0<=i<N and 0<=j<N}", tiramisu::expr((uint8_t) 5), true, p_uint8, &function1);
+
+    tiramisu::buffer N_input_b("N_input_b", {1}, tiramisu::p_int32, a_input, &function1);
+    N_input.store_in(&N_input_b);
+    tiramisu::buffer S0_b("S0_b", {tiramisu::var("N"), tiramisu::var("N")}, tiramisu::p_uint8, a_output, &function1);
+    S0.store_in(&S0_b);
+
+    S0.tile(i, j, 4, 4, i0, j0, i1, j1);
+
+    // N is the extent of the outermost dimension of S0_b
+    tiramisu::jit_specializer specializer(&function1, {&N_input_b, &S0_b}, {{"N", 1, 0}});
+
+    Halide::Buffer<int32_t> N_value(1);
+    N_value(0) = SIZE;
+
+    // The first call runs the generic code, and compiles a specialized variant
+    Halide::Buffer<uint8_t> output0(SIZE, SIZE);
+    bool success = (specializer({N_value, output0}) == 0) && check_buffer(output0, 5);
+    success = success && (specializer.get_nb_specialized_runs() == 0);
+    specializer.wait();
+    success = success && (specializer.get_nb_specialized_functions() == 1);
+
+    // The second call runs the specialized variant
+    Halide::Buffer<uint8_t> output1(SIZE, SIZE);
+    success = success && (specializer({N_value, output1}) == 0) && check_buffer(output1, 5);
+    success = success && (specializer.get_nb_specialized_runs() == 1);
+
+    // Another shape runs the generic code
+    Halide::Buffer<int32_t> N_small(1);
+    N_small(0) = SIZE / 2;
+    Halide::Buffer<uint8_t> output2(SIZE / 2, SIZE / 2);
+    success = success && (specializer({N_small, output2}) == 0);
+    success = success && (specializer.get_nb_specialized_runs() == 1);
+
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    tiramisu::global::set_default_tiramisu_options();
+
+    tiramisu::function function0("jit_assign_7_to_10x10_2D_array");
+    tiramisu::constant N("N", tiramisu::expr((int32_t) SIZE), p_int32, true, NULL, 0, &function0);
+    tiramisu::var i("i"), j("j"), i0("i0"), j0("j0"), i1("i1"), j1("j1");
+    tiramisu::expr e1 = tiramisu::expr(tiramisu::o_add, tiramisu::expr((uint8_t) 3),
+                                       tiramisu::expr((uint8_t) 4));
+    tiramisu::computation S0("[N]->{S0[i,j]: 0<=i<N and 0<=j<N}", e1, true, p_uint8, &function0);
+
+    tiramisu::buffer buf0("buf0", {SIZE, SIZE}, tiramisu::p_uint8, a_output, &function0);
+
+    S0.set_access("{S0[i,j]->buf0[i,j]}");
+    S0.tile(i, j, 2, 2, i0, j0, i1, j1);
+    S0.tag_parallel_level(i0);
+
+    bool success = true;
+
+    // Compile, then call the returned handle
+    tiramisu::jit_function f = function0.jit_compile({&buf0});
+    success = success && f.defined();
+
+    Halide::Buffer<uint8_t> output0(SIZE, SIZE);
+    success = success && (f({output0}) == 0) && check_buffer(output0, 7);
+
+    // Run the last compiled function
+    Halide::Buffer<uint8_t> output1(SIZE, SIZE);
+    success = success && (function0.run({output1}) == 0) && check_buffer(output1, 7);
+
+    // The same module is not compiled again
+    tiramisu::jit_function g = function0.jit_compile();
+    Halide::Buffer<uint8_t> output2(SIZE, SIZE);
+    success = success && (g({output2}) == 0) && check_buffer(output2, 7);
+
+    // Wrong number of buffers
+    success = success && (f({}) != 0);
+
+    success = success && test_specializer();
+
+    if (!success)
+    {
+        std::cerr << "test_jit failed." << std::endl;
+        return 1;
+    }
+
+    std::cout << "test_jit succeeded." << std::endl;
+
+    return 0;
+}
@@ -60,7 +60,7 @@ int main(int argc, char **argv)
 
     // Some parameters for the search methods
     const int beam_size = 2;
-    const int max_depth = 4;
+    const int max_depth = 7;
 
     const int nb_samples = 5;
     const int topk = 1;
@@ -79,11 +79,22 @@ int main(int argc, char **argv)
     auto_scheduler::search_method *bs = new auto_scheduler::beam_search(beam_size, max_depth, model_eval, scheds_gen);
     auto_scheduler::mcts *mcts = new auto_scheduler::mcts(nb_samples, topk, max_depth, model_eval, exec_eval, scheds_gen);
     
+    // Stop the search after 10 minutes, and return the best schedule found so far
+    auto_scheduler::search_budget budget;
+    budget.max_time = 600;
+    bs->set_budget(budget);
+    
     // Create the autoscheduler and start search
     auto_scheduler::auto_scheduler as(bs, model_eval);
     as.set_exec_evaluator(exec_eval);
+    
+    // Record every evaluated schedule (JSON lines) and print where the tuning time goes
+    as.set_telemetry("search_trace.jsonl");
     as.find_schedule();
     as.apply_best_schedule();
+    
+    // Save the best schedule, so that it can be reused without searching again
+    as.save_best_schedule("schedules.txt");
 
     delete scheds_gen;
     delete exec_eval;
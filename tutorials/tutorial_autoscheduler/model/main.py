@@ -1,5 +1,5 @@
 from os import environ
-import sys, json
+import sys, json, struct
 
 from hier_lstm import Model_hier_LSTM
 from json_to_tensor import *
@@ -28,19 +28,55 @@ with torch.no_grad():
     model.to(device)
     model.eval()
 
+    stdin = sys.stdin.buffer
+    stdout = sys.stdout.buffer
+
+    def read_exact(size):
+        data = stdin.read(size)
+        if len(data) < size:
+            raise EOFError
+        return data
+
+    def read_uint32():
+        return struct.unpack('=I', read_exact(4))[0]
+
+    prog_json = None
+
     try:
         while True:
-            prog_json = input()
-            sched_json = input()
+            frame_type = read_exact(1)
 
-            prog_json = json.loads(prog_json)
-            sched_json = json.loads(sched_json)
+            # The program is sent once, before the schedules that apply to it
+            if frame_type == b'P':
+                prog_json = json.loads(read_exact(read_uint32()).decode())
+                continue
 
-            tree_tensor = get_representation(prog_json, sched_json)
-            
-            speedup = model.forward(tree_tensor)
-            print(float(speedup.item()))
+            # The stream is out of sync, exit so that the autoscheduler restarts the model
+            if frame_type != b'B':
+                raise EOFError
+
+            nb_scheds = read_uint32()
+            scheds_json = [json.loads(read_exact(read_uint32()).decode()) for i in range(nb_scheds)]
+
+            # Schedules with the same tree structure are evaluated in one forward pass
+            groups = dict()
+            for i, sched_json in enumerate(scheds_json):
+                tree_key = json.dumps(sched_json['tree_structure'], sort_keys=True)
+                groups.setdefault(tree_key, []).append(i)
+
+            speedups = [0.0] * nb_scheds
+            for indices in groups.values():
+                reprs = [get_representation(prog_json, scheds_json[i]) for i in indices]
+                prog_tree = reprs[0][0]
+                program_tensor = torch.cat([r[1] for r in reprs], 0)
+
+                out = model.forward((prog_tree, program_tensor))
+                for i, speedup in zip(indices, out.tolist()):
+                    speedups[i] = float(speedup)
+
+            stdout.write(struct.pack('=I', nb_scheds))
+            stdout.write(struct.pack('=%df' % nb_scheds, *speedups))
+            stdout.flush()
             
     except EOFError:
         exit()
-        